@@ -1,17 +1,43 @@
+//other files include application.hpp too, the implementation must only be compiled once
+#define STB_IMAGE_IMPLEMENTATION
 #include "application.hpp"
+#include "sweep.hpp"
 
-int main()
+int main(int argc, char *argv[])
 {
-	Application application;
 	//to enable colored console output, COLORMODE must be defined
 #ifdef COLORMODE
 	enable_virtual_terminal();
 #endif // DEBUG
 
+	//see config.hpp for the options, for example
+	//--headless 500 renders 500 frames offscreen, --sweep-resolutions 64,128,256 benchmarks each resolution
+	//--interactive asks for resolution and wireframe like before, --buoyancy-benchmark --bodies 500 times floating bodies without rendering
+	//--bake waves.seq --frames 600 bakes a loop of displacements, --sequence waves.seq plays it back
+	ApplicationConfig config;
 	//try to run the application
 	try
 	{
-		application.run();
+		config = parse_arguments(argc, argv);
+		if (config.is_sweep())
+		{
+			SweepRunner sweep_runner(config);
+			sweep_runner.run();
+		}
+		else if (config.buoyancy_benchmark)
+		{
+			run_buoyancy_benchmark(config);
+		}
+		else if (!config.bake_path.empty())
+		{
+			bake_displacement_sequence(config);
+		}
+		else
+		{
+			Application application;
+			application.configure(config);
+			application.run();
+		}
 	}
 	//if an error occurs, put out an error message and if build for release exit the application
 	catch (const std::runtime_error &error)
@@ -22,9 +48,13 @@ int main()
 #endif
 	}
 #ifdef _DEBUG
-	//to keep the console open and not to miss the error message wait for input
-	int i;
-	std::cin >> i;
+	flush_log();
+	//to keep the console open and not to miss the error message wait for input, nobody is watching a headless run or a sweep
+	if (!config.headless && !config.is_sweep() && !config.buoyancy_benchmark && config.bake_path.empty())
+	{
+		int i;
+		std::cin >> i;
+	}
 #endif
 	return EXIT_SUCCESS;
 }
@@ -38,57 +68,208 @@ int main()
 //Run the applications lifecycle
 void Application::run()
 {
+	//the profiler records nothing unless a trace was asked for, and every run starts its own
+	Profiler::get().set_enabled(!m_config.trace_path.empty());
+	Profiler::get().reset();
 	configure_application();
-	initialize_window();
-	initialize_vulkan();
-	main_loop();
+	//a sweep goes on with the next configuration, so a failed run must not leave anything behind
+	try
+	{
+		initialize();
+		if (m_config.frame_count > 0)
+		{
+			benchmark_loop();
+		}
+		else
+		{
+			main_loop();
+		}
+	}
+	catch (...)
+	{
+		clean_up();
+		throw;
+	}
 	clean_up();
+
+	if (m_config.parity_check && m_parity_max_error > PARITY_TOLERANCE)
+	{
+		throw std::runtime_error("The vertex shader waves differ from the cpu waves by " + std::to_string(m_parity_max_error) + " of the largest displacement");
+	}
+}
+
+//takes over the options and picks the clock they ask for
+void Application::configure(const ApplicationConfig &config)
+{
+	m_config = config;
+	m_clock = create_clock(config);
+	//ripples, the coarse grid, time slicing, sequences and the loop cache only change the cpu displacement, the gpu simulations never see them
+	std::string cpu_option = m_config.ripple_size > 0 ? "ripples" : m_config.coarse_grid > 1 ? "coarse-grid" : m_config.slice_budget > 0 ? "slice-budget" : !m_config.sequence_path.empty() ? "sequence" : m_config.loop_cache ? "loop-cache" : "";
+	if (!cpu_option.empty() && m_config.simulation == "auto")
+	{
+		m_config.simulation = "cpu";
+	}
+	else if (!cpu_option.empty() && m_config.simulation != "cpu")
+	{
+		warn("The option ", cpu_option, " only changes the cpu simulation, simulation ", m_config.simulation, " ignores it");
+	}
+	m_vertex_simulation = m_config.simulation == "vertex";
+	m_texture_simulation = m_config.simulation == "texture";
+	MemoryTracker::get().set_budget(static_cast<VkDeviceSize>(config.memory_budget_megabytes) * 1024 * 1024);
+	if (m_config.headless)
+	{
+		//nothing gets presented, so the swapchain extension is not needed
+		device_extensions.clear();
+	}
+}
+
+const BenchmarkResult &Application::get_benchmark_result()
+{
+	return m_benchmark_result;
 }
 
-//handles the generation of the ocean surface
+//settles the configuration before anything gets created
 void Application::configure_application()
 {
-	//dont want a dialog every time i need to debug something
-#ifndef _DEBUG
-	std::cout << "Please enter the resolution the plane should have(Power of 2):";
-	std::cin >> m_ocean_resolution;
-	if (m_ocean_resolution <= 1) {
-		throw std::runtime_error("Number is unfit for grid creation");
+	//the dialog only shows up when asked for, benchmarks and sweeps have nobody to answer it
+	if (m_config.interactive && !m_config.headless) {
+		flush_log();
+		std::cout << "Please enter the resolution the plane should have(Power of 2):";
+		std::cin >> m_config.resolution;
+		if (m_config.resolution <= 1) {
+			throw std::runtime_error("Number is unfit for grid creation");
+		}
+		else if (m_config.resolution >= 2048) {
+			std::cout << "This will take ages to generate, are you sure you wanna try?[Y/N]";
+			char c;
+			std::cin >> c;
+			if (tolower(c) != 'y') {
+				info("Probably the right choice");
+				throw std::runtime_error("User aborted execution");
+			}
+		}
+	}
+
+	//a baked sequence brings its own resolution
+	if (!m_config.sequence_path.empty() && m_config.simulation == "cpu")
+	{
+		m_sequence = std::make_unique<DisplacementSequence>(m_config.sequence_path);
+		m_config.resolution = m_sequence->get_resolution();
+	}
+
+	//refuse or shrink planes that would not fit into the budget before generating anything, a sequence can not shrink
+	VkDeviceSize budget = MemoryTracker::get().get_budget();
+	if (budget > 0 && estimate_memory(m_config.resolution) > budget)
+	{
+		if (m_config.memory_budget_policy == "refuse" || m_sequence)
+		{
+			throw std::runtime_error("A resolution of " + std::to_string(m_config.resolution) + " needs about " + std::to_string(estimate_memory(m_config.resolution)) + " bytes, more than the budget of " + std::to_string(budget));
+		}
+		uint32_t requested_resolution = m_config.resolution;
+		while (m_config.resolution > 2 && estimate_memory(m_config.resolution) > budget)
+		{
+			m_config.resolution /= 2;
+		}
+		warn("A resolution of ", requested_resolution, " does not fit into the memory budget, using ", m_config.resolution, " instead");
 	}
-	else if (m_ocean_resolution >= 2048) {
-		std::cout << "This will take ages to generate, are you sure you wanna try?[Y/N]";
+
+	m_benchmark_result.resolution = m_config.resolution;
+
+	//the pipeline is built while the ocean is generated, so ask before either starts
+	if (m_config.interactive && !m_config.headless) {
+		flush_log();
+		std::cout << "Would you like to display the wave as wireframe?[Y/N]" << std::endl;
 		char c;
 		std::cin >> c;
-		if (tolower(c) != 'y') {
-			info("Probably the right choice");
-			throw std::runtime_error("User aborted execution");
-		}
+		m_config.wireframe = tolower(c) == 'y';
 	}
-#endif // !_DEBUG
+}
 
-	m_ocean = new Ocean(m_ocean_resolution, m_ocean_resolution);
-	m_vertices = m_ocean->getVertices();
-	//TODO: generate first displacement map here
-	for (Vertex vert : m_vertices) {
-		m_displacements.push_back({ { (float)rand() / (float)RAND_MAX, rand() / (float)RAND_MAX, (float)rand() / RAND_MAX } });
+//handles the generation of the ocean surface, runs on a worker thread during startup
+void Application::generate_ocean()
+{
+	PROFILE_FUNCTION();
+	m_ocean = new Ocean(m_config.resolution, m_config.resolution, m_config.wave_count, create_spectrum_parameters(m_config));
+	//the maps cover the plane once and wrap around, a wave that does not fit a whole number of times would leave a seam
+	if (m_texture_simulation)
+	{
+		m_ocean->snap_waves_to_tile(static_cast<float>(m_config.resolution));
+	}
+	if (m_config.loop_period > 0.0f)
+	{
+		m_ocean->force_loop_period(m_config.loop_period);
+	}
+	//the parity check compares against the full cpu waves
+	if (m_config.simulation == "cpu")
+	{
+		m_ocean->set_coarse_factor(m_config.coarse_grid);
+		//six updates of the whole grid, only paid for when asked
+		if (m_config.coarse_grid_report)
+		{
+			m_ocean->report_coarse_grid();
+		}
+	}
+	if (m_config.simulation == "cpu" && m_config.loop_cache)
+	{
+		float period = m_ocean->find_loop_period();
+		if (period > 0.0f)
+			m_ocean->fill_frame_cache(period, m_config.loop_frame_rate, static_cast<size_t>(m_config.loop_cache_megabytes) * 1024 * 1024);
+		else
+			warn("The waves do not repeat within 10 minutes, nothing to cache, a loop period makes them");
 	}
+	m_vertices = m_ocean->getVertices();
+	//the first frame is uploaded before anything was simulated, the cpu simulation starts from the waves at time 0,
+	//every other simulation starts flat until its first result arrives
+	if (m_config.simulation == "cpu" && !m_sequence)
+		m_displacements = m_ocean->update_waves(0.0f);
+	else
+		m_displacements.assign(m_vertices.size(), Displacement{ glm::vec3(0.0f) });
 	m_indices = m_ocean->getIndices();
+	track_host_copies();
 
-	//
-#ifndef _DEBUG
-	std::cout << "Would you like to display the wave as wireframe?[Y/N]" << std::endl;
-	char c;
-	std::cin >> c;
-	if (tolower(c) != 'y') {
-		m_enable_wireframe = false;
+	if (m_config.bodies > 0)
+	{
+		m_buoyancy = std::make_unique<BuoyancySimulation>(m_ocean);
+		m_buoyancy->add_test_bodies(m_config.bodies, static_cast<float>(m_config.resolution), m_config.seed);
+	}
+	if (m_config.slice_budget > 0)
+	{
+		m_time_sliced = std::make_unique<TimeSlicedWaves>(m_ocean, m_config.slice_budget);
+	}
+	if (m_config.ripple_size > 0)
+	{
+		m_ripples = std::make_unique<RippleField>(m_config.ripple_size);
 	}
-#endif // !_DEBUG
+}
+
+//vertex, index and displacement data exist a few times over, in the ocean, in the application and on the device
+size_t Application::estimate_memory(uint32_t resolution)
+{
+	size_t vertex_count = static_cast<size_t>(resolution) * resolution;
+	size_t index_count = static_cast<size_t>(resolution - 1) * (resolution - 1) * 6;
+	size_t vertex_bytes = vertex_count * sizeof(Vertex);
+	size_t index_bytes = index_count * sizeof(uint32_t);
+	size_t displacement_bytes = vertex_count * sizeof(Displacement);
+
+	//ocean and application keep a copy each, update_waves has a few displacement vectors alive at once
+	size_t host_bytes = 2 * vertex_bytes + 2 * index_bytes + 4 * displacement_bytes;
+	//the compute path keeps two displacement buffers, the uploads go through staging memory
+	size_t device_bytes = vertex_bytes + index_bytes + 2 * displacement_bytes + vertex_bytes + index_bytes;
+	return host_bytes + device_bytes;
+}
+
+void Application::track_host_copies()
+{
+	MemoryTracker &tracker = MemoryTracker::get();
+	tracker.set_host_bytes("Application vertices", MemoryCategory::mesh, m_vertices.capacity() * sizeof(Vertex));
+	tracker.set_host_bytes("Application indices", MemoryCategory::mesh, m_indices.capacity() * sizeof(uint32_t));
+	tracker.set_host_bytes("Application displacements", MemoryCategory::displacement, m_displacements.capacity() * sizeof(Displacement));
+	m_ocean->track_host_copies();
 }
 
 //get a window going using glfw
 void Application::initialize_window()
 {
-	glfwInit();
 	//dont use openGL
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	//be resizable
@@ -99,39 +280,124 @@ void Application::initialize_window()
 	//store a reference to the application
 	glfwSetWindowUserPointer(m_window, this);
 	glfwSetWindowSizeCallback(m_window, Application::on_window_resized);
+	glfwSetKeyCallback(m_window, Application::on_key_pressed);
 }
 
-//set up everything thats needed to render an image using vulkan
-void Application::initialize_vulkan()
+//set up the window and everything thats needed to render an image using vulkan
+//the steps run as a task graph, ocean generation and the vulkan chain overlap
+//and are only joined where the buffers need the generated mesh
+void Application::initialize()
 {
+	PROFILE_FUNCTION();
 	info("Initializing Vulkan...");
-	create_instance();
-	setup_debug_callback();
-	create_surface();
-	pick_physical_device();
-	create_logical_device();
-	create_swapchain();
-	create_image_views();
-	create_render_pass();
-	create_descriptor_set_layout();
-	create_graphics_pipeline();
-	create_framebuffers();
-	create_command_pool();
+	TaskGraph graph;
+	std::vector<TaskGraph::TaskId> instance_dependencies;
+	std::vector<TaskGraph::TaskId> device_dependencies;
+	if (!m_config.headless)
+	{
+		//glfw wants its window handled on the main thread
+		TaskGraph::TaskId glfw = graph.add("Initialize glfw", []() { glfwInit(); }, {}, true);
+		TaskGraph::TaskId window = graph.add("Create window", [this]() { initialize_window(); }, { glfw }, true);
+		instance_dependencies.push_back(glfw);
+		device_dependencies.push_back(window);
+	}
+
+	TaskGraph::TaskId ocean = graph.add("Generate ocean", [this]() { generate_ocean(); });
+
+	TaskGraph::TaskId instance = graph.add("Create instance", [this]()
+	{
+		create_instance();
+		setup_debug_callback();
+	}, instance_dependencies);
+
+	device_dependencies.push_back(instance);
+	TaskGraph::TaskId device = graph.add("Create device", [this]()
+	{
+		if (!m_config.headless)
+		{
+			create_surface();
+		}
+		pick_physical_device();
+		create_logical_device();
+		create_memory_allocator();
+	}, device_dependencies);
+
+	//the extent can come from the window size, which glfw only hands out on the main thread
+	TaskGraph::TaskId swapchain = graph.add("Create swapchain", [this]()
+	{
+		if (m_config.headless)
+		{
+			create_offscreen_images();
+		}
+		else
+		{
+			create_swapchain();
+		}
+		create_image_views();
+		create_render_pass();
+		create_descriptor_set_layout();
+		create_pipeline_layout();
+		create_pipeline_cache();
+		create_framebuffers();
+		create_command_pool();
+	}, { device }, !m_config.headless);
+
+	//the vertex simulation bakes the wave count into the pipeline, so it has to wait for the ocean
+	std::vector<TaskGraph::TaskId> pipeline_dependencies = { swapchain };
+	if (m_vertex_simulation)
+	{
+		pipeline_dependencies.push_back(ocean);
+	}
+	graph.add("Build pipeline", [this]() { create_graphics_pipeline(); }, pipeline_dependencies);
+
+	//the only place the generated mesh is needed
+	graph.add("Create buffers", [this]()
+	{
+		//create_texture_image();
+		//create_texture_image_view();
+		//create_texture_sampler();
+
+		create_vertex_buffer();
+		create_index_buffer();
+
+		create_ocean_compute();
+		if (!m_gpu_simulation)
+		{
+			create_displacement_buffer();
+		}
+		create_wave_buffer();
+		create_ocean_texture();
 
-	//create_texture_image();
-	//create_texture_image_view();
-	//create_texture_sampler();
+		//the uploads run on their own while the rest gets initialized, the first frame waits for them
+		m_upload_batcher.submit();
 
-	create_vertex_buffer();
-	create_index_buffer();
+		create_uniform_buffer();
+		create_descriptor_pool();
+		create_descriptor_set();
+		create_command_buffers();
+		create_sync_objects();
 
-	create_displacement_buffer();
+		//timestamps around the frame on the graphics queue
+		m_gpu_timer.initialize(m_physical_device, m_logical_device, m_queue_family_indices.graphics_family, "GPU graphics queue");
+		//benchmarks report the gpu frame time whether or not a trace is written
+		m_gpu_timer.set_always_measure(m_config.frame_count > 0);
+	}, { swapchain, ocean });
 
-	create_uniform_buffer();
-	create_descriptor_pool();
-	create_descriptor_set();
-	create_command_buffers();
-	create_semaphores();
+	graph.run();
+	graph.print_critical_path();
+
+	//benchmarks should not change their shaders halfway through
+	if (m_config.hot_reload && !m_config.headless && m_config.frame_count == 0)
+	{
+		start_shader_reloading();
+	}
+#ifdef _DEBUG
+	m_memory_allocator.print_statistics();
+#endif
+	if (m_config.memory_report)
+	{
+		MemoryTracker::get().print_report();
+	}
 	succ("Vulkan Initialized");
 }
 
@@ -140,22 +406,115 @@ void Application::main_loop()
 {
 	while (!glfwWindowShouldClose(m_window))
 	{
+		PROFILE_ZONE("frame");
 		glfwPollEvents();
-		//TODO: update goes here
-		update_buffers();
-		draw_frame();
-		m_displacements = m_ocean->update_waves(m_time);
-		//wait until everything is done
-		vkQueueWaitIdle(m_presentation_queue);
+		run_frame();
+		if (m_memory_report_requested)
+		{
+			m_memory_report_requested = false;
+			track_host_copies();
+			MemoryTracker::get().print_report();
+			m_memory_allocator.print_statistics();
+		}
 	}
 	vkDeviceWaitIdle(m_logical_device);
 }
 
+//updates, draws and starts simulating the next frame
+void Application::run_frame()
+{
+	//release staging memory of finished uploads
+	m_upload_batcher.poll();
+	//the uniform and displacement buffers are written next, the last frame has to be done reading them,
+	//the simulation of the next displacement after draw_frame still overlaps with the gpu
+	vkWaitForFences(m_logical_device, 1, &m_in_flight_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	float previous_time = m_time;
+	update_buffers();
+	//the bodies follow the waves of the frame that is about to be drawn
+	if (m_buoyancy)
+	{
+		m_buoyancy->step(m_time, m_time - previous_time);
+	}
+	draw_frame();
+	//the next displacement is simulated while the gpu is still busy with this frame
+	if (m_gpu_simulation)
+	{
+		m_ocean_compute.dispatch(m_time, m_wave_lod);
+	}
+	else if (!m_vertex_simulation && !m_texture_simulation && !m_sequence)
+	{
+		if (m_time_sliced)
+			m_time_sliced->update(m_time, m_time - previous_time, m_wave_lod, m_displacements);
+		else
+			m_displacements = m_ocean->update_waves(m_time, m_wave_lod);
+		if (m_ripples)
+		{
+			update_ripples(m_time - previous_time);
+		}
+	}
+}
+
+//the patch stays on the water closest to the camera, bodies moving up and down in it leave wakes
+void Application::update_ripples(float delta_time)
+{
+	PROFILE_FUNCTION();
+	float resolution = static_cast<float>(m_ocean->resolution);
+	//the whole patch stays on the grid, a camera off to the side would otherwise waste most of it on cells that are never drawn,
+	//a patch larger than the grid just starts at its corner
+	float size = static_cast<float>(m_ripples->get_size());
+	float half_size = floorf(0.5f * size);
+	float highest_center = std::max(half_size, resolution - size + half_size);
+	m_ripples->follow(glm::vec2(glm::clamp(m_wave_lod.camera.x, half_size, highest_center), glm::clamp(m_wave_lod.camera.y, half_size, highest_center)));
+
+	if (m_buoyancy)
+	{
+		for (size_t body = 0; body < m_buoyancy->get_body_count(); body++)
+		{
+			//the world is centered on the grid, see Ocean::create_surface_query
+			glm::vec3 position = m_buoyancy->get_position(body);
+			m_ripples->disturb(glm::vec2(position.x, position.y) + glm::vec2(0.5f * resolution), 2.0f, m_buoyancy->get_velocity(body).z * -delta_time);
+		}
+	}
+	if (m_splash_requested)
+	{
+		m_splash_requested = false;
+		glm::ivec2 origin = m_ripples->get_origin();
+		m_ripples->disturb(glm::vec2(origin.x + random(size), origin.y + random(size)), 4.0f, 2.0f);
+	}
+
+	m_ripples->step(delta_time);
+	m_ripples->add_to(m_displacements, m_ocean->resolution);
+}
+
+void Application::check_parity()
+{
+	PROFILE_FUNCTION();
+	vkWaitForFences(m_logical_device, 1, &m_in_flight_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	//no wave moves a vertex further than its amplitude, horizontally scaled by its steepness
+	float largest_displacement = 0.0f;
+	for (const GerstnerParameters &wave : m_ocean->get_wave_parameters())
+	{
+		largest_displacement += wave.amplitude * std::max(1.0f, wave.steepness);
+	}
+
+	std::vector<Displacement> expected = m_ocean->update_waves(m_time, m_wave_lod);
+	const Displacement *evaluated = static_cast<const Displacement *>(m_parity_allocation.mapped);
+	float max_error = 0.0f;
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		glm::vec3 difference = evaluated[i].displacement - expected[i].displacement;
+		max_error = std::max({ max_error, std::abs(difference.x), std::abs(difference.y), std::abs(difference.z) });
+	}
+	m_parity_max_error = std::max(m_parity_max_error, max_error / std::max(largest_displacement, 1.0f));
+}
+
 #pragma region Initialization
 
 //creates a vulkan instance
 void Application::create_instance()
 {
+	PROFILE_FUNCTION();
 	info("Creating Vulkan instance...");
 	//Check if debug mode is active and check if the validation layers are supported
 	if (enableValidationLayers && !check_validation_layer_support())
@@ -195,7 +554,8 @@ void Application::create_instance()
 		create_information.enabledLayerCount = 0;
 	}
 
-	if (vkCreateInstance(&create_information, nullptr, &m_instance) != VK_SUCCESS)
+	//the driver reports its host allocations of the instance and the device to the memory tracker
+	if (vkCreateInstance(&create_information, MemoryTracker::get().get_allocation_callbacks(), &m_instance) != VK_SUCCESS)
 	{
 		throw std::runtime_error("VK_INSTANCE creation failed");
 	}
@@ -294,6 +654,7 @@ bool Application::check_validation_layer_support()
 //selects the most suitable device to render on
 void Application::pick_physical_device()
 {
+	PROFILE_FUNCTION();
 	info("Picking physical device...");
 
 	//check if a device is present
@@ -326,7 +687,7 @@ void Application::pick_physical_device()
 		VkPhysicalDeviceProperties device_properties;
 		vkGetPhysicalDeviceProperties(m_physical_device, &device_properties);
 
-		succ(std::string("Selected ") + device_properties.deviceName);
+		succ("Selected ", device_properties.deviceName);
 #endif
 	}
 
@@ -340,6 +701,7 @@ void Application::pick_physical_device()
 //get the window surface from glfw
 void Application::create_surface()
 {
+	PROFILE_FUNCTION();
 	info("Creating Surface...");
 	if (glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface) != VK_SUCCESS)
 	{
@@ -351,13 +713,15 @@ void Application::create_surface()
 //create a logical device to interface with the actual gpu
 void Application::create_logical_device()
 {
+	PROFILE_FUNCTION();
 	info("Creating logical device...");
 	//redo the indices, selected device might be different than last checked one after all
-	QueueFamilyIndices indices = find_queue_families(m_physical_device);
+	m_queue_family_indices = find_queue_families(m_physical_device);
+	QueueFamilyIndices indices = m_queue_family_indices;
 
 	//TODO: outsource queue creation and queue stuff in some kind of queue manager
 	std::vector<VkDeviceQueueCreateInfo> queue_create_informations;
-	std::set<int> unique_queue_families = { indices.graphics_family, indices.presentation_family };
+	std::set<int> unique_queue_families = { indices.graphics_family, indices.presentation_family, indices.transfer_family, indices.compute_family };
 
 	float queue_priority = 1.0f;
 	for (int queue_family : unique_queue_families)
@@ -373,10 +737,36 @@ void Application::create_logical_device()
 	VkPhysicalDeviceFeatures device_features = {};
 	//TODO: Wireframe happens here
 	device_features.fillModeNonSolid = VK_TRUE;
-	//also enable texture sampling
-	device_features.samplerAnisotropy = VK_TRUE;
+	//optional features are only asked for if the device has them
+	VkPhysicalDeviceFeatures available_features;
+	vkGetPhysicalDeviceFeatures(m_physical_device, &available_features);
+	//anisotropic filtering, the samplers do without otherwise
+	if (available_features.samplerAnisotropy && m_config.anisotropy > 1.0f)
+	{
+		VkPhysicalDeviceProperties device_properties;
+		vkGetPhysicalDeviceProperties(m_physical_device, &device_properties);
+		device_features.samplerAnisotropy = VK_TRUE;
+		m_max_anisotropy = std::min(m_config.anisotropy, device_properties.limits.maxSamplerAnisotropy);
+		info("\tSampling with up to ", m_max_anisotropy, "x anisotropic filtering");
+	}
 	//geometry shader
 	device_features.geometryShader = VK_TRUE;
+	//the parity check build of the vertex shader writes to a storage buffer
+	if (m_config.parity_check)
+	{
+		if (!available_features.vertexPipelineStoresAndAtomics)
+		{
+			throw std::runtime_error("The parity check needs vertexPipelineStoresAndAtomics, which the device does not support");
+		}
+		device_features.vertexPipelineStoresAndAtomics = VK_TRUE;
+	}
+
+	//heap budgets are nice to have, not required
+	m_memory_budget_enabled = m_physical_device_properties_2_enabled && is_device_extension_supported(m_physical_device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (m_memory_budget_enabled)
+	{
+		device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
 
 	//fill in the struct so the creation function knows what is needed
 	VkDeviceCreateInfo logical_device_create_info = {};
@@ -395,23 +785,35 @@ void Application::create_logical_device()
 		logical_device_create_info.ppEnabledLayerNames = validation_layers.data();
 	}
 
-	if (vkCreateDevice(m_physical_device, &logical_device_create_info, nullptr, &m_logical_device) != VK_SUCCESS)
+	if (vkCreateDevice(m_physical_device, &logical_device_create_info, MemoryTracker::get().get_allocation_callbacks(), &m_logical_device) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to create logical device");
 	}
 
 	//retrieve created queues
-	//single queue, therefore index 0
+	//single queue per family, therefore index 0, transfer and compute might be the graphics queue if there is no dedicated one
 	vkGetDeviceQueue(m_logical_device, indices.graphics_family, 0, &m_graphics_queue);
-	//single queue, therefore index 0
 	vkGetDeviceQueue(m_logical_device, indices.presentation_family, 0, &m_presentation_queue);
+	vkGetDeviceQueue(m_logical_device, indices.transfer_family, 0, &m_transfer_queue);
+	vkGetDeviceQueue(m_logical_device, indices.compute_family, 0, &m_compute_queue);
+
+	MemoryTracker::get().initialize(m_instance, m_physical_device, m_memory_budget_enabled);
 
 	succ("Logical Device creation Successful!");
 }
 
+//sets up the sub allocator all buffers and images get their memory from
+void Application::create_memory_allocator()
+{
+	PROFILE_FUNCTION();
+	m_memory_allocator.initialize(m_physical_device, m_logical_device);
+	m_upload_batcher.initialize(m_logical_device, &m_memory_allocator, m_queue_family_indices.transfer_family, m_transfer_queue);
+}
+
 //this will create the swaochain
 void Application::create_swapchain()
 {
+	PROFILE_FUNCTION();
 	info("Creating Swapchain...");
 	//use helper functions to gather information needed for the swapchain creation
 	SwapChainSupportDetails swapchain_support = query_swapchain_support(m_physical_device);
@@ -458,13 +860,21 @@ void Application::create_swapchain()
 	create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	create_info.presentMode = present_mode;
 	create_info.clipped = VK_TRUE;
-	create_info.oldSwapchain = VK_NULL_HANDLE;
+	//hand over the current swapchain, if there is one, so the driver can reuse its resources
+	VkSwapchainKHR old_swapchain = m_swapchain;
+	create_info.oldSwapchain = old_swapchain;
 
 	if (vkCreateSwapchainKHR(m_logical_device, &create_info, nullptr, &m_swapchain) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Swapchain creation failed");
 	}
 
+	//the old swapchain is retired now and can be destroyed
+	if (old_swapchain != VK_NULL_HANDLE)
+	{
+		vkDestroySwapchainKHR(m_logical_device, old_swapchain, nullptr);
+	}
+
 	//After creating the swapchain get the images
 	vkGetSwapchainImagesKHR(m_logical_device, m_swapchain, &image_count, nullptr);
 	m_swapchain_images.resize(image_count);
@@ -479,6 +889,7 @@ void Application::create_swapchain()
 //create image views for the swapchain images
 void Application::create_image_views()
 {
+	PROFILE_FUNCTION();
 	info("Creating image views...");
 	m_swapchain_image_views.resize(m_swapchain_images.size());
 	for (size_t i = 0; i < m_swapchain_images.size(); i++)
@@ -492,6 +903,7 @@ void Application::create_image_views()
 //it tells vulkan which kind of buffers and images we work with
 void Application::create_render_pass()
 {
+	PROFILE_FUNCTION();
 	info("Creating Render Pass...");
 	VkAttachmentDescription color_attachment_description = {};
 	color_attachment_description.format = m_swapchain_image_format;
@@ -502,7 +914,8 @@ void Application::create_render_pass()
 	color_attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	color_attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	color_attachment_description.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment_description.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	//offscreen images are not presented but might be copied out
+	color_attachment_description.finalLayout = m_config.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference color_attachment_reference = {};
 	//index of color attachment description
@@ -547,6 +960,7 @@ void Application::create_render_pass()
 //this tells vulkan where it can find which descriptor
 void Application::create_descriptor_set_layout()
 {
+	PROFILE_FUNCTION();
 	info("Creating descriptor set layout...");
 
 	//configure uniform buffer layout binding
@@ -554,9 +968,10 @@ void Application::create_descriptor_set_layout()
 	ubo_layout_binding.binding = 0;
 	ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	ubo_layout_binding.descriptorCount = 1;
-	ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	//the fragment shader turns the sampled normals into view space
+	ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 	ubo_layout_binding.pImmutableSamplers = nullptr;
-	//configure texture sampler layout binding
+	//configure texture sampler layout binding, the normal map of the texture simulation
 	VkDescriptorSetLayoutBinding sampler_layout_binding = {};
 	sampler_layout_binding.binding = 1;
 	sampler_layout_binding.descriptorCount = 1;
@@ -564,8 +979,27 @@ void Application::create_descriptor_set_layout()
 	sampler_layout_binding.pImmutableSamplers = nullptr;
 	sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+	//the waves the vertex shader evaluates
+	VkDescriptorSetLayoutBinding wave_layout_binding = {};
+	wave_layout_binding.binding = 2;
+	wave_layout_binding.descriptorCount = 1;
+	wave_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	wave_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	//the displacement map of the texture simulation
+	VkDescriptorSetLayoutBinding displacement_map_layout_binding = sampler_layout_binding;
+	displacement_map_layout_binding.binding = 4;
+	displacement_map_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
 	//create the descriptor layout
-	std::array<VkDescriptorSetLayoutBinding, 2> bindings = { ubo_layout_binding, sampler_layout_binding };
+	std::vector<VkDescriptorSetLayoutBinding> bindings = { ubo_layout_binding, sampler_layout_binding, wave_layout_binding, displacement_map_layout_binding };
+	//where the parity check build of the vertex shader writes what it evaluated
+	if (m_config.parity_check)
+	{
+		VkDescriptorSetLayoutBinding parity_layout_binding = wave_layout_binding;
+		parity_layout_binding.binding = 3;
+		bindings.push_back(parity_layout_binding);
+	}
 
 	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
 	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -579,23 +1013,151 @@ void Application::create_descriptor_set_layout()
 	succ("Descriptor set layout created");
 }
 
-//sets up each step of the graphics pipeline and creates the graphics pipeline itself
+//configure the pipeline layout to use the uniform buffer and texture sampler at a later point
+//the layout only depends on the descriptor set layout, so it survives swapchain recreation
+void Application::create_pipeline_layout()
+{
+	PROFILE_FUNCTION();
+	info("Creating pipeline layout...");
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &m_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 0;
+	pipeline_layout_create_info.pPushConstantRanges = nullptr;
+
+	if (vkCreatePipelineLayout(m_logical_device, &pipeline_layout_create_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Pipeline layout creation failed");
+	}
+	succ("Pipeline layout created");
+}
+
+//creates the graphics pipeline the frames are drawn with
 void Application::create_graphics_pipeline()
 {
+	PROFILE_FUNCTION();
 	info("Creating graphics pipeline...");
+	std::lock_guard<std::mutex> lock(m_pipeline_mutex);
+	m_graphics_pipeline = build_graphics_pipeline({ m_config.parity_check ? EMBEDDED_VERT_PARITY_SHADER : EMBEDDED_VERT_SHADER, EMBEDDED_GEOM_SHADER, EMBEDDED_FRAG_SHADER });
+	succ("Created graphics pipeline");
+}
 
-	//setting up shader modules
-	std::vector<char> vert_shader_code = read_file("shaders/vert.spv");
-	std::vector<char> geom_shader_code = read_file("shaders/geom.spv");
-	std::vector<char> frag_shader_code = read_file("shaders/frag.spv");
+//picks up the pipeline cache of the last run if there is one
+void Application::create_pipeline_cache()
+{
+	PROFILE_FUNCTION();
+	std::vector<char> cache_data;
+	std::ifstream cache_file(PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+	if (cache_file.is_open())
+	{
+		cache_data.resize(static_cast<size_t>(cache_file.tellg()));
+		cache_file.seekg(0);
+		cache_file.read(cache_data.data(), cache_data.size());
+	}
+
+	//the driver checks the header itself and ignores data of another device or driver version
+	VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+	pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipeline_cache_create_info.initialDataSize = cache_data.size();
+	pipeline_cache_create_info.pInitialData = cache_data.empty() ? nullptr : cache_data.data();
+
+	if (vkCreatePipelineCache(m_logical_device, &pipeline_cache_create_info, nullptr, &m_pipeline_cache) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Pipeline cache creation failed");
+	}
+}
+
+//writes the pipeline cache for the next run
+void Application::save_pipeline_cache()
+{
+	size_t cache_size = 0;
+	vkGetPipelineCacheData(m_logical_device, m_pipeline_cache, &cache_size, nullptr);
+	std::vector<char> cache_data(cache_size);
+	if (cache_size == 0 || vkGetPipelineCacheData(m_logical_device, m_pipeline_cache, &cache_size, cache_data.data()) != VK_SUCCESS)
+		return;
+
+	std::ofstream cache_file(PIPELINE_CACHE_PATH, std::ios::binary);
+	cache_file.write(cache_data.data(), cache_size);
+}
+
+//rebuilt pipelines are swapped in by draw_frame, they are built with the same specialization constants as at startup
+void Application::start_shader_reloading()
+{
+	//the sources are compiled into the variant the run uses, the embedded shaders were built the same way
+	if (m_config.parity_check)
+	{
+		m_shader_reloader.set_defines(".vert", { "WRITE_DISPLACEMENT" });
+	}
+	if (m_texture_simulation)
+	{
+		m_shader_reloader.set_defines(".comp", { "TEXTURE_OUTPUT" });
+	}
+
+	m_graphics_reload = m_shader_reloader.add_pipeline({ "vert.spv", "geom.spv", "frag.spv" }, [this]()
+	{
+		//stages compiled since the watcher started come from disk, the rest stay embedded,
+		//the .spv files on disk may be older than the sources the binary was built from
+		std::vector<char> vert_shader_code;
+		std::vector<char> geom_shader_code;
+		std::vector<char> frag_shader_code;
+		GraphicsShaderCode code = { m_config.parity_check ? EMBEDDED_VERT_PARITY_SHADER : EMBEDDED_VERT_SHADER, EMBEDDED_GEOM_SHADER, EMBEDDED_FRAG_SHADER };
+		if (m_shader_reloader.has_changed("vert.spv"))
+		{
+			vert_shader_code = read_file("shaders/vert.spv");
+			code.vert = { reinterpret_cast<const uint32_t *>(vert_shader_code.data()), vert_shader_code.size() };
+		}
+		if (m_shader_reloader.has_changed("geom.spv"))
+		{
+			geom_shader_code = read_file("shaders/geom.spv");
+			code.geom = { reinterpret_cast<const uint32_t *>(geom_shader_code.data()), geom_shader_code.size() };
+		}
+		if (m_shader_reloader.has_changed("frag.spv"))
+		{
+			frag_shader_code = read_file("shaders/frag.spv");
+			code.frag = { reinterpret_cast<const uint32_t *>(frag_shader_code.data()), frag_shader_code.size() };
+		}
+		std::lock_guard<std::mutex> lock(m_pipeline_mutex);
+		return build_graphics_pipeline(code);
+	});
+
+	//only the simulations running a compute shader have a pipeline to rebuild
+	if (m_gpu_simulation || m_texture_simulation)
+	{
+		m_compute_reload = m_shader_reloader.add_pipeline({ "comp.spv" }, [this]()
+		{
+			std::vector<char> comp_shader_code = read_file("shaders/comp.spv");
+			VkShaderModule comp_shader_module = create_shader_module({ reinterpret_cast<const uint32_t *>(comp_shader_code.data()), comp_shader_code.size() });
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			try
+			{
+				pipeline = m_gpu_simulation ? m_ocean_compute.build_pipeline(comp_shader_module) : m_ocean_texture.build_pipeline(comp_shader_module);
+			}
+			catch (const std::runtime_error &)
+			{
+				vkDestroyShaderModule(m_logical_device, comp_shader_module, nullptr);
+				throw;
+			}
+			vkDestroyShaderModule(m_logical_device, comp_shader_module, nullptr);
+			return pipeline;
+		});
+	}
 
+	m_shader_reloader.start(m_logical_device, "shaders");
+}
+
+//sets up each step of the graphics pipeline and builds it from the given shaders
+VkPipeline Application::build_graphics_pipeline(const GraphicsShaderCode &code)
+{
+	PROFILE_FUNCTION();
+	//setting up shader modules
 	VkShaderModule vert_shader_module;
 	VkShaderModule geom_shader_module;
 	VkShaderModule frag_shader_module;
 
-	vert_shader_module = create_shader_module(vert_shader_code);
-	geom_shader_module = create_shader_module(geom_shader_code);
-	frag_shader_module = create_shader_module(frag_shader_code);
+	vert_shader_module = create_shader_module(code.vert);
+	geom_shader_module = create_shader_module(code.geom);
+	frag_shader_module = create_shader_module(code.frag);
 
 	//create vertex shader stage
 	VkPipelineShaderStageCreateInfo vert_shader_stage_info = {};
@@ -604,6 +1166,23 @@ void Application::create_graphics_pipeline()
 	vert_shader_stage_info.module = vert_shader_module;
 	vert_shader_stage_info.pName = "main";
 
+	VertexSpecialization vertex_specialization = {};
+	vertex_specialization.evaluate_waves = m_vertex_simulation ? VK_TRUE : VK_FALSE;
+	vertex_specialization.wave_count = m_vertex_simulation ? static_cast<uint32_t>(m_ocean->get_wave_parameters().size()) : 0;
+	vertex_specialization.resolution = m_config.resolution;
+	vertex_specialization.sample_texture = m_texture_simulation ? VK_TRUE : VK_FALSE;
+	std::array<VkSpecializationMapEntry, 4> vertex_specialization_entries = {};
+	vertex_specialization_entries[0] = { 0, offsetof(VertexSpecialization, evaluate_waves), sizeof(VkBool32) };
+	vertex_specialization_entries[1] = { 1, offsetof(VertexSpecialization, wave_count), sizeof(uint32_t) };
+	vertex_specialization_entries[2] = { 2, offsetof(VertexSpecialization, resolution), sizeof(uint32_t) };
+	vertex_specialization_entries[3] = { 3, offsetof(VertexSpecialization, sample_texture), sizeof(VkBool32) };
+	VkSpecializationInfo vert_specialization_info = {};
+	vert_specialization_info.mapEntryCount = static_cast<uint32_t>(vertex_specialization_entries.size());
+	vert_specialization_info.pMapEntries = vertex_specialization_entries.data();
+	vert_specialization_info.dataSize = sizeof(VertexSpecialization);
+	vert_specialization_info.pData = &vertex_specialization;
+	vert_shader_stage_info.pSpecializationInfo = &vert_specialization_info;
+
 	//create geometry shader stage
 	VkPipelineShaderStageCreateInfo geom_shader_stage_info = {};
 	geom_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -618,6 +1197,20 @@ void Application::create_graphics_pipeline()
 	frag_shader_stage_info.module = frag_shader_module;
 	frag_shader_stage_info.pName = "main";
 
+	//the shading mode is a specialization constant, the branch not taken is compiled away
+	FragmentSpecialization fragment_specialization = {};
+	fragment_specialization.shading_mode = m_config.shading == "normals" ? ShadingMode::normals : ShadingMode::lit;
+	fragment_specialization.sample_normals = m_texture_simulation ? VK_TRUE : VK_FALSE;
+	std::array<VkSpecializationMapEntry, 2> fragment_specialization_entries = {};
+	fragment_specialization_entries[0] = { 0, offsetof(FragmentSpecialization, shading_mode), sizeof(ShadingMode) };
+	fragment_specialization_entries[1] = { 1, offsetof(FragmentSpecialization, sample_normals), sizeof(VkBool32) };
+	VkSpecializationInfo frag_specialization_info = {};
+	frag_specialization_info.mapEntryCount = static_cast<uint32_t>(fragment_specialization_entries.size());
+	frag_specialization_info.pMapEntries = fragment_specialization_entries.data();
+	frag_specialization_info.dataSize = sizeof(FragmentSpecialization);
+	frag_specialization_info.pData = &fragment_specialization;
+	frag_shader_stage_info.pSpecializationInfo = &frag_specialization_info;
+
 	VkPipelineShaderStageCreateInfo shader_stages[] = { vert_shader_stage_info, geom_shader_stage_info, frag_shader_stage_info };
 
 	//set up vertex input
@@ -625,6 +1218,11 @@ void Application::create_graphics_pipeline()
 	auto vertex_attribute_descriptions = Vertex::get_attribute_descriptions();
 
 	auto displacement_binding_descriptions = Displacement::get_binding_description();
+	//the displacement is not read per vertex if the vertex shader evaluates or samples it, a single zero is enough then
+	if (m_vertex_simulation || m_texture_simulation)
+	{
+		displacement_binding_descriptions.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+	}
 	auto displacement_attribute_descriptions = Displacement::get_attribute_descriptions();
 
 	std::vector<VkVertexInputBindingDescription> input_binding_descriptions = { vertex_binding_descriptions, displacement_binding_descriptions };
@@ -650,24 +1248,13 @@ void Application::create_graphics_pipeline()
 	input_assembly_state_create_info.primitiveRestartEnable = VK_FALSE;
 
 	//set up the viewport
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float)m_swapchain_extent.width;
-	viewport.height = (float)m_swapchain_extent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = m_swapchain_extent;
-
+	//viewport and scissor are dynamic states and get set while recording, so the pipeline does not depend on the window size
 	VkPipelineViewportStateCreateInfo viewport_state_create_info = {};
 	viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewport_state_create_info.viewportCount = 1;
-	viewport_state_create_info.pViewports = &viewport;
+	viewport_state_create_info.pViewports = nullptr;
 	viewport_state_create_info.scissorCount = 1;
-	viewport_state_create_info.pScissors = &scissor;
+	viewport_state_create_info.pScissors = nullptr;
 
 	//Set up rasterization
 	VkPipelineRasterizationStateCreateInfo rasterization_state_create_info = {};
@@ -675,7 +1262,7 @@ void Application::create_graphics_pipeline()
 	rasterization_state_create_info.depthClampEnable = VK_FALSE;
 	rasterization_state_create_info.rasterizerDiscardEnable = VK_FALSE;
 	//TODO: this is where you wireframe, REQUIRES A GPU FEATURE
-	rasterization_state_create_info.polygonMode = (m_enable_wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL);
+	rasterization_state_create_info.polygonMode = (m_config.wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL);
 	rasterization_state_create_info.lineWidth = 1.0f;
 	rasterization_state_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
 	//has to be counter clockwise because of projection matrix y-flip
@@ -722,26 +1309,13 @@ void Application::create_graphics_pipeline()
 	//configure states that can be changed without pipeline recreation
 	VkDynamicState dynamic_states[] = {
 		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_LINE_WIDTH };
+		VK_DYNAMIC_STATE_SCISSOR };
 
 	VkPipelineDynamicStateCreateInfo dynamic_state_create_info = {};
 	dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 	dynamic_state_create_info.dynamicStateCount = 2;
 	dynamic_state_create_info.pDynamicStates = dynamic_states;
 
-	//configure the pipeline layout to use the uniform buffer and texture sampler at a later point
-	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
-	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipeline_layout_create_info.setLayoutCount = 1;
-	pipeline_layout_create_info.pSetLayouts = &m_descriptor_set_layout;
-	pipeline_layout_create_info.pushConstantRangeCount = 0;
-	pipeline_layout_create_info.pPushConstantRanges = nullptr;
-
-	if (vkCreatePipelineLayout(m_logical_device, &pipeline_layout_create_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Pipeline layout creation failed");
-	}
-
 	//put it all together and create the graphics pipeline
 	VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {};
 	graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -754,7 +1328,7 @@ void Application::create_graphics_pipeline()
 	graphics_pipeline_create_info.pMultisampleState = &multisample_state_create_info;
 	graphics_pipeline_create_info.pDepthStencilState = nullptr;
 	graphics_pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
-	graphics_pipeline_create_info.pDynamicState = nullptr;
+	graphics_pipeline_create_info.pDynamicState = &dynamic_state_create_info;
 
 	graphics_pipeline_create_info.layout = m_pipeline_layout;
 
@@ -765,22 +1339,25 @@ void Application::create_graphics_pipeline()
 	graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
 	graphics_pipeline_create_info.basePipelineIndex = -1;
 
-	if (vkCreateGraphicsPipelines(m_logical_device, VK_NULL_HANDLE, 1, &graphics_pipeline_create_info, nullptr, &m_graphics_pipeline) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Graphics Pipeline creation failed");
-	}
+	VkPipeline graphics_pipeline = VK_NULL_HANDLE;
+	VkResult result = vkCreateGraphicsPipelines(m_logical_device, m_pipeline_cache, 1, &graphics_pipeline_create_info, nullptr, &graphics_pipeline);
 
 	//destroy the shader modules, they are in the pipeline now and no longer needed here
 	vkDestroyShaderModule(m_logical_device, frag_shader_module, nullptr);
 	vkDestroyShaderModule(m_logical_device, geom_shader_module, nullptr);
 	vkDestroyShaderModule(m_logical_device, vert_shader_module, nullptr);
 
-	succ("Created graphics pipeline");
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Graphics Pipeline creation failed");
+	}
+	return graphics_pipeline;
 }
 
 //Framebuffer is a wrapper for the attachments created during render pass creation
 void Application::create_framebuffers()
 {
+	PROFILE_FUNCTION();
 	info("Creating framebuffers...");
 	//make sure we have enough framebuffers
 	m_swapchain_framebuffers.resize(m_swapchain_image_views.size());
@@ -811,13 +1388,15 @@ void Application::create_framebuffers()
 //command pools are needed to manage memory of commandbuffers
 void Application::create_command_pool()
 {
+	PROFILE_FUNCTION();
 	info("Creating Command Pool");
-	QueueFamilyIndices queue_family_indices = find_queue_families(m_physical_device);
+	QueueFamilyIndices queue_family_indices = m_queue_family_indices;
 
 	VkCommandPoolCreateInfo command_pool_create_info = {};
 	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	command_pool_create_info.queueFamilyIndex = queue_family_indices.graphics_family;
-	command_pool_create_info.flags = 0;
+	//the frame command buffer is rerecorded every frame, so it has to be resettable on its own
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 	if (vkCreateCommandPool(m_logical_device, &command_pool_create_info, nullptr, &m_command_pool) != VK_SUCCESS)
 	{
@@ -841,35 +1420,17 @@ void Application::create_texture_image()
 		throw std::runtime_error("Failed to load texture");
 	}
 
-	//prepare the staging buffer
-	VkBuffer staging_buffer;
-	VkDeviceMemory staging_buffer_memory;
-
-	create_buffer(image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
+	//create the destination image
+	create_image(texture_width, texture_height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_texture_image, m_texture_image_allocation, MemoryCategory::textures);
 
-	//copy the image to the staging buffer
-	void *data;
-	vkMapMemory(m_logical_device, staging_buffer_memory, 0, image_size, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(image_size));
-	vkUnmapMemory(m_logical_device, staging_buffer_memory);
+	//stage the pixels and record the copy, the image ends up ready for sampling
+	m_upload_batcher.upload_image(pixels, image_size, m_texture_image, static_cast<uint32_t>(texture_width), static_cast<uint32_t>(texture_height));
 
-	//free the image memory
+	//free the image memory, the pixels live in staging memory now
 	stbi_image_free(pixels);
 
-	//create the destination image
-	create_image(texture_width, texture_height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_texture_image, m_texture_image_memory);
-
-	//copy the staging buffer to the destination image
-	transition_image_layout(m_texture_image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	copy_buffer_to_image(staging_buffer, m_texture_image, static_cast<uint32_t>(texture_width), static_cast<uint32_t>(texture_height));
-	transition_image_layout(m_texture_image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	//destroy unused buffers
-	vkDestroyBuffer(m_logical_device, staging_buffer, nullptr);
-	vkFreeMemory(m_logical_device, staging_buffer_memory, nullptr);
-
-	succ("Texture Image created");
-}
+	succ("Texture Image created");
+}
 
 //creates an image view for the texture
 void Application::create_texture_image_view()
@@ -888,8 +1449,9 @@ void Application::create_texture_sampler()
 	sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 	sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 	sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	sampler_create_info.anisotropyEnable = VK_TRUE;
-	sampler_create_info.maxAnisotropy = 16;
+	//enabling it on a device without the feature is an error, not a no-op
+	sampler_create_info.anisotropyEnable = m_max_anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+	sampler_create_info.maxAnisotropy = m_max_anisotropy;
 	sampler_create_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_WHITE;
 	sampler_create_info.unnormalizedCoordinates = VK_FALSE;
 	sampler_create_info.compareEnable = VK_FALSE;
@@ -906,30 +1468,16 @@ void Application::create_texture_sampler()
 //create the vertex buffer used in the shader
 void Application::create_vertex_buffer()
 {
+	PROFILE_FUNCTION();
 	info("Creating vertex buffer...");
 	//determine vertex buffer size
 	VkDeviceSize buffer_size = sizeof(m_vertices[0]) * m_vertices.size();
 
-	//create staging buffer
-	VkBuffer staging_buffer;
-	VkDeviceMemory staging_buffer_memory;
-	create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
-
-	//copy data to staging buffer
-	void *data;
-	vkMapMemory(m_logical_device, staging_buffer_memory, 0, buffer_size, 0, &data);
-	memcpy(data, m_vertices.data(), (size_t)buffer_size);
-	vkUnmapMemory(m_logical_device, staging_buffer_memory);
-
 	//create target buffer
-	create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vertex_buffer, m_vertex_buffer_memory);
-
-	//copy to target buffer
-	copy_buffer(staging_buffer, m_vertex_buffer, buffer_size);
+	create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vertex_buffer, m_vertex_buffer_allocation, MemoryCategory::mesh);
 
-	//destroy staging buffer
-	vkDestroyBuffer(m_logical_device, staging_buffer, nullptr);
-	vkFreeMemory(m_logical_device, staging_buffer_memory, nullptr);
+	//stage the data and record the copy to the target buffer
+	m_upload_batcher.upload_buffer(m_vertices.data(), buffer_size, m_vertex_buffer);
 
 	succ("Vertex buffer created");
 }
@@ -937,62 +1485,124 @@ void Application::create_vertex_buffer()
 //create the index buffer responding to the vertex buffer
 void Application::create_index_buffer()
 {
+	PROFILE_FUNCTION();
 	info("Creating Index Buffer...");
 	//determine size of buffer
 	VkDeviceSize buffer_size = sizeof(m_indices[0]) * m_indices.size();
 
-	//create a staging buffer
-	VkBuffer staging_buffer;
-	VkDeviceMemory staging_buffer_memory;
-	create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
-
-	//copy index data to buffer
-	void *data;
-	vkMapMemory(m_logical_device, staging_buffer_memory, 0, buffer_size, 0, &data);
-	memcpy(data, m_indices.data(), (size_t)buffer_size);
-	vkUnmapMemory(m_logical_device, staging_buffer_memory);
-
 	//create target buffer
-	create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_index_buffer, m_index_buffer_memory);
-
-	//copy to target buffer
-	copy_buffer(staging_buffer, m_index_buffer, buffer_size);
+	create_buffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_index_buffer, m_index_buffer_allocation, MemoryCategory::mesh);
 
-	//destroy staging buffer
-	vkDestroyBuffer(m_logical_device, staging_buffer, nullptr);
-	vkFreeMemory(m_logical_device, staging_buffer_memory, nullptr);
+	//stage the data and record the copy to the target buffer
+	m_upload_batcher.upload_buffer(m_indices.data(), buffer_size, m_index_buffer);
 
 	succ("Index Buffer created");
 }
 
+//creates the displacement buffer the cpu simulation writes into every frame
 void Application::create_displacement_buffer()
 {
-	//every vertex needs a displacement
-	VkDeviceSize buffer_size = sizeof(Displacement) * m_vertices.size();
+	PROFILE_FUNCTION();
+	//every vertex needs a displacement, unless the vertex shader evaluates or samples them, then one zero per instance keeps the binding valid
+	bool per_vertex = !m_vertex_simulation && !m_texture_simulation;
+	VkDeviceSize buffer_size = sizeof(Displacement) * (per_vertex ? m_vertices.size() : 1);
+
+	create_buffer(buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_displacement_buffer, m_displacement_allocation, MemoryCategory::displacement);
+	if (!per_vertex)
+	{
+		memset(m_displacement_allocation.mapped, 0, static_cast<size_t>(buffer_size));
+	}
+}
+
+//the waves as the vertex shader reads them, a few hundred bytes that never change
+//the graphics pipeline always declares the buffer, so it exists even if the vertex shader does not evaluate the waves
+void Application::create_wave_buffer()
+{
+	PROFILE_FUNCTION();
+	std::vector<GerstnerParameters> waves = m_ocean->get_wave_parameters();
+	VkDeviceSize buffer_size = sizeof(GerstnerParameters) * std::max<size_t>(waves.size(), 1);
+	create_buffer(buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_wave_buffer, m_wave_allocation, MemoryCategory::simulation);
+	memcpy(m_wave_allocation.mapped, waves.data(), sizeof(GerstnerParameters) * waves.size());
+
+	if (m_config.parity_check)
+	{
+		create_buffer(sizeof(Displacement) * m_vertices.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_parity_buffer, m_parity_allocation, MemoryCategory::displacement);
+	}
+}
+
+//moves the wave simulation to a compute shader, on its own queue if the device has one
+void Application::create_ocean_compute()
+{
+	PROFILE_FUNCTION();
+	m_benchmark_result.simulation = "cpu";
+	if (m_config.simulation == "cpu")
+	{
+		info("Simulating waves on the cpu as requested");
+		return;
+	}
+	if (m_vertex_simulation)
+	{
+		info("Evaluating waves in the vertex shader");
+		m_benchmark_result.simulation = "vertex";
+		return;
+	}
+	if (m_texture_simulation)
+	{
+		info("Simulating waves into textures");
+		m_benchmark_result.simulation = "texture";
+		return;
+	}
+
+	VkShaderModule comp_shader_module = create_shader_module(EMBEDDED_COMP_SHADER);
+
+	m_ocean_compute.initialize(m_physical_device, m_logical_device, &m_memory_allocator, m_queue_family_indices.compute_family, m_compute_queue, m_queue_family_indices.graphics_family, comp_shader_module, m_ocean->resolution, static_cast<uint32_t>(m_vertices.size()), m_ocean->get_wave_parameters());
+	vkDestroyShaderModule(m_logical_device, comp_shader_module, nullptr);
+	m_gpu_simulation = true;
+	m_benchmark_result.simulation = "gpu";
+
+	//the first frame needs a displacement to draw
+	m_ocean_compute.dispatch(0.0f, m_wave_lod);
+}
+
+//the texture simulation fills its maps while the frame is recorded, everyone else gets flat 1x1 maps
+void Application::create_ocean_texture()
+{
+	PROFILE_FUNCTION();
+	if (!m_texture_simulation)
+	{
+		m_ocean_texture.initialize_placeholder(m_logical_device, &m_memory_allocator, &m_upload_batcher, m_queue_family_indices.graphics_family, m_queue_family_indices.transfer_family);
+		return;
+	}
 
-	create_buffer(buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_displacement_buffer, m_displacement_memory);
+	VkShaderModule comp_shader_module = create_shader_module(EMBEDDED_COMP_TEXTURE_SHADER);
+	m_ocean_texture.initialize(m_physical_device, m_logical_device, &m_memory_allocator, m_queue_family_indices.graphics_family, comp_shader_module, m_config.texture_resolution, static_cast<float>(m_ocean->resolution), m_max_anisotropy, m_ocean->get_wave_parameters());
+	vkDestroyShaderModule(m_logical_device, comp_shader_module, nullptr);
 }
 
 //create the uniform buffer
 void Application::create_uniform_buffer()
 {
+	PROFILE_FUNCTION();
 	info("Creating Uniform Buffer...");
 	VkDeviceSize buffer_size = sizeof(UniformBufferObject);
-	create_buffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_uniform_buffer, m_uniform_buffer_memory);
+	create_buffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_uniform_buffer, m_uniform_buffer_allocation, MemoryCategory::uniforms);
 	succ("Uniform Buffer created");
 }
 
 //create a descriptor pool for descriptor set creation
 void Application::create_descriptor_pool()
 {
+	PROFILE_FUNCTION();
 	info("Creating Descriptor Pool...");
 
-	//2 pools, uniform buffer and texture sampler
-	std::array<VkDescriptorPoolSize, 2> descriptor_pool_sizes = {};
+	//3 pools, uniform buffer, the samplers of the normal and displacement map and the storage buffers of the waves and the parity check
+	std::array<VkDescriptorPoolSize, 3> descriptor_pool_sizes = {};
 	descriptor_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	descriptor_pool_sizes[0].descriptorCount = 1;
 	descriptor_pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	descriptor_pool_sizes[1].descriptorCount = 1;
+	descriptor_pool_sizes[1].descriptorCount = 2;
+	descriptor_pool_sizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_sizes[2].descriptorCount = 2;
 	//create descriptor pool
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
 	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -1010,6 +1620,7 @@ void Application::create_descriptor_pool()
 //create the descriptor sets which will be accessible from the shader
 void Application::create_descriptor_set()
 {
+	PROFILE_FUNCTION();
 	info("Creating Descriptor Set...");
 	//define the layout
 	VkDescriptorSetLayout descriptor_set_layouts[] = { m_descriptor_set_layout };
@@ -1035,7 +1646,20 @@ void Application::create_descriptor_set()
 	descriptor_image_info.imageView = m_texture_image_view;
 	descriptor_image_info.sampler = m_texture_sampler;*/
 
-	std::array<VkWriteDescriptorSet, 1> write_descriptor_sets = {};
+	VkDescriptorBufferInfo wave_buffer_info = {};
+	wave_buffer_info.buffer = m_wave_buffer;
+	wave_buffer_info.offset = 0;
+	wave_buffer_info.range = VK_WHOLE_SIZE;
+
+	VkDescriptorBufferInfo parity_buffer_info = {};
+	parity_buffer_info.buffer = m_parity_buffer;
+	parity_buffer_info.offset = 0;
+	parity_buffer_info.range = VK_WHOLE_SIZE;
+
+	VkDescriptorImageInfo normal_map_info = m_ocean_texture.get_normal_info();
+	VkDescriptorImageInfo displacement_map_info = m_ocean_texture.get_displacement_info();
+
+	std::vector<VkWriteDescriptorSet> write_descriptor_sets(m_config.parity_check ? 5 : 4);
 	write_descriptor_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	write_descriptor_sets[0].dstSet = m_descriptor_set;
 	write_descriptor_sets[0].dstBinding = 0;
@@ -1044,6 +1668,33 @@ void Application::create_descriptor_set()
 	write_descriptor_sets[0].descriptorCount = 1;
 	write_descriptor_sets[0].pBufferInfo = &descriptor_buffer_info;
 
+	write_descriptor_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_sets[1].dstSet = m_descriptor_set;
+	write_descriptor_sets[1].dstBinding = 2;
+	write_descriptor_sets[1].dstArrayElement = 0;
+	write_descriptor_sets[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write_descriptor_sets[1].descriptorCount = 1;
+	write_descriptor_sets[1].pBufferInfo = &wave_buffer_info;
+
+	write_descriptor_sets[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_sets[2].dstSet = m_descriptor_set;
+	write_descriptor_sets[2].dstBinding = 1;
+	write_descriptor_sets[2].dstArrayElement = 0;
+	write_descriptor_sets[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write_descriptor_sets[2].descriptorCount = 1;
+	write_descriptor_sets[2].pImageInfo = &normal_map_info;
+
+	write_descriptor_sets[3] = write_descriptor_sets[2];
+	write_descriptor_sets[3].dstBinding = 4;
+	write_descriptor_sets[3].pImageInfo = &displacement_map_info;
+
+	if (m_config.parity_check)
+	{
+		write_descriptor_sets[4] = write_descriptor_sets[1];
+		write_descriptor_sets[4].dstBinding = 3;
+		write_descriptor_sets[4].pBufferInfo = &parity_buffer_info;
+	}
+
 	/*write_descriptor_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	write_descriptor_sets[1].dstSet = m_descriptor_set;
 	write_descriptor_sets[1].dstBinding = 1;
@@ -1057,76 +1708,122 @@ void Application::create_descriptor_set()
 	succ("Descriptor Set created");
 }
 
+//allocates the command buffer the frame gets recorded into
+//it does not reference any swapchain resources until it is recorded, so it survives swapchain recreation
 void Application::create_command_buffers()
 {
+	PROFILE_FUNCTION();
 	info("Creating Command Buffers...");
-	//allocate command buffers
-	m_command_buffers.resize(m_swapchain_framebuffers.size());
-
 	VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
 	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	command_buffer_allocate_info.commandPool = m_command_pool;
 	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	command_buffer_allocate_info.commandBufferCount = (uint32_t)m_command_buffers.size();
+	command_buffer_allocate_info.commandBufferCount = 1;
 
-	if (vkAllocateCommandBuffers(m_logical_device, &command_buffer_allocate_info, m_command_buffers.data()) != VK_SUCCESS)
+	if (vkAllocateCommandBuffers(m_logical_device, &command_buffer_allocate_info, &m_command_buffer) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Commandbuffer allocation failed");
 	}
 	succ("Command buffer allocated");
+}
+
+//records the drawing commands for the given swapchain image
+//this happens every frame, so the current extent and framebuffer are always the ones in use
+void Application::record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index)
+{
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
 
-	//record the command buffer
-	info("Recording Command Buffers...");
-	for (size_t i = 0; i < m_command_buffers.size(); i++)
+	vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+
+	//the fence of the last frame was waited on, so its timestamps are ready to be read
+	m_gpu_timer.begin(command_buffer, 0);
+	uint32_t frame_zone = m_gpu_timer.begin_zone(command_buffer, "frame");
+
+	//buffer ownership barriers are not allowed inside the render pass
+	if (m_gpu_simulation)
+	{
+		m_ocean_compute.record_graphics_barriers(command_buffer);
+	}
+	//neither are dispatches and blits
+	if (m_texture_simulation)
 	{
-		VkCommandBufferBeginInfo command_buffer_begin_info = {};
-		command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-		command_buffer_begin_info.pInheritanceInfo = nullptr;
+		uint32_t texture_zone = m_gpu_timer.begin_zone(command_buffer, "texture simulation");
+		m_ocean_texture.record(command_buffer, m_time);
+		m_gpu_timer.end_zone(command_buffer, texture_zone);
+	}
 
-		vkBeginCommandBuffer(m_command_buffers[i], &command_buffer_begin_info);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, 1, &m_descriptor_set, 0, nullptr);
 
-		vkCmdBindDescriptorSets(m_command_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, 1, &m_descriptor_set, 0, nullptr);
+	VkRenderPassBeginInfo render_pass_begin_info = {};
+	render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	render_pass_begin_info.renderPass = m_render_pass;
+	render_pass_begin_info.framebuffer = m_swapchain_framebuffers[image_index];
+	render_pass_begin_info.renderArea.offset = { 0, 0 };
+	render_pass_begin_info.renderArea.extent = m_swapchain_extent;
 
-		VkRenderPassBeginInfo render_pass_begin_info = {};
-		render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_pass_begin_info.renderPass = m_render_pass;
-		render_pass_begin_info.framebuffer = m_swapchain_framebuffers[i];
-		render_pass_begin_info.renderArea.offset = { 0, 0 };
-		render_pass_begin_info.renderArea.extent = m_swapchain_extent;
+	VkClearValue clear_value = { 0.0f, 0.0f, 0.0f, 1.0f };
+	render_pass_begin_info.clearValueCount = 1;
+	render_pass_begin_info.pClearValues = &clear_value;
 
-		VkClearValue clear_value = { 0.0f, 0.0f, 0.0f, 1.0f };
-		render_pass_begin_info.clearValueCount = 1;
-		render_pass_begin_info.pClearValues = &clear_value;
+	uint32_t render_pass_zone = m_gpu_timer.begin_zone(command_buffer, "render pass");
+	vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
-		vkCmdBeginRenderPass(m_command_buffers[i], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphics_pipeline);
 
-		vkCmdBindPipeline(m_command_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphics_pipeline);
+	//viewport and scissor are dynamic, so they always follow the current swapchain extent
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float)m_swapchain_extent.width;
+	viewport.height = (float)m_swapchain_extent.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(command_buffer, 0, 1, &viewport);
 
-		VkBuffer vertex_buffers[] = { m_vertex_buffer };
-		VkBuffer displacement_buffers[] = { m_displacement_buffer };
-		VkDeviceSize offsets[] = { 0 };
+	VkRect2D scissor = {};
+	scissor.offset = { 0, 0 };
+	scissor.extent = m_swapchain_extent;
+	vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-		vkCmdBindVertexBuffers(m_command_buffers[i], 0, 1, vertex_buffers, offsets);
-		vkCmdBindVertexBuffers(m_command_buffers[i], 1, 1, displacement_buffers, offsets);
+	VkBuffer vertex_buffers[] = { m_vertex_buffer };
+	VkBuffer displacement_buffers[] = { m_gpu_simulation ? m_ocean_compute.get_displacement_buffer() : m_displacement_buffer };
+	VkDeviceSize offsets[] = { 0 };
 
-		vkCmdBindIndexBuffer(m_command_buffers[i], m_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+	vkCmdBindVertexBuffers(command_buffer, 1, 1, displacement_buffers, offsets);
 
-		vkCmdDrawIndexed(m_command_buffers[i], static_cast<uint32_t>(m_indices.size()), 1, 0, 0, 0);
+	vkCmdBindIndexBuffer(command_buffer, m_index_buffer, 0, VK_INDEX_TYPE_UINT32);
 
-		vkCmdEndRenderPass(m_command_buffers[i]);
+	vkCmdDrawIndexed(command_buffer, static_cast<uint32_t>(m_indices.size()), 1, 0, 0, 0);
 
-		if (vkEndCommandBuffer(m_command_buffers[i]) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Command Buffer Recording failed.");
-		}
+	vkCmdEndRenderPass(command_buffer);
+	m_gpu_timer.end_zone(command_buffer, render_pass_zone);
+	m_gpu_timer.end_zone(command_buffer, frame_zone);
+
+	//the fence alone does not make what the vertex shader wrote visible to the host
+	if (m_config.parity_check)
+	{
+		VkMemoryBarrier memory_barrier = {};
+		memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+	}
+
+	if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Command Buffer Recording failed.");
 	}
-	succ("Command Buffers recorded.");
 }
 
 //creates the semaphores needed to signal that an image is ready for rendering or presentation
-void Application::create_semaphores()
+//and the fence that tells the cpu when the frame command buffer can be recorded again
+void Application::create_sync_objects()
 {
+	PROFILE_FUNCTION();
 	info("Creating semaphores...");
 	VkSemaphoreCreateInfo semaphore_create_info = {};
 	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1136,53 +1833,136 @@ void Application::create_semaphores()
 		throw std::runtime_error("Semaphore creation failed");
 	}
 	succ("Semaphores created");
+
+	info("Creating fence...");
+	VkFenceCreateInfo fence_create_info = {};
+	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	//start signaled, so the very first frame does not wait forever
+	fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	if (vkCreateFence(m_logical_device, &fence_create_info, nullptr, &m_in_flight_fence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Fence creation failed");
+	}
+	succ("Fence created");
 }
 
 #pragma endregion
 
 void Application::draw_frame()
 {
+	PROFILE_FUNCTION();
+	//the command buffer can only be rerecorded once the gpu is done with the last frame, run_frame waited for that
+
+	//the last frame is done with the old pipeline, so a rebuilt one can take its place right here
+	VkPipeline reloaded_pipeline = m_shader_reloader.take_pipeline(m_graphics_reload);
+	if (reloaded_pipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(m_logical_device, m_graphics_pipeline, nullptr);
+		m_graphics_pipeline = reloaded_pipeline;
+		succ("Shaders reloaded");
+	}
+	//the texture simulation is recorded into the frame, the buffer simulation waits for its own submissions
+	VkPipeline reloaded_compute_pipeline = m_shader_reloader.take_pipeline(m_compute_reload);
+	if (reloaded_compute_pipeline != VK_NULL_HANDLE)
+	{
+		if (m_gpu_simulation)
+			m_ocean_compute.replace_pipeline(reloaded_compute_pipeline);
+		else
+			m_ocean_texture.replace_pipeline(reloaded_compute_pipeline);
+		succ("Compute shader reloaded");
+	}
+
+	//offscreen images are used in turn, nobody else has to hand them out
+	uint32_t image_index = 0;
+	VkResult drawing_result = VK_SUCCESS;
+	if (m_config.headless)
+	{
+		image_index = m_headless_image_index;
+		m_headless_image_index = (m_headless_image_index + 1) % static_cast<uint32_t>(m_swapchain_images.size());
+	}
 	//check if the image we want to render to is suitable
-	uint32_t image_index;
-	VkResult drawing_result = vkAcquireNextImageKHR(m_logical_device, m_swapchain, std::numeric_limits<uint64_t>::max(), m_image_available_semaphore, VK_NULL_HANDLE, &image_index);
+	else
+	{
+		drawing_result = vkAcquireNextImageKHR(m_logical_device, m_swapchain, std::numeric_limits<uint64_t>::max(), m_image_available_semaphore, VK_NULL_HANDLE, &image_index);
+	}
 
 	if (drawing_result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		recreate_swapchain();
 		return;
 	}
-	else if (drawing_result != VK_SUCCESS && drawing_result == VK_SUBOPTIMAL_KHR)
+	else if (drawing_result != VK_SUCCESS && drawing_result != VK_SUBOPTIMAL_KHR)
 	{
 		throw std::runtime_error("Failed acquiring swapchain image");
 	}
 
+	//only reset the fence once we are sure work is going to be submitted
+	vkResetFences(m_logical_device, 1, &m_in_flight_fence);
+	vkResetCommandBuffer(m_command_buffer, 0);
+	record_command_buffer(m_command_buffer, image_index);
+
 	//submit the rendering commands form command buffers
 	VkSubmitInfo submit_info = {};
 	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore wait_semaphores[] = { m_image_available_semaphore };
+	std::vector<VkSemaphore> wait_semaphores;
+	std::vector<VkPipelineStageFlags> wait_stages;
+	if (!m_config.headless)
+	{
+		wait_semaphores.push_back(m_image_available_semaphore);
+		wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	}
 
-	VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submit_info.waitSemaphoreCount = 1;
-	submit_info.pWaitSemaphores = wait_semaphores;
-	submit_info.pWaitDstStageMask = wait_stages;
+	//if uploads were submitted since the last frame, dont touch their destinations before they are done
+	VkSemaphore upload_semaphore = m_upload_batcher.take_pending_semaphore();
+	if (upload_semaphore != VK_NULL_HANDLE)
+	{
+		wait_semaphores.push_back(upload_semaphore);
+		wait_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+
+	//a freshly simulated displacement buffer can only be read once the compute queue is done with it
+	std::vector<VkSemaphore> signal_semaphores;
+	if (!m_config.headless)
+	{
+		signal_semaphores.push_back(m_render_finished_semaphore);
+	}
+	if (m_gpu_simulation && m_ocean_compute.get_graphics_wait_semaphore() != VK_NULL_HANDLE)
+	{
+		wait_semaphores.push_back(m_ocean_compute.get_graphics_wait_semaphore());
+		wait_stages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+	}
+	//and the compute queue can only write to the old one again once this frame is done with it
+	if (m_gpu_simulation && m_ocean_compute.get_graphics_signal_semaphore() != VK_NULL_HANDLE)
+	{
+		signal_semaphores.push_back(m_ocean_compute.get_graphics_signal_semaphore());
+	}
+
+	submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+	submit_info.pWaitSemaphores = wait_semaphores.data();
+	submit_info.pWaitDstStageMask = wait_stages.data();
 
 	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers = &m_command_buffers[image_index];
+	submit_info.pCommandBuffers = &m_command_buffer;
 
-	VkSemaphore signal_semaphores[] = { m_render_finished_semaphore };
-	submit_info.signalSemaphoreCount = 1;
-	submit_info.pSignalSemaphores = signal_semaphores;
-	if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+	submit_info.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+	submit_info.pSignalSemaphores = signal_semaphores.data();
+	m_gpu_timer.mark_submitted();
+	if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_in_flight_fence) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Draw Command submission failed");
 	}
 
+	//there is nothing to present to
+	if (m_config.headless)
+		return;
+
 	//present the rendered image
 	VkPresentInfoKHR present_info = {};
 	present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	present_info.waitSemaphoreCount = 1;
-	present_info.pWaitSemaphores = signal_semaphores;
+	present_info.pWaitSemaphores = &m_render_finished_semaphore;
 
 	VkSwapchainKHR swapchains[] = { m_swapchain };
 	present_info.swapchainCount = 1;
@@ -1206,31 +1986,44 @@ void Application::draw_frame()
 //update uniform buffer objects with fresh values
 void Application::update_buffers()
 {
-	static auto start_time = std::chrono::high_resolution_clock::now();
-	auto current_time = std::chrono::high_resolution_clock::now();
-	m_time = std::chrono::duration<float, std::chrono::seconds::period>(current_time - start_time).count();
+	PROFILE_FUNCTION();
+	//the clock decides which time this frame shows, wall time unless something reproducible was asked for
+	m_time = m_clock->next_frame();
 	UniformBufferObject ubo = {};
 	ubo.model = glm::mat4(1.0f);//glm::rotate(glm::mat4(1.0f), m_time * glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	ubo.view = glm::lookAt(glm::vec3(m_ocean_resolution*0.75, m_ocean_resolution*0.75, m_ocean_resolution*0.5), glm::vec3(0.0f, 0.0f, m_ocean_resolution*-0.25f), glm::vec3(0.0f, 0.0f, 1.0f));
-	ubo.projection = glm::perspective(glm::radians(45.0f), m_swapchain_extent.width / (float)m_swapchain_extent.height, 0.1f, 10000.0f);
+	glm::vec3 camera_position(m_config.resolution*0.75, m_config.resolution*0.75, m_config.resolution*0.5);
+	float field_of_view = glm::radians(45.0f);
+	ubo.view = glm::lookAt(camera_position, glm::vec3(0.0f, 0.0f, m_config.resolution*-0.25f), glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.projection = glm::perspective(field_of_view, m_swapchain_extent.width / (float)m_swapchain_extent.height, 0.1f, 10000.0f);
 	//change y sign because glms clip coordinate is inverted, was designed for opengl, not vulkan after all
 	ubo.projection[1][1] *= -1;
+	ubo.time = m_time;
+
+	//a wavelength seen from distance d spans about wavelength / d * height / fov pixels, waves that would cover
+	//fewer than wave_lod pixels fade out, the grid is centered on the origin with one cell per unit
+	m_wave_lod.camera = camera_position + glm::vec3(0.5f * m_config.resolution, 0.5f * m_config.resolution, 0.0f);
+	m_wave_lod.cutoff_per_distance = m_config.wave_lod * field_of_view / m_swapchain_extent.height;
+	ubo.lod = m_wave_lod;
 
-	void *data;
-	vkMapMemory(m_logical_device, m_uniform_buffer_memory, 0, sizeof(ubo), 0, &data);
-	memcpy(data, &ubo, sizeof(ubo));
-	vkUnmapMemory(m_logical_device, m_uniform_buffer_memory);
+	//both buffers live in persistently mapped, host coherent memory
+	memcpy(m_uniform_buffer_allocation.mapped, &ubo, sizeof(ubo));
 
-	void *displacement_data;
-	VkDeviceSize buffer_size = sizeof(Displacement)*m_displacements.size();
-	vkMapMemory(m_logical_device, m_displacement_memory, 0, buffer_size, 0, &displacement_data);
-	memcpy(displacement_data, m_displacements.data(), (size_t)buffer_size);
-	vkUnmapMemory(m_logical_device, m_displacement_memory);
+	//the gpu simulation writes its displacement itself, the vertex and texture simulation need none, a sequence decodes straight into it
+	if (m_sequence)
+	{
+		m_sequence->read_frame(m_sequence->get_frame(m_time), static_cast<Displacement *>(m_displacement_allocation.mapped));
+	}
+	else if (!m_gpu_simulation && !m_vertex_simulation && !m_texture_simulation)
+	{
+		VkDeviceSize buffer_size = sizeof(Displacement)*m_displacements.size();
+		memcpy(m_displacement_allocation.mapped, m_displacements.data(), (size_t)buffer_size);
+	}
 }
 
 //recreates the swapchain, for example in the event the current one is not suitable anymore
 void Application::recreate_swapchain()
 {
+	PROFILE_FUNCTION();
 	int width, height;
 	glfwGetWindowSize(m_window, &width, &height);
 	if (width == 0 || height == 0)
@@ -1238,14 +2031,206 @@ void Application::recreate_swapchain()
 
 	vkDeviceWaitIdle(m_logical_device);
 
+	//only the swapchain images and what directly references them depend on the window size
 	clean_up_swapchain();
 
+	VkFormat previous_format = m_swapchain_image_format;
 	create_swapchain();
 	create_image_views();
-	create_render_pass();
-	create_graphics_pipeline();
+
+	//render pass and pipeline stay valid unless the surface format changed
+	if (m_swapchain_image_format != previous_format)
+	{
+		info("Swapchain format changed, rebuilding render pass...");
+		{
+			//a pipeline being rebuilt in the background must not see the render pass change
+			std::lock_guard<std::mutex> lock(m_pipeline_mutex);
+			m_shader_reloader.discard_pipeline(m_graphics_reload);
+			vkDestroyPipeline(m_logical_device, m_graphics_pipeline, nullptr);
+			vkDestroyRenderPass(m_logical_device, m_render_pass, nullptr);
+			create_render_pass();
+		}
+		create_graphics_pipeline();
+	}
 	create_framebuffers();
-	create_command_buffers();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Headless
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//creates the images rendered into instead of the swapchain images
+void Application::create_offscreen_images()
+{
+	PROFILE_FUNCTION();
+	info("Creating offscreen images...");
+	m_benchmark_result.present_mode = "none";
+	m_swapchain_image_format = VK_FORMAT_R8G8B8A8_UNORM;
+	m_swapchain_extent = { static_cast<uint32_t>(WIDTH), static_cast<uint32_t>(HEIGHT) };
+
+	m_swapchain_images.resize(HEADLESS_IMAGE_COUNT);
+	m_offscreen_allocations.resize(HEADLESS_IMAGE_COUNT);
+	for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; i++)
+	{
+		create_image(m_swapchain_extent.width, m_swapchain_extent.height, m_swapchain_image_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_swapchain_images[i], m_offscreen_allocations[i], MemoryCategory::render_targets);
+	}
+	succ("Offscreen images created");
+}
+
+//renders a fixed number of frames as fast as possible and reports how long they took
+//works with and without a window, closing the window ends the run early
+void Application::benchmark_loop()
+{
+	flush_log();
+	std::cout << "Rendering " << m_config.frame_count << " frames" << (m_config.headless ? " headless" : "") << "..." << std::endl;
+	std::vector<double> cpu_milliseconds;
+	std::vector<double> gpu_milliseconds;
+
+	for (uint32_t frame = 0; frame < m_config.frame_count; frame++)
+	{
+		PROFILE_ZONE("frame");
+		auto frame_start = std::chrono::high_resolution_clock::now();
+
+		if (!m_config.headless)
+		{
+			glfwPollEvents();
+			if (glfwWindowShouldClose(m_window))
+				break;
+		}
+		run_frame();
+
+		//wait for the frame, so every frame is measured on its own
+		vkWaitForFences(m_logical_device, 1, &m_in_flight_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		if (m_config.parity_check)
+		{
+			check_parity();
+		}
+		cpu_milliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frame_start).count());
+
+		//the "frame" zone is the first one in the command buffer
+		m_gpu_timer.read_back();
+		gpu_milliseconds.push_back(m_gpu_timer.get_last_milliseconds(0));
+
+		//only offscreen images can be read back
+		if (m_config.headless && std::find(m_config.dump_frames.begin(), m_config.dump_frames.end(), frame) != m_config.dump_frames.end())
+		{
+			dump_frame((m_headless_image_index + HEADLESS_IMAGE_COUNT - 1) % HEADLESS_IMAGE_COUNT, frame);
+		}
+	}
+	vkDeviceWaitIdle(m_logical_device);
+
+	//per frame timings for further analysis
+	if (!m_config.timings_path.empty())
+	{
+		std::ofstream timings_file(m_config.timings_path);
+		timings_file << "frame,cpu_ms,gpu_ms" << std::endl;
+		for (size_t i = 0; i < cpu_milliseconds.size(); i++)
+		{
+			timings_file << i << ',' << cpu_milliseconds[i] << ',' << gpu_milliseconds[i] << std::endl;
+		}
+	}
+
+	m_benchmark_result.frames = static_cast<uint32_t>(cpu_milliseconds.size());
+	if (cpu_milliseconds.empty())
+		return;
+	//keep the summary in one piece
+	flush_log();
+
+	double cpu_total = 0.0;
+	double gpu_total = 0.0;
+	for (size_t i = 0; i < cpu_milliseconds.size(); i++)
+	{
+		cpu_total += cpu_milliseconds[i];
+		gpu_total += gpu_milliseconds[i];
+	}
+	m_benchmark_result.cpu_average_milliseconds = cpu_total / cpu_milliseconds.size();
+	m_benchmark_result.cpu_min_milliseconds = *std::min_element(cpu_milliseconds.begin(), cpu_milliseconds.end());
+	m_benchmark_result.cpu_max_milliseconds = *std::max_element(cpu_milliseconds.begin(), cpu_milliseconds.end());
+	//without timestamp support every gpu time is negative
+	if (*std::min_element(gpu_milliseconds.begin(), gpu_milliseconds.end()) >= 0.0)
+	{
+		m_benchmark_result.gpu_average_milliseconds = gpu_total / gpu_milliseconds.size();
+		m_benchmark_result.gpu_min_milliseconds = *std::min_element(gpu_milliseconds.begin(), gpu_milliseconds.end());
+		m_benchmark_result.gpu_max_milliseconds = *std::max_element(gpu_milliseconds.begin(), gpu_milliseconds.end());
+	}
+
+	std::cout << "Frames: " << m_benchmark_result.frames << std::endl;
+	std::cout << "CPU frame time avg " << m_benchmark_result.cpu_average_milliseconds << "ms, min " << m_benchmark_result.cpu_min_milliseconds << "ms, max " << m_benchmark_result.cpu_max_milliseconds << "ms" << std::endl;
+	if (m_benchmark_result.gpu_average_milliseconds >= 0.0)
+	{
+		std::cout << "GPU frame time avg " << m_benchmark_result.gpu_average_milliseconds << "ms, min " << m_benchmark_result.gpu_min_milliseconds << "ms, max " << m_benchmark_result.gpu_max_milliseconds << "ms" << std::endl;
+	}
+	else
+	{
+		std::cout << "GPU frame time not available" << std::endl;
+	}
+	if (m_config.parity_check)
+	{
+		std::cout << "Parity with the cpu waves: largest difference " << m_parity_max_error << " of the largest displacement, " << (m_parity_max_error > PARITY_TOLERANCE ? "FAILED" : "passed") << std::endl;
+	}
+	if (!m_config.timings_path.empty())
+	{
+		std::cout << "Per frame timings written to " << m_config.timings_path << std::endl;
+	}
+}
+
+//copies an offscreen image to the host and writes it to a ppm file
+void Application::dump_frame(uint32_t image_index, uint32_t frame)
+{
+	PROFILE_FUNCTION();
+	VkDeviceSize image_size = m_swapchain_extent.width * m_swapchain_extent.height * 4;
+	VkBuffer readback_buffer;
+	Allocation readback_allocation;
+	create_buffer(image_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback_buffer, readback_allocation, MemoryCategory::staging);
+
+	VkCommandBuffer command_buffer = begin_single_time_commands();
+
+	//the render pass left the image in transfer source layout, make its writes visible to the copy
+	VkImageMemoryBarrier image_memory_barrier = {};
+	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.image = m_swapchain_images[image_index];
+	image_memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_memory_barrier.subresourceRange.baseMipLevel = 0;
+	image_memory_barrier.subresourceRange.levelCount = 1;
+	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
+	image_memory_barrier.subresourceRange.layerCount = 1;
+	image_memory_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { m_swapchain_extent.width, m_swapchain_extent.height, 1 };
+	vkCmdCopyImageToBuffer(command_buffer, m_swapchain_images[image_index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback_buffer, 1, &region);
+
+	end_single_time_commands(command_buffer);
+
+	//ppm has no alpha, drop it
+	std::string filename = std::string("frame_") + std::to_string(frame) + ".ppm";
+	std::ofstream file(filename, std::ios::binary);
+	file << "P6\n" << m_swapchain_extent.width << ' ' << m_swapchain_extent.height << "\n255\n";
+	const unsigned char *pixels = static_cast<const unsigned char *>(readback_allocation.mapped);
+	for (VkDeviceSize pixel = 0; pixel < image_size; pixel += 4)
+	{
+		file.write(reinterpret_cast<const char *>(pixels + pixel), 3);
+	}
+	std::cout << "Frame " << frame << " written to " << filename << std::endl;
+
+	vkDestroyBuffer(m_logical_device, readback_buffer, nullptr);
+	m_memory_allocator.free(readback_allocation);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1266,33 +2251,68 @@ QueueFamilyIndices Application::find_queue_families(VkPhysicalDevice physical_de
 	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
 
 	info("Looking for Queues...");
+	//all families are looked at, the dedicated ones might come after the graphics family
 	int queue_index = 0;
 	for (const auto &queue_family : queue_families)
 	{
 		//Can it render???
-		if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT && indices.graphics_family < 0)
 		{
 			indices.graphics_family = queue_index;
-			info(std::string("\tQueue ") + std::to_string(queue_index) + " has a graphics bit");
+			info("\tQueue ", queue_index, " has a graphics bit");
 		}
 		//Can it present???
 		VkBool32 presentation_support = VK_FALSE;
-		vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, queue_index, m_surface, &presentation_support);
+		if (!m_config.headless)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, queue_index, m_surface, &presentation_support);
+		}
 
-		if (queue_family.queueCount > 0 && presentation_support != VK_FALSE)
+		if (queue_family.queueCount > 0 && presentation_support != VK_FALSE && indices.presentation_family < 0)
 		{
 			indices.presentation_family = queue_index;
-			info(std::string("\tQueue ") + std::to_string(queue_index) + " is able to present");
+			info("\tQueue ", queue_index, " is able to present");
 		}
 
-		if (indices.isComplete())
+		//Can it only copy???
+		//graphics and compute queues can copy as well, but a queue that only copies usually maps to the dma engines
+		if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT && !(queue_family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && indices.transfer_family < 0)
 		{
-			succ("\tQueues are suitable, aborting search");
-			break;
+			indices.transfer_family = queue_index;
+			info("\tQueue ", queue_index, " is a dedicated transfer queue");
+		}
+
+		//Can it compute without rendering???
+		//such a family runs next to the graphics queue, so the simulation can overlap with rendering
+		if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT && !(queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) && indices.compute_family < 0)
+		{
+			indices.compute_family = queue_index;
+			info("\tQueue ", queue_index, " is a dedicated compute queue");
 		}
 
 		queue_index++;
 	}
+
+	//headless nothing is presented, the graphics queue stands in so the rest does not have to care
+	if (m_config.headless)
+	{
+		indices.presentation_family = indices.graphics_family;
+	}
+	//without a dedicated transfer queue, uploads go through the graphics queue
+	if (indices.transfer_family < 0)
+	{
+		indices.transfer_family = indices.graphics_family;
+	}
+	//without a dedicated compute queue, the simulation goes through the graphics queue, which always supports compute
+	if (indices.compute_family < 0)
+	{
+		indices.compute_family = indices.graphics_family;
+	}
+
+	if (indices.isComplete())
+	{
+		succ("\tQueues are suitable");
+	}
 	return indices;
 }
 
@@ -1333,9 +2353,13 @@ std::vector<const char *> Application::get_required_instance_extensions()
 {
 	info("Getting required instance extensions...");
 	uint32_t glfw_required_extension_count = 0;
-	const char **glfw_extension_names;
+	const char **glfw_extension_names = nullptr;
 
-	glfw_extension_names = glfwGetRequiredInstanceExtensions(&glfw_required_extension_count);
+	//glfw is not initialized headless, there is no surface to create anyways
+	if (!m_config.headless)
+	{
+		glfw_extension_names = glfwGetRequiredInstanceExtensions(&glfw_required_extension_count);
+	}
 
 	std::vector<const char *> final_required_extensions(glfw_extension_names, glfw_extension_names + glfw_required_extension_count);
 
@@ -1344,6 +2368,13 @@ std::vector<const char *> Application::get_required_instance_extensions()
 	{
 		final_required_extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 	}
+
+	//vulkan 1.0 needs it to query heap budgets
+	m_physical_device_properties_2_enabled = is_instance_extension_supported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	if (m_physical_device_properties_2_enabled)
+	{
+		final_required_extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	}
 	return final_required_extensions;
 }
 
@@ -1382,27 +2413,26 @@ int Application::evaluate_physical_device_capabilities(VkPhysicalDevice physical
 
 	if (!device_features.samplerAnisotropy)
 	{
-		warn("Anisotrpic filter not supported");
-		//TODO: dont allow anisotropic filtering
+		warn("Anisotropic filtering not supported, textures seen at a grazing angle will be blurrier");
 	}
 
 	if (!device_features.geometryShader)
 	{
 		score = 0;
-		warn(std::string("\t") + device_properties.deviceName + " has no geometry shader and is therefore scoring " + std::to_string(score));
+		warn("\t", device_properties.deviceName, " has no geometry shader and is therefore scoring ", score);
 	}
 	if (!find_queue_families(physical_device).isComplete())
 	{
 		score = 0;
-		warn(std::string("\t") + device_properties.deviceName + " has failed queue checks and is therefore scoring " + std::to_string(score));
+		warn("\t", device_properties.deviceName, " has failed queue checks and is therefore scoring ", score);
 	}
 	if (!check_device_extension_support(physical_device))
 	{
 		score = 0;
-		warn(std::string("\t") + device_properties.deviceName + " has failed extension checks and is therefore scoring " + std::to_string(score));
+		warn("\t", device_properties.deviceName, " has failed extension checks and is therefore scoring ", score);
 	}
 	//further tests that require extensions
-	else
+	else if (!m_config.headless)
 	{
 		bool swapchain_adequate = false;
 		SwapChainSupportDetails swapchain_support = query_swapchain_support(physical_device);
@@ -1410,11 +2440,11 @@ int Application::evaluate_physical_device_capabilities(VkPhysicalDevice physical
 		if (!swapchain_adequate)
 		{
 			score = 0;
-			warn(std::string("\t") + device_properties.deviceName + " does not offer sufficient swapchain support and is therefore scoring " + std::to_string(score));
+			warn("\t", device_properties.deviceName, " does not offer sufficient swapchain support and is therefore scoring ", score);
 		}
 	}
 
-	info(std::string("\t") + device_properties.deviceName + std::string(" is scoring ") + std::to_string(score));
+	info("\t", device_properties.deviceName, " is scoring ", score);
 
 	return score;
 }
@@ -1466,13 +2496,33 @@ bool Application::check_instance_extension_support(std::vector<const char *> req
 	return check_extension_support(required_extensions, supported_extensions);
 }
 
+//checks a single optional instance extension
+bool Application::is_instance_extension_supported(const char *extension)
+{
+	uint32_t supported_extension_count = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &supported_extension_count, nullptr);
+	std::vector<VkExtensionProperties> supported_extensions(supported_extension_count);
+	vkEnumerateInstanceExtensionProperties(nullptr, &supported_extension_count, supported_extensions.data());
+	return std::any_of(supported_extensions.begin(), supported_extensions.end(), [extension](const VkExtensionProperties &properties) { return strcmp(properties.extensionName, extension) == 0; });
+}
+
+//checks a single optional device extension
+bool Application::is_device_extension_supported(VkPhysicalDevice physical_device, const char *extension)
+{
+	uint32_t supported_extension_count = 0;
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &supported_extension_count, nullptr);
+	std::vector<VkExtensionProperties> supported_extensions(supported_extension_count);
+	vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &supported_extension_count, supported_extensions.data());
+	return std::any_of(supported_extensions.begin(), supported_extensions.end(), [extension](const VkExtensionProperties &properties) { return strcmp(properties.extensionName, extension) == 0; });
+}
+
 //creates a shader module from the given bytecode
-VkShaderModule Application::create_shader_module(const std::vector<char> &code)
+VkShaderModule Application::create_shader_module(const ShaderCode &code)
 {
 	VkShaderModuleCreateInfo create_info = {};
 	create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	create_info.codeSize = code.size();
-	create_info.pCode = reinterpret_cast<const uint32_t *>(code.data());
+	create_info.codeSize = code.size;
+	create_info.pCode = code.words;
 	VkShaderModule shader_module;
 	if (vkCreateShaderModule(m_logical_device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
 	{
@@ -1481,24 +2531,6 @@ VkShaderModule Application::create_shader_module(const std::vector<char> &code)
 	return shader_module;
 }
 
-//returns the memory type flag that fulfills the properties needed
-uint32_t Application::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties)
-{
-	VkPhysicalDeviceMemoryProperties memory_properties;
-	vkGetPhysicalDeviceMemoryProperties(m_physical_device, &memory_properties);
-
-	//work bit vodoo with flags
-	for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
-	{
-		//return if the memory type fits the type filter and fulfills the needed properties
-		if ((type_filter & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
-		{
-			return i;
-		}
-	}
-	throw std::runtime_error("No suitable memory found");
-}
-
 //transitions between two image layouts, currently only for 2 cases
 void Application::transition_image_layout(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout)
 {
@@ -1546,31 +2578,6 @@ void Application::transition_image_layout(VkImage image, VkFormat format, VkImag
 	end_single_time_commands(command_buffer);
 }
 
-//copies from a buffer to an image
-void Application::copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
-{
-	info("Copying buffer to image...");
-	VkCommandBuffer command_buffer = begin_single_time_commands();
-
-	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
-	region.bufferRowLength = 0;
-	region.bufferImageHeight = 0;
-
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount = 1;
-
-	region.imageOffset = { 0, 0, 0 };
-	region.imageExtent = { width, height, 1 };
-
-	vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	end_single_time_commands(command_buffer);
-	succ("Buffer copied to image");
-}
-
 //begins a single time command buffer recording
 VkCommandBuffer Application::begin_single_time_commands()
 {
@@ -1611,8 +2618,8 @@ void Application::end_single_time_commands(VkCommandBuffer command_buffer)
 	succ("Single time commands ended");
 }
 
-//create a buffer
-void Application::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &buffer_memory)
+//create a buffer and bind it to memory from the allocator
+void Application::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, Allocation &allocation, MemoryCategory category)
 {
 	info("\tCreating buffer...");
 	VkBufferCreateInfo buffer_create_info = {};
@@ -1621,6 +2628,15 @@ void Application::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkM
 	buffer_create_info.usage = usage;
 	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+	//buffers filled by the transfer queue are shared with the graphics queue, so no ownership transfer is needed
+	uint32_t queue_family_indices[] = { (uint32_t)m_queue_family_indices.graphics_family, (uint32_t)m_queue_family_indices.transfer_family };
+	if (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT && m_queue_family_indices.graphics_family != m_queue_family_indices.transfer_family)
+	{
+		buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		buffer_create_info.queueFamilyIndexCount = 2;
+		buffer_create_info.pQueueFamilyIndices = queue_family_indices;
+	}
+
 	if (vkCreateBuffer(m_logical_device, &buffer_create_info, nullptr, &buffer) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Buffer creation failed");
@@ -1629,22 +2645,14 @@ void Application::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkM
 	VkMemoryRequirements memory_requirements;
 	vkGetBufferMemoryRequirements(m_logical_device, buffer, &memory_requirements);
 
-	VkMemoryAllocateInfo memory_allocate_info = {};
-	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = find_memory_type(memory_requirements.memoryTypeBits, properties);
-
-	if (vkAllocateMemory(m_logical_device, &memory_allocate_info, nullptr, &buffer_memory) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Buffer memory allocatiion failed");
-	}
+	allocation = m_memory_allocator.allocate(memory_requirements, properties, true, category);
 
-	vkBindBufferMemory(m_logical_device, buffer, buffer_memory, 0);
+	vkBindBufferMemory(m_logical_device, buffer, allocation.memory, allocation.offset);
 	succ("Buffer created successfully");
 }
 
-//creates an image
-void Application::create_image(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &image_memory)
+//creates an image and binds it to memory from the allocator
+void Application::create_image(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, Allocation &allocation, MemoryCategory category)
 {
 	info("Creating image...");
 	VkImageCreateInfo image_create_info = {};
@@ -1662,6 +2670,15 @@ void Application::create_image(uint32_t width, uint32_t height, VkFormat format,
 	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
 
+	//images filled by the transfer queue are shared with the graphics queue, so no ownership transfer is needed
+	uint32_t queue_family_indices[] = { (uint32_t)m_queue_family_indices.graphics_family, (uint32_t)m_queue_family_indices.transfer_family };
+	if (usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT && m_queue_family_indices.graphics_family != m_queue_family_indices.transfer_family)
+	{
+		image_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		image_create_info.queueFamilyIndexCount = 2;
+		image_create_info.pQueueFamilyIndices = queue_family_indices;
+	}
+
 	if (vkCreateImage(m_logical_device, &image_create_info, nullptr, &image) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Image creation failed");
@@ -1670,17 +2687,10 @@ void Application::create_image(uint32_t width, uint32_t height, VkFormat format,
 	VkMemoryRequirements memory_requirements;
 	vkGetImageMemoryRequirements(m_logical_device, image, &memory_requirements);
 
-	VkMemoryAllocateInfo memory_allocate_info = {};
-	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = find_memory_type(memory_requirements.memoryTypeBits, properties);
+	//optimal tiling images must not share a granularity page with buffers
+	allocation = m_memory_allocator.allocate(memory_requirements, properties, tiling == VK_IMAGE_TILING_LINEAR, category);
 
-	if (vkAllocateMemory(m_logical_device, &memory_allocate_info, nullptr, &image_memory) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Memory allocation failed");
-	}
-
-	vkBindImageMemory(m_logical_device, image, image_memory, 0);
+	vkBindImageMemory(m_logical_device, image, allocation.memory, allocation.offset);
 	succ("Image created");
 }
 
@@ -1709,28 +2719,10 @@ VkImageView Application::create_image_view(VkImage image, VkFormat format)
 	return image_view;
 }
 
-//copies buffer a to buffer b
-void Application::copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size)
-{
-	info("Copying buffer...");
-
-	VkCommandBuffer command_buffer = begin_single_time_commands();
-
-	VkBufferCopy copy_region = {};
-	copy_region.srcOffset = 0;
-	copy_region.dstOffset = 0;
-	copy_region.size = size;
-	vkCmdCopyBuffer(command_buffer, src_buffer, dst_buffer, 1, &copy_region);
-
-	end_single_time_commands(command_buffer);
-
-	succ("Buffer copied");
-}
-
 //the debug callback used for the validation layers
 VKAPI_ATTR VkBool32 VKAPI_CALL Application::debug_callback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objType, uint64_t obj, size_t location, int32_t code, const char *layerPrefix, const char *msg, void *userData)
 {
-	info(std::string("VALIDATION LAYERS:\n") + msg, console_colors_foreground::white, console_colors_background::red);
+	err("VALIDATION LAYERS:\n", msg);
 
 	return VK_FALSE;
 }
@@ -1742,6 +2734,20 @@ void Application::on_window_resized(GLFWwindow *window, int width, int height)
 	app->recreate_swapchain();
 }
 
+//M asks for a memory report, R for a splash in the ripples
+void Application::on_key_pressed(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+	Application *app = reinterpret_cast<Application *>(glfwGetWindowUserPointer(window));
+	if (key == GLFW_KEY_M && action == GLFW_PRESS)
+	{
+		app->m_memory_report_requested = true;
+	}
+	if (key == GLFW_KEY_R && action == GLFW_PRESS)
+	{
+		app->m_splash_requested = true;
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 ////
 ////							Selection Functions
@@ -1769,22 +2775,41 @@ VkSurfaceFormatKHR Application::choose_swapchain_surface_format(const std::vecto
 	return available_formats[0];
 }
 
-//selects the most suitable swapchain present mode
+//selects the present mode the config asks for, or the most suitable one
 VkPresentModeKHR Application::choose_swapchain_present_mode(const std::vector<VkPresentModeKHR> available_present_modes)
 {
 	info("Choosing present mode...");
+	if (m_config.present_mode != "auto")
+	{
+		VkPresentModeKHR requested_mode = VK_PRESENT_MODE_FIFO_KHR;
+		if (m_config.present_mode == "mailbox")
+			requested_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+		else if (m_config.present_mode == "immediate")
+			requested_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+		if (std::find(available_present_modes.begin(), available_present_modes.end(), requested_mode) != available_present_modes.end())
+		{
+			m_benchmark_result.present_mode = m_config.present_mode;
+			return requested_mode;
+		}
+		warn("Present mode ", m_config.present_mode, " is not available, choosing one instead");
+	}
+
 	VkPresentModeKHR optimal_mode = VK_PRESENT_MODE_FIFO_KHR;
+	m_benchmark_result.present_mode = "fifo";
 
 	for (const VkPresentModeKHR available_present_mode : available_present_modes)
 	{
 		if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
 		{
 			//best mode, return immediately
+			m_benchmark_result.present_mode = "mailbox";
 			return available_present_mode;
 		}
 		else if (available_present_mode == VK_PRESENT_MODE_IMMEDIATE_KHR)
 		{
 			optimal_mode = available_present_mode;
+			m_benchmark_result.present_mode = "immediate";
 		}
 	}
 	return optimal_mode;
@@ -1824,7 +2849,8 @@ VkExtent2D Application::choose_swapchain_extent(const VkSurfaceCapabilitiesKHR &
 
 #pragma region Clean Up
 
-//cleans up everything that depends ont he swapchain
+//cleans up everything that depends on the swapchain images
+//the swapchain itself is retired when the next one is created
 void Application::clean_up_swapchain()
 {
 	info("Cleaning up swapchain...");
@@ -1832,60 +2858,123 @@ void Application::clean_up_swapchain()
 	{
 		vkDestroyFramebuffer(m_logical_device, framebuffer, nullptr);
 	}
-	vkFreeCommandBuffers(m_logical_device, m_command_pool, static_cast<uint32_t>(m_command_buffers.size()), m_command_buffers.data());
-
-	vkDestroyPipeline(m_logical_device, m_graphics_pipeline, nullptr);
-	vkDestroyPipelineLayout(m_logical_device, m_pipeline_layout, nullptr);
-	vkDestroyRenderPass(m_logical_device, m_render_pass, nullptr);
 	for (VkImageView image_view : m_swapchain_image_views)
 	{
 		vkDestroyImageView(m_logical_device, image_view, nullptr);
 	}
-	vkDestroySwapchainKHR(m_logical_device, m_swapchain, nullptr);
 	succ("Swapchain cleaned successfully");
 }
 
 //destroys all vulkan objects and frees memory
-//called when the application is closed
+//called when the application is closed, or when a run failed part way through and only some of it exists,
+//destroying a null handle is fine for vulkan but a null device or instance is not
 void Application::clean_up()
 {
 	info("Cleaning up...");
+	//no pipeline must be built while everything gets destroyed
+	m_shader_reloader.stop();
+	//everything has been recorded by now
+	if (Profiler::is_enabled())
+	{
+		Profiler::get().write_chrome_trace(m_config.trace_path);
+	}
+
+	if (m_logical_device != VK_NULL_HANDLE)
+	{
+		//a frame that failed may still be executing
+		vkDeviceWaitIdle(m_logical_device);
+		clean_up_device();
+		m_logical_device = VK_NULL_HANDLE;
+	}
+	if (m_instance != VK_NULL_HANDLE)
+	{
+		if (callback != VK_NULL_HANDLE)
+		{
+			DestroyDebugReportCallbackEXT(m_instance, callback, nullptr);
+		}
+		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		vkDestroyInstance(m_instance, MemoryTracker::get().get_allocation_callbacks());
+		m_instance = VK_NULL_HANDLE;
+	}
+
+	if (m_window != nullptr)
+	{
+		glfwDestroyWindow(m_window);
+		m_window = nullptr;
+	}
+
+	m_buoyancy.reset();
+	m_time_sliced.reset();
+	m_sequence.reset();
+	m_ripples.reset();
+	delete m_ocean;
+	m_ocean = nullptr;
+	MemoryTracker::get().clear_host_bytes();
+
+	glfwTerminate();
+	succ("Cleanup complete");
+}
+
+//everything created from the logical device, the device included
+void Application::clean_up_device()
+{
+	m_gpu_timer.destroy();
+
 	clean_up_swapchain();
+	vkDestroySwapchainKHR(m_logical_device, m_swapchain, nullptr);
+	//headless the images are ours
+	for (size_t i = 0; i < m_offscreen_allocations.size(); i++)
+	{
+		vkDestroyImage(m_logical_device, m_swapchain_images[i], nullptr);
+		m_memory_allocator.free(m_offscreen_allocations[i]);
+	}
+
+	vkDestroyPipeline(m_logical_device, m_graphics_pipeline, nullptr);
+	if (m_pipeline_cache != VK_NULL_HANDLE)
+	{
+		save_pipeline_cache();
+		vkDestroyPipelineCache(m_logical_device, m_pipeline_cache, nullptr);
+	}
+	vkDestroyPipelineLayout(m_logical_device, m_pipeline_layout, nullptr);
+	vkDestroyRenderPass(m_logical_device, m_render_pass, nullptr);
 
 	vkDestroySampler(m_logical_device, m_texture_sampler, nullptr);
 	vkDestroyImageView(m_logical_device, m_texture_image_view, nullptr);
 
 	vkDestroyImage(m_logical_device, m_texture_image, nullptr);
-	vkFreeMemory(m_logical_device, m_texture_image_memory, nullptr);
+	m_memory_allocator.free(m_texture_image_allocation);
 
 	vkDestroyDescriptorPool(m_logical_device, m_descriptor_pool, nullptr);
 	vkDestroyDescriptorSetLayout(m_logical_device, m_descriptor_set_layout, nullptr);
 	vkDestroyBuffer(m_logical_device, m_uniform_buffer, nullptr);
-	vkFreeMemory(m_logical_device, m_uniform_buffer_memory, nullptr);
+	m_memory_allocator.free(m_uniform_buffer_allocation);
 
 	vkDestroyBuffer(m_logical_device, m_displacement_buffer, nullptr);
-	vkFreeMemory(m_logical_device, m_displacement_memory, nullptr);
+	m_memory_allocator.free(m_displacement_allocation);
+	vkDestroyBuffer(m_logical_device, m_wave_buffer, nullptr);
+	m_memory_allocator.free(m_wave_allocation);
+	if (m_parity_buffer != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(m_logical_device, m_parity_buffer, nullptr);
+		m_memory_allocator.free(m_parity_allocation);
+	}
+	m_ocean_compute.destroy();
+	m_ocean_texture.destroy();
 
 	vkDestroyBuffer(m_logical_device, m_index_buffer, nullptr);
-	vkFreeMemory(m_logical_device, m_index_buffer_memory, nullptr);
+	m_memory_allocator.free(m_index_buffer_allocation);
 	vkDestroyBuffer(m_logical_device, m_vertex_buffer, nullptr);
-	vkFreeMemory(m_logical_device, m_vertex_buffer_memory, nullptr);
+	m_memory_allocator.free(m_vertex_buffer_allocation);
+
+	m_upload_batcher.destroy();
+	m_memory_allocator.destroy();
 	vkDestroySemaphore(m_logical_device, m_render_finished_semaphore, nullptr);
 	vkDestroySemaphore(m_logical_device, m_image_available_semaphore, nullptr);
+	vkDestroyFence(m_logical_device, m_in_flight_fence, nullptr);
 
 	vkDestroyCommandPool(m_logical_device, m_command_pool, nullptr);
 
-	vkDestroyDevice(m_logical_device, nullptr);
-	DestroyDebugReportCallbackEXT(m_instance, callback, nullptr);
-	vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
-	vkDestroyInstance(m_instance, nullptr);
-
-	glfwDestroyWindow(m_window);
-
-	delete m_ocean;
-
-	glfwTerminate();
-	succ("Cleanup complete");
+	vkDestroyDevice(m_logical_device, MemoryTracker::get().get_allocation_callbacks());
 }
 
 #pragma endregion
\ No newline at end of file
@@ -12,7 +12,6 @@
 #include <array>
 #include <chrono>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #define GLM_FORCE_RADIANS
@@ -29,6 +28,21 @@
 #include "helper.hpp"
 #include "ocean.hpp"
 #include "displacement.hpp"
+#include "memory_allocator.hpp"
+#include "memory_tracker.hpp"
+#include "upload_batcher.hpp"
+#include "ocean_compute.hpp"
+#include "ocean_texture.hpp"
+#include "profiler.hpp"
+#include "clock.hpp"
+#include "config.hpp"
+#include "shader_reloader.hpp"
+#include "task_graph.hpp"
+#include "embedded_shaders.hpp"
+#include "buoyancy.hpp"
+#include "ripple_field.hpp"
+#include "time_sliced_waves.hpp"
+#include "displacement_sequence.hpp"
 
 //Vulkan works with queues to which commands need to be submitted.
 //commands can be recorded, stored and are executed when submitted to a queue.
@@ -41,6 +55,10 @@ struct QueueFamilyIndices
 	int graphics_family = -1;
 	//Index of a queue supporting presentation operations
 	int presentation_family = -1;
+	//Index of a queue for uploads, a transfer only family if there is one, the graphics family otherwise
+	int transfer_family = -1;
+	//Index of a queue for the simulation, a compute family without graphics if there is one, the graphics family otherwise
+	int compute_family = -1;
 
 	//Returns true if required queues are found
 	bool isComplete()
@@ -65,13 +83,39 @@ struct UniformBufferObject
 	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 projection;
+	//seconds the vertex shader evaluates the waves at
+	float time;
+	//std140 starts the vec3 of the lod at the next 16 bytes
+	float padding[3];
+	WaveLod lod;
+};
+
+//Frame times of a run with a fixed frame count, gpu times are negative if they could not be measured
+struct BenchmarkResult
+{
+	uint32_t frames = 0;
+	//the resolution that was rendered, lower than requested if the memory budget made it degrade
+	uint32_t resolution = 0;
+	double cpu_average_milliseconds = 0.0;
+	double cpu_min_milliseconds = 0.0;
+	double cpu_max_milliseconds = 0.0;
+	double gpu_average_milliseconds = -1.0;
+	double gpu_min_milliseconds = -1.0;
+	double gpu_max_milliseconds = -1.0;
+	//the present mode and simulation that were actually used, they fall back if the requested ones are not available
+	std::string present_mode;
+	std::string simulation;
 };
 
 //The main application
 class Application
 {
 public:
+	//call before run
+	void configure(const ApplicationConfig &config);
 	void run();
+	//filled by runs with a fixed frame count
+	const BenchmarkResult &get_benchmark_result();
 
 private:
 	const int WIDTH = 800;
@@ -79,66 +123,122 @@ private:
 	const char *WINDOW_TITLE = "Vulkan";
 	const char *APPLICATION_NAME = "Vulkan Playground";
 
-	bool m_enable_wireframe = true;
-
-	uint32_t m_ocean_resolution = 256;
-	float m_time = 0;
+	ApplicationConfig m_config;
+	BenchmarkResult m_benchmark_result;
 
-	Ocean* m_ocean;
+	//headless renders into offscreen images instead of a window
+	const uint32_t HEADLESS_IMAGE_COUNT = 2;
+	uint32_t m_headless_image_index = 0;
+	std::vector<Allocation> m_offscreen_allocations;
 
-	GLFWwindow *m_window;
+	float m_time = 0;
+	//which waves the frame at m_time evaluates where, the same for every way of simulating
+	WaveLod m_wave_lod = {};
+	std::unique_ptr<SimulationClock> m_clock = std::make_unique<WallClock>();
+
+	Ocean* m_ocean = nullptr;
+	//floating bodies, only there if the config asks for some
+	std::unique_ptr<BuoyancySimulation> m_buoyancy;
+	//spreads the cpu simulation of distant water over several frames, only there if the config gives it a budget
+	std::unique_ptr<TimeSlicedWaves> m_time_sliced;
+	//baked displacement played back instead of any simulation, only there if the config names a sequence
+	std::unique_ptr<DisplacementSequence> m_sequence;
+	//wakes and splashes on top of the waves, only there if the config asks for them
+	std::unique_ptr<RippleField> m_ripples;
+
+	GLFWwindow *m_window = nullptr;
 
 	//basics
 
-	VkInstance m_instance;
+	VkInstance m_instance = VK_NULL_HANDLE;
 	VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
-	VkDevice m_logical_device;
+	VkDevice m_logical_device = VK_NULL_HANDLE;
 
 	//queues
 
+	QueueFamilyIndices m_queue_family_indices;
 	VkQueue m_graphics_queue;
 	VkQueue m_presentation_queue;
+	VkQueue m_transfer_queue;
+	VkQueue m_compute_queue;
 
-	VkDebugReportCallbackEXT callback;
+	VkDebugReportCallbackEXT callback = VK_NULL_HANDLE;
 
-	VkSurfaceKHR m_surface;
-	VkSwapchainKHR m_swapchain;
-	VkFormat m_swapchain_image_format;
+	VkSurfaceKHR m_surface = VK_NULL_HANDLE;
+	VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
+	VkFormat m_swapchain_image_format = VK_FORMAT_UNDEFINED;
 	VkExtent2D m_swapchain_extent;
-	VkRenderPass m_render_pass;
-	VkDescriptorSetLayout m_descriptor_set_layout;
-	VkPipelineLayout m_pipeline_layout;
-	VkPipeline m_graphics_pipeline;
+	VkRenderPass m_render_pass = VK_NULL_HANDLE;
+	VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+	VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+	VkPipeline m_graphics_pipeline = VK_NULL_HANDLE;
+	//kept on disk between runs, so pipelines build faster the second time
+	VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
+	const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
+	//rebuilds the graphics and compute pipelines in the background when a shader changes
+	ShaderReloader m_shader_reloader;
+	uint32_t m_graphics_reload = ShaderReloader::NO_PIPELINE;
+	uint32_t m_compute_reload = ShaderReloader::NO_PIPELINE;
+	//held while a pipeline is built, the render pass it is built against must not change meanwhile
+	std::mutex m_pipeline_mutex;
 
 	//buffers, images and pools
 
-	VkCommandPool m_command_pool;
-	VkBuffer m_vertex_buffer;
-	VkDeviceMemory m_vertex_buffer_memory;
-	VkBuffer m_index_buffer;
-	VkDeviceMemory m_index_buffer_memory;
-
-	VkBuffer m_displacement_buffer;
-	VkDeviceMemory m_displacement_memory;
-
-	VkBuffer m_uniform_buffer;
-	VkDeviceMemory m_uniform_buffer_memory;
-	VkDescriptorPool m_descriptor_pool;
+	MemoryAllocator m_memory_allocator;
+	UploadBatcher m_upload_batcher;
+
+	VkCommandPool m_command_pool = VK_NULL_HANDLE;
+	VkBuffer m_vertex_buffer = VK_NULL_HANDLE;
+	Allocation m_vertex_buffer_allocation;
+	VkBuffer m_index_buffer = VK_NULL_HANDLE;
+	Allocation m_index_buffer_allocation;
+
+	VkBuffer m_displacement_buffer = VK_NULL_HANDLE;
+	Allocation m_displacement_allocation;
+
+	//simulates the displacement on the gpu if the compute shader is available, otherwise the cpu does it
+	OceanCompute m_ocean_compute;
+	bool m_gpu_simulation = false;
+	//the vertex shader evaluates the waves from the wave buffer, nothing but the time is uploaded per frame
+	bool m_vertex_simulation = false;
+	//the displacement and normals are simulated into maps the shaders sample, the mesh can have any resolution then
+	bool m_texture_simulation = false;
+	//the maps of the texture simulation, a flat placeholder for the others, the pipeline always declares them
+	OceanTexture m_ocean_texture;
+	VkBuffer m_wave_buffer = VK_NULL_HANDLE;
+	Allocation m_wave_allocation;
+	//what the vertex shader evaluated in the last frame, only during a parity check
+	VkBuffer m_parity_buffer = VK_NULL_HANDLE;
+	Allocation m_parity_allocation;
+	//largest difference between the cpu and the vertex shader seen so far, relative to the largest possible displacement
+	float m_parity_max_error = 0.0f;
+	const float PARITY_TOLERANCE = 1e-3f;
+
+	VkBuffer m_uniform_buffer = VK_NULL_HANDLE;
+	Allocation m_uniform_buffer_allocation;
+	VkDescriptorPool m_descriptor_pool = VK_NULL_HANDLE;
 	VkDescriptorSet m_descriptor_set;
-	VkImage m_texture_image;
-	VkDeviceMemory m_texture_image_memory;
-	VkImageView m_texture_image_view;
-	VkSampler m_texture_sampler;
+	VkImage m_texture_image = VK_NULL_HANDLE;
+	Allocation m_texture_image_allocation;
+	VkImageView m_texture_image_view = VK_NULL_HANDLE;
+	VkSampler m_texture_sampler = VK_NULL_HANDLE;
+	//what the samplers ask for, 1 if the device or the config do not want anisotropic filtering
+	float m_max_anisotropy = 1.0f;
 
 	std::vector<VkImage> m_swapchain_images;
 	std::vector<VkImageView> m_swapchain_image_views;
 	std::vector<VkFramebuffer> m_swapchain_framebuffers;
-	std::vector<VkCommandBuffer> m_command_buffers;
+	VkCommandBuffer m_command_buffer;
 
 	//semaphores
 
-	VkSemaphore m_image_available_semaphore;
-	VkSemaphore m_render_finished_semaphore;
+	VkSemaphore m_image_available_semaphore = VK_NULL_HANDLE;
+	VkSemaphore m_render_finished_semaphore = VK_NULL_HANDLE;
+	VkFence m_in_flight_fence = VK_NULL_HANDLE;
+
+	//measures the frame on the gpu, the command buffer is only recorded once the last frame is done, so one set is enough
+	GpuTimer m_gpu_timer;
 #ifdef _DEBUG
 	const std::vector<const char *> validation_layers = {
 		"VK_LAYER_LUNARG_standard_validation", "VK_LAYER_LUNARG_monitor"
@@ -147,7 +247,15 @@ private:
 	const std::vector<const char *> validation_layers = {};
 #endif // !DEBUG
 
-	const std::vector<const char *> device_extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+	std::vector<const char *> device_extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+	//heap budgets need both, the device extension is only enabled if the instance one is
+	bool m_physical_device_properties_2_enabled = false;
+	bool m_memory_budget_enabled = false;
+	//set by pressing M, the report is printed between frames
+	bool m_memory_report_requested = false;
+	//set by pressing R, drops a splash into the ripples next frame
+	bool m_splash_requested = false;
 
 	std::vector<Vertex> m_vertices = {
 		{ { -0.5f, -0.5f, 1.0f },{ 1.0f, 0.0f, 0.0f },{ 1.0f, 0.0f } },
@@ -168,11 +276,25 @@ private:
 
 	//application lifecycle
 	void configure_application();
+	void generate_ocean();
+	//memory a plane of that resolution needs on host and device, roughly
+	size_t estimate_memory(uint32_t resolution);
+	//publishes the sizes of the big host side copies to the memory tracker
+	void track_host_copies();
 
+	void initialize();
 	void initialize_window();
-	void initialize_vulkan();
 	void main_loop();
+	void benchmark_loop();
 	void clean_up();
+	void clean_up_device();
+
+	//one iteration of the loops
+	void run_frame();
+	//moves the ripples along, lets them spread and adds them to the cpu displacement
+	void update_ripples(float delta_time);
+	//compares the displacement the vertex shader wrote in the last frame with the cpu waves, waits for the frame
+	void check_parity();
 
 	//Initialization stuff
 
@@ -181,11 +303,25 @@ private:
 	void create_surface();
 	void pick_physical_device();
 	void create_logical_device();
+	void create_memory_allocator();
 	void create_swapchain();
 	void create_image_views();
 	void create_render_pass();
 	void create_descriptor_set_layout();
+	void create_pipeline_layout();
+	void create_pipeline_cache();
+	void save_pipeline_cache();
 	void create_graphics_pipeline();
+	//the spir-v of the stages of the graphics pipeline
+	struct GraphicsShaderCode
+	{
+		ShaderCode vert;
+		ShaderCode geom;
+		ShaderCode frag;
+	};
+	//builds a pipeline from the shaders, safe to call from another thread while holding m_pipeline_mutex
+	VkPipeline build_graphics_pipeline(const GraphicsShaderCode &code);
+	void start_shader_reloading();
 	void create_framebuffers();
 	void create_command_pool();
 
@@ -201,6 +337,9 @@ private:
 	void create_index_buffer();
 
 	void create_displacement_buffer();
+	void create_ocean_compute();
+	void create_ocean_texture();
+	void create_wave_buffer();
 
 	//descriptors
 
@@ -211,7 +350,8 @@ private:
 	//command buffers
 
 	void create_command_buffers();
-	void create_semaphores();
+	void record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index);
+	void create_sync_objects();
 
 	//update stuff
 
@@ -223,9 +363,15 @@ private:
 	void recreate_swapchain();
 	void clean_up_swapchain();
 
+	//headless
+
+	void create_offscreen_images();
+	void dump_frame(uint32_t image_index, uint32_t frame);
+
 	//window input reactions
 
 	static void on_window_resized(GLFWwindow *window, int width, int height);
+	static void on_key_pressed(GLFWwindow *window, int key, int scancode, int action, int mods);
 
 	std::vector<const char *> get_required_instance_extensions();
 
@@ -234,6 +380,8 @@ private:
 	bool check_extension_support(std::vector<const char *> required_extensions, std::vector<VkExtensionProperties> supported_extensions);
 	bool check_instance_extension_support(std::vector<const char *> required_extensions);
 	bool check_device_extension_support(VkPhysicalDevice physical_device);
+	bool is_instance_extension_supported(const char *extension);
+	bool is_device_extension_supported(VkPhysicalDevice physical_device, const char *extension);
 
 	//evaluations and selections
 	int evaluate_physical_device_capabilities(VkPhysicalDevice device);
@@ -242,16 +390,13 @@ private:
 	VkSurfaceFormatKHR choose_swapchain_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats);
 	VkPresentModeKHR choose_swapchain_present_mode(const std::vector<VkPresentModeKHR> available_present_modes);
 	VkExtent2D choose_swapchain_extent(const VkSurfaceCapabilitiesKHR &capabilities);
-	uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties);
 
 	//creation and transformation helpers
-	VkShaderModule create_shader_module(const std::vector<char> &code);
+	VkShaderModule create_shader_module(const ShaderCode &code);
 	void transition_image_layout(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout);
-	void copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-	void create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory);
-	void create_image(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &image_memory);
+	void create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, Allocation &allocation, MemoryCategory category = MemoryCategory::other);
+	void create_image(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, Allocation &allocation, MemoryCategory category = MemoryCategory::other);
 	VkImageView create_image_view(VkImage image, VkFormat format);
-	void copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size);
 
 	//buffer recording helpers
 	VkCommandBuffer begin_single_time_commands();
@@ -0,0 +1,258 @@
+#include "buoyancy.hpp"
+
+//turns v by the unit quaternion q
+static glm::vec3 rotate(const glm::vec4 &q, const glm::vec3 &v)
+{
+	glm::vec3 axis(q.x, q.y, q.z);
+	glm::vec3 t = 2.0f * glm::cross(axis, v);
+	return v + q.w * t + glm::cross(axis, t);
+}
+
+//turns q by the angular velocity w for the given time and keeps it a unit quaternion
+static glm::vec4 integrate_orientation(const glm::vec4 &q, const glm::vec3 &w, float delta_time)
+{
+	//dq/dt = 0.5 * (w, 0) * q
+	float h = 0.5f * delta_time;
+	glm::vec4 turned(
+		q.x + h * (w.x * q.w + w.y * q.z - w.z * q.y),
+		q.y + h * (w.y * q.w + w.z * q.x - w.x * q.z),
+		q.z + h * (w.z * q.w + w.x * q.y - w.y * q.x),
+		q.w - h * (w.x * q.x + w.y * q.y + w.z * q.z));
+	float length = sqrtf(turned.x * turned.x + turned.y * turned.y + turned.z * turned.z + turned.w * turned.w);
+	return glm::vec4(turned.x / length, turned.y / length, turned.z / length, turned.w / length);
+}
+
+BuoyancySimulation::BuoyancySimulation(Ocean *ocean) : m_ocean(ocean)
+{
+}
+
+size_t BuoyancySimulation::add_body(const BodyDescription &body)
+{
+	if (body.hull_points.empty() || body.mass <= 0.0f)
+	{
+		throw std::runtime_error("A floating body needs a mass and at least one hull point");
+	}
+
+	float inertia = 0.0f;
+	for (const glm::vec3 &point : body.hull_points)
+	{
+		inertia += body.mass / body.hull_points.size() * glm::dot(point, point);
+	}
+
+	m_position.push_back(body.position);
+	m_velocity.push_back(glm::vec3(0.0f));
+	m_orientation.push_back(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	m_angular_velocity.push_back(glm::vec3(0.0f));
+	m_inverse_mass.push_back(1.0f / body.mass);
+	m_inverse_inertia.push_back(1.0f / std::max(inertia, 1e-6f));
+	m_point_volume.push_back(body.point_volume);
+	m_point_height.push_back(body.point_height);
+	m_submerged_fraction.push_back(0.0f);
+	m_first_point.push_back(static_cast<uint32_t>(m_hull_points.size()));
+	m_point_count.push_back(static_cast<uint32_t>(body.hull_points.size()));
+	m_hull_points.insert(m_hull_points.end(), body.hull_points.begin(), body.hull_points.end());
+	return m_position.size() - 1;
+}
+
+//a hull is a box of sample points, one in the middle of every cell of a grid over it
+static BodyDescription box_body(glm::vec3 size, uint32_t points_x, uint32_t points_y, uint32_t points_z, float density)
+{
+	BodyDescription body;
+	for (uint32_t x = 0; x < points_x; x++)
+		for (uint32_t y = 0; y < points_y; y++)
+			for (uint32_t z = 0; z < points_z; z++)
+			{
+				body.hull_points.push_back(glm::vec3(
+					((x + 0.5f) / points_x - 0.5f) * size.x,
+					((y + 0.5f) / points_y - 0.5f) * size.y,
+					((z + 0.5f) / points_z - 0.5f) * size.z));
+			}
+	float volume = size.x * size.y * size.z;
+	body.point_volume = volume / body.hull_points.size();
+	body.point_height = size.z / points_z;
+	body.mass = density * volume;
+	return body;
+}
+
+void BuoyancySimulation::add_test_bodies(uint32_t count, float area, uint32_t seed)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> position(-0.5f * area, 0.5f * area);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		//every fourth body is a boat, the rest is debris, both half as dense as water
+		BodyDescription body = i % 4 == 0 ? box_body(glm::vec3(6.0f, 2.5f, 1.5f), 4, 2, 2, 0.5f * WATER_DENSITY) : box_body(glm::vec3(1.0f), 2, 2, 2, 0.5f * WATER_DENSITY);
+		body.position = glm::vec3(position(generator), position(generator), 0.0f);
+		add_body(body);
+	}
+}
+
+//the calling thread takes chunks as well, so a small scene never starts a thread
+void BuoyancySimulation::step(float time, float delta_time)
+{
+	PROFILE_FUNCTION();
+	if (m_position.empty() || delta_time <= 0.0f)
+		return;
+
+	//the waves are copied once per step, so the ocean can change while the chunks run
+	SurfaceQuery query = m_ocean->create_surface_query();
+
+	size_t body_count = m_position.size();
+	size_t chunk_count = (body_count + BODIES_PER_CHUNK - 1) / BODIES_PER_CHUNK;
+	std::atomic<size_t> next_chunk(0);
+	auto work = [&]()
+	{
+		for (size_t chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++)
+		{
+			size_t first_body = chunk * BODIES_PER_CHUNK;
+			step_chunk(query, first_body, std::min(BODIES_PER_CHUNK, body_count - first_body), time, delta_time);
+		}
+	};
+
+	size_t worker_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), chunk_count) - 1;
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < worker_count; i++)
+	{
+		workers.emplace_back(work);
+	}
+	work();
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void BuoyancySimulation::step_chunk(const SurfaceQuery &query, size_t first_body, size_t body_count, float time, float delta_time)
+{
+	size_t first_point = m_first_point[first_body];
+	size_t last_body = first_body + body_count - 1;
+	size_t point_count = m_first_point[last_body] + m_point_count[last_body] - first_point;
+
+	//where the hull points are now, relative to their body and in the world
+	std::vector<glm::vec3> offsets(point_count);
+	std::vector<glm::vec2> positions(point_count);
+	for (size_t body = first_body; body <= last_body; body++)
+	{
+		for (uint32_t i = 0; i < m_point_count[body]; i++)
+		{
+			size_t point = m_first_point[body] + i - first_point;
+			offsets[point] = rotate(m_orientation[body], m_hull_points[m_first_point[body] + i]);
+			glm::vec3 world = m_position[body] + offsets[point];
+			positions[point] = glm::vec2(world.x, world.y);
+		}
+	}
+
+	std::vector<WaterSample> samples(point_count);
+	query.sample_range(positions.data(), point_count, time, samples.data());
+
+	for (size_t body = first_body; body <= last_body; body++)
+	{
+		glm::vec3 force(0.0f, 0.0f, -GRAVITY / m_inverse_mass[body]);
+		glm::vec3 torque(0.0f);
+		float submerged = 0.0f;
+		for (uint32_t i = 0; i < m_point_count[body]; i++)
+		{
+			size_t point = m_first_point[body] + i - first_point;
+			const glm::vec3 &offset = offsets[point];
+			float depth = samples[point].height - (m_position[body].z + offset.z);
+			//the point sits in the middle of its slice
+			float fraction = std::min(std::max(depth / m_point_height[body] + 0.5f, 0.0f), 1.0f);
+			if (fraction <= 0.0f)
+				continue;
+
+			float displaced_mass = WATER_DENSITY * m_point_volume[body] * fraction;
+			glm::vec3 point_velocity = m_velocity[body] + glm::cross(m_angular_velocity[body], offset);
+			glm::vec3 point_force = glm::vec3(0.0f, 0.0f, displaced_mass * GRAVITY) + displaced_mass * WATER_DRAG * (samples[point].velocity - point_velocity);
+			force += point_force;
+			torque += glm::cross(offset, point_force);
+			submerged += fraction;
+		}
+		m_submerged_fraction[body] = submerged / m_point_count[body];
+
+		//semi implicit euler, velocities first
+		m_velocity[body] += force * (m_inverse_mass[body] * delta_time);
+		m_position[body] += m_velocity[body] * delta_time;
+		m_angular_velocity[body] += torque * (m_inverse_inertia[body] * delta_time);
+		m_angular_velocity[body] *= std::max(1.0f - ANGULAR_DAMPING * delta_time, 0.0f);
+		m_orientation[body] = integrate_orientation(m_orientation[body], m_angular_velocity[body], delta_time);
+	}
+}
+
+size_t BuoyancySimulation::get_body_count() const
+{
+	return m_position.size();
+}
+
+glm::vec3 BuoyancySimulation::get_position(size_t body) const
+{
+	return m_position[body];
+}
+
+glm::vec3 BuoyancySimulation::get_velocity(size_t body) const
+{
+	return m_velocity[body];
+}
+
+glm::vec4 BuoyancySimulation::get_orientation(size_t body) const
+{
+	return m_orientation[body];
+}
+
+float BuoyancySimulation::get_submerged_fraction(size_t body) const
+{
+	return m_submerged_fraction[body];
+}
+
+//the bodies start level with the undisturbed surface, the first seconds they settle and are not counted
+void run_buoyancy_benchmark(const ApplicationConfig &config)
+{
+	uint32_t body_count = config.bodies == 0 ? 500 : config.bodies;
+	uint32_t ticks = config.frame_count == 0 ? 1000 : config.frame_count;
+	float delta_time = config.fixed_step > 0.0f ? config.fixed_step : 1.0f / 60.0f;
+	uint32_t settle_ticks = std::min(ticks / 2, static_cast<uint32_t>(5.0f / delta_time));
+	//the results go straight to the console, release builds compile info and succ out
+	flush_log();
+	std::cout << "Buoyancy benchmark: " << body_count << " bodies, " << ticks << " ticks of " << delta_time * 1000.0f << "ms" << std::endl;
+
+	Ocean ocean(config.resolution, static_cast<float>(config.resolution), config.wave_count, create_spectrum_parameters(config));
+	BuoyancySimulation simulation(&ocean);
+	simulation.add_test_bodies(body_count, static_cast<float>(config.resolution), config.seed);
+
+	double total_milliseconds = 0.0;
+	double slowest_milliseconds = 0.0;
+	double submerged_sum = 0.0;
+	size_t submerged_samples = 0;
+	//how many ticks in a row each body has been fully under water, a wave can bury one for a moment
+	std::vector<uint32_t> ticks_under_water(body_count, 0);
+	uint32_t sunk_ticks = static_cast<uint32_t>(1.0f / delta_time);
+	for (uint32_t tick = 0; tick < ticks; tick++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		simulation.step((tick + 1) * delta_time, delta_time);
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (tick < settle_ticks)
+			continue;
+
+		total_milliseconds += milliseconds;
+		slowest_milliseconds = std::max(slowest_milliseconds, milliseconds);
+		for (size_t body = 0; body < simulation.get_body_count(); body++)
+		{
+			float fraction = simulation.get_submerged_fraction(body);
+			submerged_sum += fraction;
+			ticks_under_water[body] = fraction >= 1.0f ? ticks_under_water[body] + 1 : 0;
+		}
+		submerged_samples += simulation.get_body_count();
+	}
+	//a body that has not come up for a second went down
+	size_t sunk = std::count_if(ticks_under_water.begin(), ticks_under_water.end(), [sunk_ticks](uint32_t ticks) { return ticks >= sunk_ticks; });
+
+	uint32_t measured_ticks = ticks - settle_ticks;
+	flush_log();
+	std::cout << "Buoyancy tick: " << total_milliseconds / std::max(measured_ticks, 1u) << "ms on average, " << slowest_milliseconds << "ms at most" << std::endl;
+	std::cout << "Bodies were " << 100.0 * submerged_sum / std::max<size_t>(submerged_samples, 1) << "% submerged on average, half as dense as water they should be about 50%" << std::endl;
+	if (sunk > 0)
+	{
+		throw std::runtime_error(std::to_string(sunk) + " of " + std::to_string(body_count) + " bodies sank");
+	}
+	std::cout << "All " << body_count << " bodies stayed afloat" << std::endl;
+}
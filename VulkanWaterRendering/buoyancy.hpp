@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "ocean.hpp"
+#include "surface_query.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+//How a floating body is built, in world units with z up
+struct BodyDescription
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	float mass = 1.0f;
+	//sample points of the hull relative to the center of mass, each stands for the slice of hull around it
+	std::vector<glm::vec3> hull_points;
+	//water a point displaces when its slice is fully under water
+	float point_volume = 1.0f;
+	//how tall the slice around a point is, it goes under gradually over this height
+	float point_height = 1.0f;
+};
+
+//Rigid bodies floating on the ocean.
+//Every hull point below the surface pushes its body up by the weight of the water it displaces and drags it along with
+//the water, both act at the point and also turn the body. The bodies live in arrays of their properties, so a step
+//walks through memory in order, and are stepped in chunks on worker threads. Each chunk asks the ocean about all of its
+//hull points in one batch.
+class BuoyancySimulation
+{
+public:
+	static const size_t BODIES_PER_CHUNK = 64;
+	static constexpr float WATER_DENSITY = 1000.0f;
+	static constexpr float GRAVITY = 9.81f;
+	//per second, how quickly submerged points take on the velocity of the water around them
+	static constexpr float WATER_DRAG = 5.0f;
+	//per second, keeps bodies from spinning forever, water would
+	static constexpr float ANGULAR_DAMPING = 0.5f;
+
+	BuoyancySimulation(Ocean *ocean);
+
+	size_t add_body(const BodyDescription &body);
+	//boats and debris spread over a square of the given size around the origin, all floating about half submerged
+	void add_test_bodies(uint32_t count, float area, uint32_t seed);
+
+	//moves every body delta_time seconds forward, to the given time of the waves
+	void step(float time, float delta_time);
+
+	size_t get_body_count() const;
+	glm::vec3 get_position(size_t body) const;
+	glm::vec3 get_velocity(size_t body) const;
+	//quaternion as x, y, z, w
+	glm::vec4 get_orientation(size_t body) const;
+	//share of the hull volume below the surface after the last step
+	float get_submerged_fraction(size_t body) const;
+
+private:
+	Ocean *m_ocean;
+
+	//one entry per body
+	std::vector<glm::vec3> m_position;
+	std::vector<glm::vec3> m_velocity;
+	std::vector<glm::vec4> m_orientation;
+	std::vector<glm::vec3> m_angular_velocity;
+	std::vector<float> m_inverse_mass;
+	//the inertia as if the mass sat on the hull points, the same around every axis
+	std::vector<float> m_inverse_inertia;
+	std::vector<float> m_point_volume;
+	std::vector<float> m_point_height;
+	std::vector<float> m_submerged_fraction;
+	std::vector<uint32_t> m_first_point;
+	std::vector<uint32_t> m_point_count;
+
+	//the hull points of all bodies back to back
+	std::vector<glm::vec3> m_hull_points;
+
+	void step_chunk(const SurfaceQuery &query, size_t first_body, size_t body_count, float time, float delta_time);
+};
+
+//Steps a scene of floating bodies for the configured number of ticks without rendering anything
+//and reports how long a tick takes and whether the bodies stayed afloat
+void run_buoyancy_benchmark(const ApplicationConfig &config);
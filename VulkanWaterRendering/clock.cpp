@@ -0,0 +1,75 @@
+#include "clock.hpp"
+
+//starts counting on the first frame, so initialization time does not count as simulated time
+float WallClock::next_frame()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	if (!m_started)
+	{
+		m_start = now;
+		m_started = true;
+	}
+	return std::chrono::duration<float, std::chrono::seconds::period>(now - m_start).count();
+}
+
+FixedStepClock::FixedStepClock(float step) : m_step(step)
+{
+}
+
+//multiplies instead of adding up, so there is no rounding error piling up over long runs
+float FixedStepClock::next_frame()
+{
+	return static_cast<float>(m_frame++ * static_cast<double>(m_step));
+}
+
+//reads the whole log up front, so replaying does not touch the disk
+ReplayClock::ReplayClock(const std::string &path)
+{
+	info("Reading time log ", path, "...");
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open time log");
+	}
+	float time;
+	while (file >> time)
+	{
+		m_times.push_back(time);
+	}
+	if (m_times.empty())
+	{
+		throw std::runtime_error("time log is empty");
+	}
+	succ(m_times.size(), " frame times read");
+}
+
+float ReplayClock::next_frame()
+{
+	size_t frame = m_frame++;
+	if (frame < m_times.size())
+		return m_times[frame];
+
+	if (frame == m_times.size())
+	{
+		warn("Time log exhausted, continuing with the last step");
+	}
+	float step = m_times.size() > 1 ? m_times.back() - m_times[m_times.size() - 2] : 0.0f;
+	return m_times.back() + step * (frame - m_times.size() + 1);
+}
+
+RecordingClock::RecordingClock(std::unique_ptr<SimulationClock> clock, const std::string &path) : m_clock(std::move(clock)), m_file(path)
+{
+	if (!m_file.is_open())
+	{
+		throw std::runtime_error("failed to open time log for writing");
+	}
+	//enough digits to read back the exact same float
+	m_file.precision(std::numeric_limits<float>::max_digits10);
+}
+
+float RecordingClock::next_frame()
+{
+	float time = m_clock->next_frame();
+	m_file << time << '\n';
+	return time;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "logger.hpp"
+
+//Decides which point in time each frame simulates.
+//The application asks once per frame, the answer is in seconds since the start of the simulation.
+class SimulationClock
+{
+public:
+	virtual ~SimulationClock() = default;
+	virtual float next_frame() = 0;
+};
+
+//Real time passed since the first frame, what an interactive run wants
+class WallClock : public SimulationClock
+{
+public:
+	float next_frame() override;
+
+private:
+	bool m_started = false;
+	std::chrono::high_resolution_clock::time_point m_start;
+};
+
+//Advances by the same step every frame, no matter how long the frame took.
+//Every run simulates exactly the same times, so results can be compared between runs.
+class FixedStepClock : public SimulationClock
+{
+public:
+	FixedStepClock(float step);
+	float next_frame() override;
+
+private:
+	float m_step;
+	uint64_t m_frame = 0;
+};
+
+//Plays back the times of an earlier run, one time per line.
+//Once the log runs out it keeps going with the last step.
+class ReplayClock : public SimulationClock
+{
+public:
+	ReplayClock(const std::string &path);
+	float next_frame() override;
+
+private:
+	std::vector<float> m_times;
+	size_t m_frame = 0;
+};
+
+//Passes the times of another clock through and writes them to a file a ReplayClock can read
+class RecordingClock : public SimulationClock
+{
+public:
+	RecordingClock(std::unique_ptr<SimulationClock> clock, const std::string &path);
+	float next_frame() override;
+
+private:
+	std::unique_ptr<SimulationClock> m_clock;
+	std::ofstream m_file;
+};
@@ -0,0 +1,355 @@
+#include "config.hpp"
+
+bool ApplicationConfig::is_sweep() const
+{
+	return !sweep_resolutions.empty() || !sweep_wave_counts.empty() || !sweep_present_modes.empty() || !sweep_simulations.empty();
+}
+
+//options that can be given on the command line without a value
+static bool is_flag(const std::string &key)
+{
+	return key == "headless" || key == "wireframe" || key == "interactive" || key == "memory-report" || key == "hot-reload" || key == "parity-check" || key == "buoyancy-benchmark" || key == "loop-cache" || key == "coarse-grid-report";
+}
+
+static uint32_t parse_unsigned(const std::string &key, const std::string &value)
+{
+	char *end = nullptr;
+	unsigned long number = std::strtoul(value.c_str(), &end, 10);
+	if (value.empty() || *end != '\0')
+	{
+		throw std::runtime_error("Option " + key + " expects a number, got \"" + value + "\"");
+	}
+	return static_cast<uint32_t>(number);
+}
+
+static float parse_float(const std::string &key, const std::string &value)
+{
+	char *end = nullptr;
+	float number = std::strtof(value.c_str(), &end);
+	if (value.empty() || *end != '\0')
+	{
+		throw std::runtime_error("Option " + key + " expects a number, got \"" + value + "\"");
+	}
+	return number;
+}
+
+static bool parse_bool(const std::string &key, const std::string &value)
+{
+	if (value == "true" || value == "on" || value == "yes" || value == "1")
+		return true;
+	if (value == "false" || value == "off" || value == "no" || value == "0")
+		return false;
+	throw std::runtime_error("Option " + key + " expects true or false, got \"" + value + "\"");
+}
+
+//splits a comma separated list
+static std::vector<std::string> parse_list(const std::string &value)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(value);
+	std::string item;
+	while (std::getline(stream, item, ','))
+	{
+		if (!item.empty())
+		{
+			items.push_back(item);
+		}
+	}
+	return items;
+}
+
+static std::vector<uint32_t> parse_unsigned_list(const std::string &key, const std::string &value)
+{
+	std::vector<uint32_t> numbers;
+	for (const std::string &item : parse_list(value))
+	{
+		numbers.push_back(parse_unsigned(key, item));
+	}
+	return numbers;
+}
+
+static void check_choice(const std::string &key, const std::string &value, const std::vector<std::string> &choices)
+{
+	for (const std::string &choice : choices)
+	{
+		if (value == choice)
+			return;
+	}
+	throw std::runtime_error("Option " + key + " does not know \"" + value + "\"");
+}
+
+void apply_option(ApplicationConfig &config, const std::string &key, const std::string &value)
+{
+	if (key == "resolution")
+	{
+		config.resolution = parse_unsigned(key, value);
+		if (config.resolution <= 1)
+		{
+			throw std::runtime_error("Number is unfit for grid creation");
+		}
+	}
+	else if (key == "waves")
+		config.wave_count = parse_unsigned(key, value);
+	else if (key == "spectrum")
+	{
+		check_choice(key, value, { "none", "pm", "jonswap" });
+		config.spectrum = value;
+	}
+	else if (key == "wind-speed")
+		config.wind_speed = parse_float(key, value);
+	else if (key == "wind-direction")
+		config.wind_direction = parse_float(key, value);
+	else if (key == "fetch")
+		config.fetch = parse_float(key, value);
+	else if (key == "spread")
+		config.spread = parse_float(key, value);
+	else if (key == "choppiness")
+		config.choppiness = parse_float(key, value);
+	else if (key == "seed")
+		config.seed = parse_unsigned(key, value);
+	else if (key == "wave-lod")
+		config.wave_lod = parse_float(key, value);
+	else if (key == "wireframe")
+		config.wireframe = parse_bool(key, value);
+	else if (key == "shading")
+	{
+		check_choice(key, value, { "lit", "normals" });
+		config.shading = value;
+	}
+	else if (key == "simulation")
+	{
+		check_choice(key, value, { "auto", "gpu", "vertex", "texture", "cpu" });
+		config.simulation = value;
+	}
+	else if (key == "texture-resolution")
+	{
+		config.texture_resolution = parse_unsigned(key, value);
+		if (config.texture_resolution == 0 || (config.texture_resolution & (config.texture_resolution - 1)) != 0)
+			throw std::runtime_error("Option " + key + " expects a power of 2, got \"" + value + "\"");
+	}
+	else if (key == "anisotropy")
+		config.anisotropy = parse_float(key, value);
+	else if (key == "present-mode")
+	{
+		check_choice(key, value, { "auto", "mailbox", "fifo", "immediate" });
+		config.present_mode = value;
+	}
+	else if (key == "parity-check")
+		config.parity_check = parse_bool(key, value);
+	else if (key == "coarse-grid")
+	{
+		check_choice(key, value, { "1", "2", "4", "8" });
+		config.coarse_grid = parse_unsigned(key, value);
+	}
+	else if (key == "coarse-grid-report")
+		config.coarse_grid_report = parse_bool(key, value);
+	else if (key == "loop-period")
+		config.loop_period = parse_float(key, value);
+	else if (key == "loop-cache")
+		config.loop_cache = parse_bool(key, value);
+	else if (key == "loop-frame-rate")
+		config.loop_frame_rate = parse_float(key, value);
+	else if (key == "loop-cache-megabytes")
+		config.loop_cache_megabytes = parse_unsigned(key, value);
+	else if (key == "slice-budget")
+		config.slice_budget = parse_unsigned(key, value);
+	else if (key == "ripples")
+		config.ripple_size = parse_unsigned(key, value);
+	else if (key == "bodies")
+		config.bodies = parse_unsigned(key, value);
+	else if (key == "buoyancy-benchmark")
+		config.buoyancy_benchmark = parse_bool(key, value);
+	else if (key == "bake")
+		config.bake_path = value;
+	else if (key == "bake-delta")
+		config.bake_delta = parse_bool(key, value);
+	else if (key == "sequence")
+		config.sequence_path = value;
+	else if (key == "hot-reload")
+		config.hot_reload = parse_bool(key, value);
+	else if (key == "interactive")
+		config.interactive = parse_bool(key, value);
+	else if (key == "frames")
+		config.frame_count = parse_unsigned(key, value);
+	else if (key == "headless")
+		config.headless = parse_bool(key, value);
+	else if (key == "dump")
+		config.dump_frames.push_back(parse_unsigned(key, value));
+	else if (key == "timings")
+		config.timings_path = value;
+	else if (key == "trace")
+		config.trace_path = value;
+	else if (key == "memory-budget")
+		config.memory_budget_megabytes = parse_unsigned(key, value);
+	else if (key == "memory-budget-policy")
+	{
+		check_choice(key, value, { "refuse", "degrade" });
+		config.memory_budget_policy = value;
+	}
+	else if (key == "memory-report")
+		config.memory_report = parse_bool(key, value);
+	else if (key == "fixed-step")
+		config.fixed_step = parse_float(key, value);
+	else if (key == "replay")
+		config.replay_path = value;
+	else if (key == "record")
+		config.record_path = value;
+	else if (key == "sweep-resolutions")
+		config.sweep_resolutions = parse_unsigned_list(key, value);
+	else if (key == "sweep-waves")
+		config.sweep_wave_counts = parse_unsigned_list(key, value);
+	else if (key == "sweep-present-modes")
+	{
+		config.sweep_present_modes = parse_list(value);
+		for (const std::string &mode : config.sweep_present_modes)
+		{
+			check_choice(key, mode, { "auto", "mailbox", "fifo", "immediate" });
+		}
+	}
+	else if (key == "sweep-simulations")
+	{
+		config.sweep_simulations = parse_list(value);
+		for (const std::string &simulation : config.sweep_simulations)
+		{
+			check_choice(key, simulation, { "auto", "gpu", "vertex", "texture", "cpu" });
+		}
+	}
+	else if (key == "sweep-output")
+		config.sweep_output = value;
+	else if (key == "config")
+		load_config_file(value, config);
+	else
+		throw std::runtime_error("Unknown option " + key);
+}
+
+//flags may come without a value, "--headless 500" is short for "--headless --frames 500"
+ApplicationConfig parse_arguments(int argc, char *argv[])
+{
+	ApplicationConfig config;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument.rfind("--", 0) != 0)
+		{
+			throw std::runtime_error("Unexpected argument " + argument);
+		}
+		std::string key = argument.substr(2);
+		bool has_value = i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0;
+
+		if (key == "headless" && has_value && isdigit(argv[i + 1][0]))
+		{
+			apply_option(config, "headless", "true");
+			apply_option(config, "frames", argv[++i]);
+		}
+		else if (is_flag(key) && !has_value)
+		{
+			apply_option(config, key, "true");
+		}
+		else if (has_value)
+		{
+			apply_option(config, key, argv[++i]);
+		}
+		else
+		{
+			throw std::runtime_error("Option " + argument + " needs a value");
+		}
+	}
+
+	//the parity check reads back what the vertex shader evaluated, which only makes sense for that simulation
+	if (config.parity_check)
+	{
+		config.simulation = "vertex";
+		config.headless = true;
+		if (config.frame_count == 0)
+		{
+			config.frame_count = 10;
+		}
+	}
+
+	//a headless run can not be closed, it needs an end
+	if (config.headless && config.frame_count == 0)
+	{
+		config.frame_count = 100;
+	}
+	return config;
+}
+
+//trims spaces and tabs from both ends
+static std::string trim(const std::string &text)
+{
+	size_t begin = text.find_first_not_of(" \t\r");
+	if (begin == std::string::npos)
+		return "";
+	size_t end = text.find_last_not_of(" \t\r");
+	return text.substr(begin, end - begin + 1);
+}
+
+void load_config_file(const std::string &path, ApplicationConfig &config)
+{
+	info("Reading config ", path, "...");
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open config file " + path);
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty())
+			continue;
+
+		size_t separator = line.find('=');
+		if (separator == std::string::npos)
+		{
+			throw std::runtime_error("Config line \"" + line + "\" is not of the form key = value");
+		}
+		apply_option(config, trim(line.substr(0, separator)), trim(line.substr(separator + 1)));
+	}
+	succ("Config read");
+}
+
+std::unique_ptr<SimulationClock> create_clock(const ApplicationConfig &config)
+{
+	std::unique_ptr<SimulationClock> clock;
+	if (!config.replay_path.empty())
+	{
+		clock = std::make_unique<ReplayClock>(config.replay_path);
+	}
+	else if (config.fixed_step > 0.0f)
+	{
+		clock = std::make_unique<FixedStepClock>(config.fixed_step);
+	}
+	//benchmarks should not depend on how fast the frames happen to be
+	else if (config.frame_count > 0)
+	{
+		clock = std::make_unique<FixedStepClock>(1.0f / 60.0f);
+	}
+	else
+	{
+		clock = std::make_unique<WallClock>();
+	}
+
+	if (!config.record_path.empty())
+	{
+		clock = std::make_unique<RecordingClock>(std::move(clock), config.record_path);
+	}
+	return clock;
+}
+
+SpectrumParameters create_spectrum_parameters(const ApplicationConfig &config)
+{
+	SpectrumParameters parameters;
+	if (config.spectrum == "pm")
+		parameters.type = SpectrumType::pierson_moskowitz;
+	else if (config.spectrum == "jonswap")
+		parameters.type = SpectrumType::jonswap;
+	parameters.wind_speed = config.wind_speed;
+	parameters.wind_direction = config.wind_direction * 3.14159265f / 180.0f;
+	parameters.fetch = config.fetch * 1000.0f;
+	parameters.spread = config.spread;
+	parameters.choppiness = config.choppiness;
+	parameters.seed = config.seed;
+	return parameters;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "logger.hpp"
+#include "clock.hpp"
+#include "wave_spectrum.hpp"
+
+//Everything that can be set from the command line or a config file.
+//Options are named the same in both, "--frames 500" on the command line is "frames = 500" in a file.
+struct ApplicationConfig
+{
+	//ocean
+	uint32_t resolution = 256;
+	//0 uses all predefined waves, or the default count of the spectrum
+	uint32_t wave_count = 0;
+	//none, pm or jonswap, the waves are sampled from a spectrum for the given wind instead of the predefined ones
+	std::string spectrum = "none";
+	float wind_speed = 10.0f;
+	//degrees
+	float wind_direction = 0.0f;
+	//kilometers
+	float fetch = 100.0f;
+	float spread = 4.0f;
+	float choppiness = 0.7f;
+	uint32_t seed = 1;
+	//pixels a wavelength has to cover on screen, shorter waves fade out with distance to the camera, 0 evaluates every wave everywhere
+	float wave_lod = 4.0f;
+	bool wireframe = true;
+	//lit or normals, baked into the pipeline as a specialization constant
+	std::string shading = "lit";
+	//auto, gpu, vertex, texture or cpu, gpu runs a compute shader, vertex evaluates the waves in the vertex shader,
+	//texture runs a compute shader into a displacement and normal map the vertex and fragment shader sample
+	std::string simulation = "auto";
+	//texels across the maps of the texture simulation, they cover the whole plane whatever its resolution
+	uint32_t texture_resolution = 512;
+	//texels a sampler may average along the view direction, capped by the device, 1 or less turns anisotropic filtering off
+	float anisotropy = 16.0f;
+	//1, 2, 4 or 8, the cpu simulation evaluates the long waves on a grid that much coarser and interpolates them
+	uint32_t coarse_grid = 1;
+	//times the coarse grid against evaluating every wave at every vertex at startup and prints the error and speedup
+	bool coarse_grid_report = false;
+	//seconds after which every wave repeats, the speeds are rounded to fit, 0 leaves them as they are
+	float loop_period = 0.0f;
+	//if the waves repeat, the cpu simulation computes one loop of frames up front and interpolates between them
+	bool loop_cache = false;
+	float loop_frame_rate = 30.0f;
+	uint32_t loop_cache_megabytes = 256;
+	//microseconds per frame for the cpu simulation of distant chunks, they are updated less often and blended in between, 0 updates everything every frame
+	uint32_t slice_budget = 0;
+	//cells across the patch of ripples around the camera, 0 for none, only the cpu simulation shows them
+	uint32_t ripple_size = 0;
+	//floating bodies bobbing on the waves, 0 for none
+	uint32_t bodies = 0;
+	//steps the bodies for the frame count without rendering and reports the time per tick
+	bool buoyancy_benchmark = false;
+	//simulates frame_count frames at the fixed step into this file without rendering, with delta frames it is smaller
+	std::string bake_path;
+	bool bake_delta = true;
+	//plays a baked sequence instead of simulating, its resolution replaces the configured one
+	std::string sequence_path;
+	//renders headless with the vertex simulation and compares every frame with the cpu waves, fails if they differ
+	bool parity_check = false;
+
+	//presentation, auto, mailbox, fifo or immediate
+	std::string present_mode = "auto";
+
+	//rebuilds the pipeline when a shader in shaders/ changes, only in windowed runs without a frame count
+	bool hot_reload = true;
+
+	//asks for resolution and wireframe on the console like it used to
+	bool interactive = false;
+
+	//runs a fixed number of frames and reports timings, 0 runs until the window is closed
+	uint32_t frame_count = 0;
+	bool headless = false;
+	std::vector<uint32_t> dump_frames;
+	//per frame timings of such a run, empty to not write them
+	std::string timings_path = "benchmark_timings.csv";
+	//chrome trace of the cpu and gpu zones, written when the run ends, empty leaves the profiler off
+	std::string trace_path;
+
+	//memory, a budget of 0 means none, refuse stops configurations over budget, degrade lowers the resolution until they fit
+	uint32_t memory_budget_megabytes = 0;
+	std::string memory_budget_policy = "degrade";
+	//prints where the memory goes once everything is initialized, M does the same while running
+	bool memory_report = false;
+
+	//clock, a fixed step of 0 means wall time
+	float fixed_step = 0.0f;
+	std::string replay_path;
+	std::string record_path;
+
+	//sweeps, every combination of the listed values is run as its own benchmark
+	std::vector<uint32_t> sweep_resolutions;
+	std::vector<uint32_t> sweep_wave_counts;
+	std::vector<std::string> sweep_present_modes;
+	std::vector<std::string> sweep_simulations;
+	std::string sweep_output = "sweep_results.csv";
+
+	bool is_sweep() const;
+};
+
+//reads the command line, a "--config <file>" is applied where it appears, so later flags override it
+ApplicationConfig parse_arguments(int argc, char *argv[]);
+//applies every "key = value" line of the file, # starts a comment
+void load_config_file(const std::string &path, ApplicationConfig &config);
+//applies a single option, throws if the key is unknown or the value does not fit
+void apply_option(ApplicationConfig &config, const std::string &key, const std::string &value);
+
+//the clock the config asks for, wall time if nothing else was set
+std::unique_ptr<SimulationClock> create_clock(const ApplicationConfig &config);
+//the spectrum the config asks for, in the units the spectrum wants
+SpectrumParameters create_spectrum_parameters(const ApplicationConfig &config);
@@ -0,0 +1,350 @@
+#include "displacement_sequence.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path)
+{
+#ifdef _WIN32
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER size = {};
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		throw std::runtime_error("Failed to open " + path);
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_data = m_mapping != nullptr ? static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	if (m_data == nullptr)
+	{
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		throw std::runtime_error("Failed to map " + path);
+	}
+#else
+	m_file = open(path.c_str(), O_RDONLY);
+	struct stat status = {};
+	if (m_file < 0 || fstat(m_file, &status) != 0 || status.st_size == 0)
+	{
+		if (m_file >= 0)
+			close(m_file);
+		throw std::runtime_error("Failed to open " + path);
+	}
+	m_size = static_cast<size_t>(status.st_size);
+	void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		close(m_file);
+		throw std::runtime_error("Failed to map " + path);
+	}
+	m_data = static_cast<const uint8_t *>(data);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+	CloseHandle(m_file);
+#else
+	munmap(const_cast<uint8_t *>(m_data), m_size);
+	close(m_file);
+#endif
+}
+
+const uint8_t *MappedFile::data() const
+{
+	return m_data;
+}
+
+size_t MappedFile::size() const
+{
+	return m_size;
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const
+{
+	if (offset >= m_size)
+		return;
+	length = std::min(length, m_size - offset);
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t *>(m_data) + offset, length };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	//madvise wants the start on a page boundary
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t start = offset / page * page;
+	madvise(const_cast<uint8_t *>(m_data) + start, length + offset - start, MADV_WILLNEED);
+#endif
+}
+
+static const char SEQUENCE_MAGIC[4] = { 'W', 'D', 'S', 'Q' };
+//frames start on multiples of this, so the integers in them can be read in place
+static const size_t FRAME_ALIGNMENT = 8;
+
+DisplacementSequence::DisplacementSequence(const std::string &path) : m_file(path)
+{
+	if (m_file.size() < sizeof(SequenceHeader))
+	{
+		throw std::runtime_error(path + " is too short for a displacement sequence");
+	}
+	memcpy(&m_header, m_file.data(), sizeof(SequenceHeader));
+	if (memcmp(m_header.magic, SEQUENCE_MAGIC, sizeof(SEQUENCE_MAGIC)) != 0 || m_header.version != VERSION)
+	{
+		throw std::runtime_error(path + " is no displacement sequence of version " + std::to_string(VERSION));
+	}
+	m_offsets = reinterpret_cast<const uint64_t *>(m_file.data() + sizeof(SequenceHeader));
+	size_t table_end = sizeof(SequenceHeader) + (static_cast<size_t>(m_header.frame_count) + 1) * sizeof(uint64_t);
+	if (m_header.frame_count == 0 || m_header.resolution == 0 || m_header.frame_rate <= 0.0f || table_end > m_file.size() || m_offsets[m_header.frame_count] > m_file.size())
+	{
+		throw std::runtime_error(path + " is cut off or has no frames");
+	}
+	//frames are read in place, so each one has to fit between its offset and the next,
+	//plain frames and keyframes hold every integer, a delta frame at least one byte each
+	size_t frame_bytes = static_cast<size_t>(m_header.resolution) * m_header.resolution * 3 * sizeof(int16_t);
+	for (uint32_t frame = 0; frame < m_header.frame_count; frame++)
+	{
+		bool full_frame = m_header.keyframe_interval == 0 || frame % m_header.keyframe_interval == 0;
+		uint64_t start = m_offsets[frame];
+		uint64_t end = m_offsets[frame + 1];
+		if (start < table_end || end <= start || (full_frame && end - start < frame_bytes))
+		{
+			throw std::runtime_error(path + " has a frame table that does not match its resolution of " + std::to_string(m_header.resolution) + ", frame " + std::to_string(frame) + " does not fit");
+		}
+	}
+	if (m_header.keyframe_interval > 0)
+	{
+		m_state.resize(static_cast<size_t>(m_header.resolution) * m_header.resolution * 3);
+	}
+	info("Playing ", m_header.frame_count, " baked frames of ", m_header.resolution, "x", m_header.resolution, " at ", m_header.frame_rate, " fps from ", path);
+}
+
+uint32_t DisplacementSequence::get_resolution() const
+{
+	return m_header.resolution;
+}
+
+uint32_t DisplacementSequence::get_frame_count() const
+{
+	return m_header.frame_count;
+}
+
+float DisplacementSequence::get_frame_rate() const
+{
+	return m_header.frame_rate;
+}
+
+uint32_t DisplacementSequence::get_frame(float time) const
+{
+	double frame = std::floor(static_cast<double>(time) * m_header.frame_rate);
+	return static_cast<uint32_t>(static_cast<int64_t>(std::max(frame, 0.0)) % m_header.frame_count);
+}
+
+const uint8_t *DisplacementSequence::frame_data(uint32_t frame) const
+{
+	return m_file.data() + m_offsets[frame];
+}
+
+void DisplacementSequence::read_frame(uint32_t frame, Displacement *displacements)
+{
+	PROFILE_FUNCTION();
+	size_t vertex_count = static_cast<size_t>(m_header.resolution) * m_header.resolution;
+	const int16_t *values;
+	if (m_header.keyframe_interval == 0)
+	{
+		values = reinterpret_cast<const int16_t *>(frame_data(frame));
+	}
+	else
+	{
+		//carry on from the last decoded frame if it is on the way, otherwise start over at the keyframe before
+		uint32_t keyframe = frame - frame % m_header.keyframe_interval;
+		if (m_state_frame < keyframe || m_state_frame > frame)
+		{
+			decode_keyframe(keyframe);
+		}
+		for (uint32_t next = static_cast<uint32_t>(m_state_frame) + 1; next <= frame; next++)
+		{
+			decode_delta(next);
+		}
+		values = m_state.data();
+	}
+
+	float scale_x = m_header.scale[0], scale_y = m_header.scale[1], scale_z = m_header.scale[2];
+	for (size_t i = 0; i < vertex_count; i++)
+	{
+		displacements[i].displacement = glm::vec3(values[3 * i] * scale_x, values[3 * i + 1] * scale_y, values[3 * i + 2] * scale_z);
+	}
+
+	//the next frame is read from disk while this one is drawn
+	uint32_t next = (frame + 1) % m_header.frame_count;
+	m_file.prefetch(m_offsets[next], m_offsets[next + 1] - m_offsets[next]);
+}
+
+void DisplacementSequence::decode_keyframe(uint32_t frame)
+{
+	memcpy(m_state.data(), frame_data(frame), m_state.size() * sizeof(int16_t));
+	m_state_frame = frame;
+}
+
+//each integer changed by a zigzag varint, 7 bits per byte, the lowest first
+void DisplacementSequence::decode_delta(uint32_t frame)
+{
+	if (frame % m_header.keyframe_interval == 0)
+	{
+		decode_keyframe(frame);
+		return;
+	}
+
+	const uint8_t *data = frame_data(frame);
+	const uint8_t *end = m_file.data() + m_offsets[frame + 1];
+	for (int16_t &value : m_state)
+	{
+		uint32_t zigzag = 0;
+		for (uint32_t shift = 0; data < end; shift += 7)
+		{
+			uint8_t byte = *data++;
+			zigzag |= static_cast<uint32_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		uint16_t delta = static_cast<uint16_t>((zigzag >> 1) ^ (0u - (zigzag & 1)));
+		value = static_cast<int16_t>(static_cast<uint16_t>(value) + delta);
+	}
+	m_state_frame = frame;
+}
+
+//the integers of one frame, clamped so a displacement the bound missed can not wrap around
+static void quantize(const std::vector<Displacement> &displacements, const float inverse_scale[3], std::vector<int16_t> &values)
+{
+	for (size_t i = 0; i < displacements.size(); i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float value = std::round(displacements[i].displacement[axis] * inverse_scale[axis]);
+			values[3 * i + axis] = static_cast<int16_t>(std::min(std::max(value, -32767.0f), 32767.0f));
+		}
+	}
+}
+
+static void write_padding(std::ofstream &file)
+{
+	static const char zeros[FRAME_ALIGNMENT] = {};
+	size_t position = static_cast<size_t>(file.tellp());
+	file.write(zeros, (FRAME_ALIGNMENT - position % FRAME_ALIGNMENT) % FRAME_ALIGNMENT);
+}
+
+void bake_displacement_sequence(const ApplicationConfig &config)
+{
+	PROFILE_FUNCTION();
+	uint32_t frame_count = config.frame_count == 0 ? 600 : config.frame_count;
+	float delta_time = config.fixed_step > 0.0f ? config.fixed_step : 1.0f / 60.0f;
+	uint32_t keyframe_interval = config.bake_delta ? DisplacementSequence::KEYFRAME_INTERVAL : 0;
+	uint32_t fade_frames = std::min(frame_count / 4, static_cast<uint32_t>(1.0f / delta_time));
+	info("Baking ", frame_count, " frames of ", delta_time * 1000.0f, "ms into ", config.bake_path, config.bake_delta ? " with delta frames" : "");
+
+	Ocean ocean(config.resolution, static_cast<float>(config.resolution), config.wave_count, create_spectrum_parameters(config));
+	ocean.set_coarse_factor(config.coarse_grid);
+
+	//no wave moves a vertex further than its amplitude along z and its amplitude times steepness sideways
+	glm::vec3 largest_displacement(0.0f);
+	for (const GerstnerParameters &wave : ocean.get_wave_parameters())
+	{
+		largest_displacement += glm::vec3(wave.steepness * wave.amplitude * std::abs(wave.direction.x), wave.steepness * wave.amplitude * std::abs(wave.direction.y), wave.amplitude);
+	}
+
+	DisplacementSequence::SequenceHeader header = {};
+	memcpy(header.magic, SEQUENCE_MAGIC, sizeof(SEQUENCE_MAGIC));
+	header.version = DisplacementSequence::VERSION;
+	header.resolution = config.resolution;
+	header.frame_count = frame_count;
+	header.frame_rate = 1.0f / delta_time;
+	header.keyframe_interval = keyframe_interval;
+	float inverse_scale[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.scale[axis] = std::max(largest_displacement[axis], 1e-6f) / 32767.0f;
+		inverse_scale[axis] = 1.0f / header.scale[axis];
+	}
+
+	std::ofstream file(config.bake_path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Failed to open " + config.bake_path + " for writing");
+	}
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	//the offsets are only known once the frames are written
+	std::vector<uint64_t> offsets(frame_count + 1, 0);
+	file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+	size_t vertex_count = static_cast<size_t>(config.resolution) * config.resolution;
+	std::vector<int16_t> values(vertex_count * 3);
+	std::vector<int16_t> previous_values(vertex_count * 3);
+	std::vector<uint8_t> encoded;
+	float loop_time = frame_count * delta_time;
+	for (uint32_t frame = 0; frame < frame_count; frame++)
+	{
+		float time = frame * delta_time;
+		std::vector<Displacement> displacements = ocean.update_waves(time);
+		if (frame + fade_frames >= frame_count && fade_frames > 0)
+		{
+			//the frame one loop earlier continues seamlessly into frame 0, fading to it hides the jump
+			std::vector<Displacement> earlier = ocean.update_waves(time - loop_time);
+			float t = static_cast<float>(frame + fade_frames - frame_count) / fade_frames;
+			float weight = t * t * (3.0f - 2.0f * t);
+			for (size_t i = 0; i < vertex_count; i++)
+			{
+				displacements[i].displacement += (earlier[i].displacement - displacements[i].displacement) * weight;
+			}
+		}
+		quantize(displacements, inverse_scale, values);
+
+		write_padding(file);
+		offsets[frame] = static_cast<uint64_t>(file.tellp());
+		if (keyframe_interval == 0 || frame % keyframe_interval == 0)
+		{
+			file.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(int16_t));
+		}
+		else
+		{
+			encoded.clear();
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				uint16_t delta = static_cast<uint16_t>(static_cast<uint16_t>(values[i]) - static_cast<uint16_t>(previous_values[i]));
+				uint32_t zigzag = static_cast<uint16_t>((delta << 1) ^ (static_cast<int16_t>(delta) < 0 ? 0xffff : 0));
+				while (zigzag >= 0x80)
+				{
+					encoded.push_back(static_cast<uint8_t>(zigzag | 0x80));
+					zigzag >>= 7;
+				}
+				encoded.push_back(static_cast<uint8_t>(zigzag));
+			}
+			file.write(reinterpret_cast<const char *>(encoded.data()), encoded.size());
+		}
+		previous_values.swap(values);
+	}
+	offsets[frame_count] = static_cast<uint64_t>(file.tellp());
+	file.seekp(sizeof(header));
+	file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+	if (!file)
+	{
+		throw std::runtime_error("Failed to write " + config.bake_path);
+	}
+
+	double raw_bytes = static_cast<double>(vertex_count) * sizeof(Displacement) * frame_count;
+	//straight to the console, release builds compile succ out
+	flush_log();
+	std::cout << "Baked " << frame_count << " frames, " << offsets[frame_count] / (1024.0 * 1024.0) << "MB, " << 100.0 * offsets[frame_count] / raw_bytes << "% of the floats, precision "
+		<< std::max({ header.scale[0], header.scale[1], header.scale[2] }) << std::endl;
+}
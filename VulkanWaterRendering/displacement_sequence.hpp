@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+#include "ocean.hpp"
+#include "config.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+//A read only file mapped into memory, the pages are only read from disk once they are touched
+class MappedFile
+{
+public:
+	MappedFile(const std::string &path);
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const uint8_t *data() const;
+	size_t size() const;
+	//asks the system to start reading [offset, offset + length) from disk, returns right away
+	void prefetch(size_t offset, size_t length) const;
+
+private:
+	const uint8_t *m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void *m_file = nullptr;
+	void *m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+};
+
+//A loop of displacement frames baked ahead of time, played back without simulating anything.
+//The file starts with a SequenceHeader and the offset of every frame, then the frames follow. A vertex is stored as
+//three 16 bit integers scaled to the largest displacement the waves can reach, half the size of the floats.
+//With delta frames only every KEYFRAME_INTERVAL-th frame is stored like that, the ones in between store how much each
+//integer changed since the frame before as zigzag varints, mostly one byte each as the water moves little per frame.
+//Playback maps the file and decodes a frame straight into the displacement buffer, plain frames need no copy in between,
+//delta frames go through the integers of the last decoded frame.
+class DisplacementSequence
+{
+public:
+	static const uint32_t VERSION = 1;
+	static const uint32_t KEYFRAME_INTERVAL = 60;
+
+	struct SequenceHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t resolution;
+		uint32_t frame_count;
+		float frame_rate;
+		//0 if every frame is a keyframe
+		uint32_t keyframe_interval;
+		//a stored integer times the scale of its axis is the displacement
+		float scale[3];
+		uint32_t padding;
+	};
+
+	//maps the file and checks its header, throws if it is no sequence
+	DisplacementSequence(const std::string &path);
+
+	uint32_t get_resolution() const;
+	uint32_t get_frame_count() const;
+	float get_frame_rate() const;
+	//the frame shown at the given time, the sequence loops
+	uint32_t get_frame(float time) const;
+	//writes resolution^2 displacements, playing forward is cheapest, jumping back decodes from the last keyframe
+	void read_frame(uint32_t frame, Displacement *displacements);
+
+private:
+	MappedFile m_file;
+	SequenceHeader m_header;
+	const uint64_t *m_offsets;
+	//the integers of the last decoded frame, only used with delta frames
+	std::vector<int16_t> m_state;
+	int64_t m_state_frame = -1;
+
+	const uint8_t *frame_data(uint32_t frame) const;
+	void decode_keyframe(uint32_t frame);
+	void decode_delta(uint32_t frame);
+};
+
+//simulates frame_count frames at the fixed step into config.bake_path and reports how large the file got
+//the waves do not repeat, so the last second, at most a quarter of the frames, fades into the waves before the first frame
+void bake_displacement_sequence(const ApplicationConfig &config);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <vulkan/vulkan.h>
+
+//SPIR-V of the shaders, compiled into the binary so startup does not have to read the shader directory.
+//The custom build step of every shader source runs glslangValidator with --vn, which writes the words as a
+//const uint32_t array to shaders/generated/<stage>.spv.h, so the arrays are rebuilt whenever a source changes.
+//The hot reloader only swaps in the stages it compiled to .spv files on disk.
+namespace embedded_shaders
+{
+#include "shaders/generated/vert.spv.h"
+#include "shaders/generated/vert_parity.spv.h"
+#include "shaders/generated/geom.spv.h"
+#include "shaders/generated/frag.spv.h"
+#include "shaders/generated/comp.spv.h"
+#include "shaders/generated/comp_texture.spv.h"
+}
+
+//A view on SPIR-V words, either embedded or read from a file, size is in bytes as vulkan wants it
+struct ShaderCode
+{
+	const uint32_t *words;
+	size_t size;
+};
+
+constexpr ShaderCode EMBEDDED_VERT_SHADER = { embedded_shaders::vert_spv, sizeof(embedded_shaders::vert_spv) };
+//shader.vert built with WRITE_DISPLACEMENT, for the parity check
+constexpr ShaderCode EMBEDDED_VERT_PARITY_SHADER = { embedded_shaders::vert_parity_spv, sizeof(embedded_shaders::vert_parity_spv) };
+constexpr ShaderCode EMBEDDED_GEOM_SHADER = { embedded_shaders::geom_spv, sizeof(embedded_shaders::geom_spv) };
+constexpr ShaderCode EMBEDDED_FRAG_SHADER = { embedded_shaders::frag_spv, sizeof(embedded_shaders::frag_spv) };
+constexpr ShaderCode EMBEDDED_COMP_SHADER = { embedded_shaders::comp_spv, sizeof(embedded_shaders::comp_spv) };
+//shader.comp built with TEXTURE_OUTPUT, for OceanTexture
+constexpr ShaderCode EMBEDDED_COMP_TEXTURE_SHADER = { embedded_shaders::comp_texture_spv, sizeof(embedded_shaders::comp_texture_spv) };
+
+//the specialization constants of shader.vert
+struct VertexSpecialization
+{
+	VkBool32 evaluate_waves;
+	uint32_t wave_count;
+	uint32_t resolution;
+	VkBool32 sample_texture;
+};
+
+//how shader.frag colors the surface
+enum class ShadingMode : uint32_t
+{
+	//ambient, diffuse and specular sunlight
+	lit = 0,
+	//the surface normal as color, to check the geometry
+	normals = 1
+};
+
+//the specialization constants of shader.frag
+struct FragmentSpecialization
+{
+	ShadingMode shading_mode;
+	VkBool32 sample_normals;
+};
\ No newline at end of file
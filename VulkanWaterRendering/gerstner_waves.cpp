@@ -1,24 +1,25 @@
 #include "gerstner_waves.hpp"
 
+//how fast the phase moves, the angular frequency
 float Gerstner::get_phase_constant()
 {
-	return speed * 2 / lambda;
+	return get_w();
 }
 
 //"Choppiness" of the wave
 float Gerstner::get_Q()
 {
-	return 0.7;
+	return Q;
 }
 
 //Tessendorf calls it K, everyone else w, its a bit confusing
+//K is the spatial frequency, w the temporal one, they used to be mixed up, which made sqrt(g*K) loop on wavetops
 float Gerstner::get_w() {
-	//cause loops on wavetops
-	//return sqrtf((g * get_K()));
-	//return sqrtf(g*((2 * PI) / lambda));
-
-	//this does the trick
-	return get_K();
+	float w = sqrtf(g * get_K());
+	if (loop_period <= 0.0f)
+		return w;
+	float loop_w = 2 * PI / loop_period;
+	return std::max(roundf(w / loop_w), 1.0f) * loop_w;
 }
 
 float Gerstner::get_K() {
@@ -31,9 +32,10 @@ glm::vec3 Gerstner::get_displacement(glm::vec2 x0, glm::vec3 displacement)
 	//Implementation of the gerstner wave algorithm
 	//might still be wrong, but it gives reasonably good results
 
-	float x = displacement.x + (get_Q()*A*k.x*cosf(get_w()*glm::dot(k, x0) + get_phase_constant()*time));
-	float y = displacement.y + (get_Q()*A*k.y*cosf(get_w()*glm::dot(k, x0) + get_phase_constant()*time));
-	float z = displacement.z + A * sinf(get_w()*glm::dot(k, x0) + get_phase_constant()*time);
+	float phase = get_K()*glm::dot(k, x0) + get_phase_constant()*time + phi;
+	float x = displacement.x + (get_Q()*A*k.x*cosf(phase));
+	float y = displacement.y + (get_Q()*A*k.y*cosf(phase));
+	float z = displacement.z + A * sinf(phase);
 
 	//attempts that are obsolete or implemented slightly different above
 
@@ -49,12 +51,75 @@ glm::vec3 Gerstner::get_displacement(glm::vec2 x0, glm::vec3 displacement)
 }
 
 //a new and fresh gerstner wave
-Gerstner::Gerstner(glm::vec2 wave_direction, float amplitude, float wavelength, float speed)
+Gerstner::Gerstner(glm::vec2 wave_direction, float amplitude, float wavelength, float steepness, float phase_offset)
 {
 	this->k = glm::normalize(wave_direction);
 	this->A = amplitude;
 	this->lambda = wavelength;
-	this->speed = 10 * sqrtf(g*((2 * PI) / lambda));
+	this->Q = steepness;
+	this->phi = phase_offset;
+}
+
+//the parameters of this wave, so the same wave can be evaluated in a shader
+GerstnerParameters Gerstner::get_parameters()
+{
+	GerstnerParameters parameters = {};
+	parameters.direction = k;
+	parameters.amplitude = A;
+	parameters.frequency = get_K();
+	parameters.phase_constant = get_phase_constant();
+	parameters.steepness = get_Q();
+	parameters.phase_offset = phi;
+	parameters.wavelength = lambda;
+	return parameters;
+}
+
+float Gerstner::get_wavelength() const
+{
+	return lambda;
+}
+
+void Gerstner::set_loop_period(float period)
+{
+	loop_period = period;
+}
+
+//the wave vector has to be a whole number of cycles per tile on both axes, one at least
+void Gerstner::set_tile(float tile)
+{
+	glm::vec2 cycles(roundf(k.x * tile / lambda), roundf(k.y * tile / lambda));
+	if (cycles.x == 0.0f && cycles.y == 0.0f)
+	{
+		if (std::abs(k.x) > std::abs(k.y))
+			cycles.x = k.x > 0.0f ? 1.0f : -1.0f;
+		else
+			cycles.y = k.y > 0.0f ? 1.0f : -1.0f;
+	}
+	k = glm::normalize(cycles);
+	lambda = tile / glm::length(cycles);
+}
+
+float WaveLod::get_cutoff(glm::vec2 x0) const
+{
+	return cutoff_per_distance * glm::length(glm::vec3(x0, 0.0f) - camera);
+}
+
+//smoothstep from the cutoff to twice of it, the shaders use the same curve
+float WaveLod::get_weight(float wavelength, float cutoff)
+{
+	if (cutoff <= 0.0f)
+		return 1.0f;
+	float t = std::min(std::max(wavelength / cutoff - 1.0f, 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+//turns by the golden angle, so the variations of one wave never line up
+Gerstner Gerstner::get_variation(uint32_t generation) const
+{
+	float angle = 2.39996f * generation;
+	glm::vec2 direction(k.x * cosf(angle) - k.y * sinf(angle), k.x * sinf(angle) + k.y * cosf(angle));
+	float scale = powf(0.6f, static_cast<float>(generation));
+	return Gerstner(direction, A * scale, lambda * scale, Q, phi + angle);
 }
 
 //Applies this wave on top of a wavemap
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -11,6 +12,34 @@
 #include "displacement.hpp"
 #include "helper.hpp"
 
+//The values of a wave the gpu needs to evaluate it, laid out for a std430 storage buffer
+struct GerstnerParameters {
+	glm::vec2 direction;
+	float amplitude;
+	float frequency;
+	float phase_constant;
+	float steepness;
+	float phase_offset;
+	//2PI / frequency, stored so the lod does not have to divide for every vertex
+	//also keeps the struct at 8 floats, std430 aligns it to its vec2 and the array stride has to match
+	float wavelength;
+};
+
+//Which waves a vertex evaluates. Waves are sorted longest first, a wave fades out while its wavelength drops from
+//twice the cutoff to the cutoff, which grows with the distance of the vertex to the camera, and is skipped below it.
+//Laid out like the lod members of the uniform buffer and the compute push constants, a vec3 followed by a float.
+struct WaveLod
+{
+	//in grid cells like x0, with the undisturbed surface at z = 0
+	glm::vec3 camera = glm::vec3(0.0f);
+	//cutoff wavelength per unit of distance to the camera, 0 evaluates every wave everywhere
+	float cutoff_per_distance = 0.0f;
+
+	float get_cutoff(glm::vec2 x0) const;
+	//how much of a wave with this wavelength is left at the given cutoff, eased so it does not pop
+	static float get_weight(float wavelength, float cutoff);
+};
+
 class Gerstner {
 	//variables are named like they are in the formulas in Tessendorfs
 
@@ -20,12 +49,13 @@ private:
 
 	float lambda; //wavelength
 	float time; //time
+	float Q; //steepness
+	float phi; //phase offset, so waves sampled from a spectrum do not all line up at the origin
+	float loop_period = 0.0f; //0 for none, otherwise w is rounded so the wave repeats after it
 
 	//constant values needed at some point
-	const float g = 9.81; //gravity
-	const float PI = 3.14;
-
-	float speed;
+	static constexpr float g = 9.81f; //gravity
+	static constexpr float PI = 3.14159265f;
 
 	float get_phase_constant();
 
@@ -40,7 +70,18 @@ private:
 	glm::vec3 get_displacement(glm::vec2 x0, glm::vec3 displacement);
 
 public:
-	Gerstner(glm::vec2 wave_direction, float amplitude, float wavelength, float speed);
+	//the speed follows from the wavelength by the deep water dispersion relation
+	Gerstner(glm::vec2 wave_direction, float amplitude, float wavelength, float steepness = 0.7f, float phase_offset = 0.0f);
+
+	//the parameters of this wave, as used by get_displacement
+	GerstnerParameters get_parameters();
+	float get_wavelength() const;
+	//rounds the speed of the wave to the nearest one that repeats after period seconds, at least once, 0 undoes it
+	void set_loop_period(float period);
+	//rounds the direction and wavelength to the nearest wave that repeats every tile cells along x and y
+	void set_tile(float tile);
+	//a turned, shorter and flatter version of this wave, the higher the generation the more it differs
+	Gerstner get_variation(uint32_t generation) const;
 
 	//Applies this wave on top of a wavemap
 	std::vector<Displacement> apply_wave(std::vector<Displacement> current_displacement, uint32_t resolution, float tilesize, float time);
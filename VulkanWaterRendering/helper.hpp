@@ -27,7 +27,7 @@ static std::vector<char> read_file(const std::string &filename) {
 	file.read(buffer.data(), file_size);
 
 	file.close();
-	info(std::string("File read, size: ") + std::to_string(file_size));
+	info("File read, size: ", file_size);
 	return buffer;
 }
 
@@ -0,0 +1,110 @@
+#include "logger.hpp"
+
+#include <chrono>
+
+//the one logger all threads write into, the thread starts with the first message
+Logger &Logger::get()
+{
+	static Logger logger;
+	return logger;
+}
+
+Logger::Logger() : m_enqueue_position(0), m_dequeue_position(0), m_dropped(0), m_running(true)
+{
+	for (size_t i = 0; i < LOG_QUEUE_CAPACITY; i++)
+	{
+		m_records[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	m_thread = std::thread(&Logger::run, this);
+}
+
+//writes what is left before the program ends
+Logger::~Logger()
+{
+	m_running.store(false, std::memory_order_release);
+	m_thread.join();
+}
+
+void Logger::flush()
+{
+	size_t target = m_enqueue_position.load(std::memory_order_acquire);
+	while (m_dequeue_position.load(std::memory_order_acquire) < target)
+	{
+		std::this_thread::yield();
+	}
+}
+
+//drains the queue, flushes the console once it ran dry and naps until there is more
+void Logger::run()
+{
+	while (true)
+	{
+		bool running = m_running.load(std::memory_order_acquire);
+		bool wrote = false;
+		while (write_next())
+		{
+			wrote = true;
+		}
+
+		size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0)
+		{
+			std::cout << dropped << " log messages were dropped\n";
+		}
+
+		if (wrote || dropped > 0)
+		{
+			std::cout.flush();
+		}
+		else if (!running)
+		{
+			return;
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+//writes the oldest message, returns false if there is none
+bool Logger::write_next()
+{
+	size_t position = m_dequeue_position.load(std::memory_order_relaxed);
+	Record &record = m_records[position % LOG_QUEUE_CAPACITY];
+	if (record.sequence.load(std::memory_order_acquire) != position + 1)
+		return false;
+
+	console_colors_foreground foreground_color = console_colors_foreground::white;
+	switch (record.level)
+	{
+	case LogLevel::succ:
+		foreground_color = console_colors_foreground::green;
+		break;
+	case LogLevel::warn:
+		foreground_color = console_colors_foreground::yellow;
+		break;
+	case LogLevel::err:
+		foreground_color = console_colors_foreground::red;
+		break;
+	default:
+		break;
+	}
+
+#ifdef COLORMODE
+	//first, set the wanted colours
+	std::cout << esc_char << (int)foreground_color << ';' << (int)console_colors_background::black << esc_color_end_char;
+#endif
+	//then display the message
+	record.format(record.arguments, std::cout);
+#ifdef COLORMODE
+	//reset the colors
+	std::cout << esc_char << esc_color_reset_char << esc_color_end_char;
+#endif
+	std::cout << '\n';
+
+	record.destroy(record.arguments);
+	record.sequence.store(position + LOG_QUEUE_CAPACITY, std::memory_order_release);
+	m_dequeue_position.store(position + 1, std::memory_order_release);
+	return true;
+}
@@ -2,8 +2,34 @@
 #define COLORMODE
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <atomic>
+#include <thread>
+#include <array>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 
-#ifdef COLORMODE
+//levels below LOG_LEVEL are compiled away, arguments of such messages are never formatted
+#define LOG_LEVEL_INFO 0
+#define LOG_LEVEL_SUCC 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+#ifdef _DEBUG
+#define LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL LOG_LEVEL_WARN
+#endif
+#endif
+
+#if defined(_WIN32) && defined(COLORMODE)
 //windows likes to redefine standard functions. bad dog
 #define NOMINMAX
 #include <Windows.h>
@@ -28,6 +54,11 @@ inline DWORD enable_virtual_terminal() {
 	}
 	return 1;
 }
+#elif defined(COLORMODE)
+//other terminals understand color codes out of the box
+inline unsigned long enable_virtual_terminal() {
+	return 1;
+}
 #endif
 
 //enumerations conveniently starting at the numbers where the color codes begin
@@ -38,33 +69,146 @@ inline const char* esc_char = { "\x1b[" };
 const char  esc_color_end_char = 'm';
 const char	esc_color_reset_char = '0';
 
-//console output, if no color info is submitted it will assume default colors
-template <class T> void info(T value, console_colors_foreground foreground_color_code = console_colors_foreground::white, console_colors_background background_color_code = console_colors_background::black) {
-#ifdef _DEBUG
-#ifdef COLORMODE
-	//first, set the wanted colours
-	std::cout << esc_char << (int)foreground_color_code << ';' << (int)background_color_code << esc_color_end_char;
+enum class LogLevel { info = LOG_LEVEL_INFO, succ = LOG_LEVEL_SUCC, warn = LOG_LEVEL_WARN, err = LOG_LEVEL_ERR };
+
+//bytes a message can keep its arguments in, bigger messages are formatted right away
+const size_t LOG_ARGUMENT_CAPACITY = 112;
+//messages that can wait for the logging thread, more get dropped instead of stalling the caller
+const size_t LOG_QUEUE_CAPACITY = 1024;
+
+//C strings are copied, the pointer may not outlive the call, everything else is kept as it is
+template <class T> struct log_argument { using type = std::decay_t<T>; };
+template <> struct log_argument<char *> { using type = std::string; };
+template <> struct log_argument<const char *> { using type = std::string; };
+template <class T> using log_argument_t = typename log_argument<std::decay_t<T>>::type;
+
+//Writes messages to the console on a thread of its own, so logging never waits for the console.
+//Any thread can log, the messages go into a bounded lock free queue that the logging thread drains.
+//A message only keeps its arguments, turning them into text is left to the logging thread.
+class Logger
+{
+public:
+	static Logger &get();
+
+	template <class... Args> void write(LogLevel level, Args &&... args);
+	//blocks until every message logged before the call is on the console
+	void flush();
+
+private:
+	//one message in the queue, sequence tells producers and the consumer whose turn it is
+	struct Record
+	{
+		std::atomic<size_t> sequence;
+		LogLevel level;
+		void (*format)(void *arguments, std::ostream &stream);
+		void (*destroy)(void *arguments);
+		alignas(std::max_align_t) unsigned char arguments[LOG_ARGUMENT_CAPACITY];
+	};
+
+	std::array<Record, LOG_QUEUE_CAPACITY> m_records;
+	alignas(64) std::atomic<size_t> m_enqueue_position;
+	alignas(64) std::atomic<size_t> m_dequeue_position;
+	std::atomic<size_t> m_dropped;
+	std::atomic<bool> m_running;
+	std::thread m_thread;
+
+	Logger();
+	~Logger();
+
+	template <class Tuple> static void format_arguments(void *arguments, std::ostream &stream);
+	template <class Tuple> static void destroy_arguments(void *arguments);
+
+	void run();
+	bool write_next();
+};
+
+template <class Tuple> void Logger::format_arguments(void *arguments, std::ostream &stream)
+{
+	std::apply([&stream](const auto &... values) { (stream << ... << values); }, *static_cast<Tuple *>(arguments));
+}
+
+template <class Tuple> void Logger::destroy_arguments(void *arguments)
+{
+	static_cast<Tuple *>(arguments)->~Tuple();
+}
+
+//claims a record, stores the arguments in it and hands it to the logging thread
+template <class... Args> void Logger::write(LogLevel level, Args &&... args)
+{
+	using Tuple = std::tuple<log_argument_t<Args>...>;
+	if constexpr (sizeof(Tuple) > LOG_ARGUMENT_CAPACITY || alignof(Tuple) > alignof(std::max_align_t))
+	{
+		//does not fit, format now and store the text
+		std::ostringstream stream;
+		(stream << ... << args);
+		write(level, stream.str());
+	}
+	else
+	{
+		size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+		Record *record;
+		while (true)
+		{
+			record = &m_records[position % LOG_QUEUE_CAPACITY];
+			size_t sequence = record->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (difference == 0)
+			{
+				if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			//the logging thread is a whole queue behind, better lose a message than stall a frame
+			else if (difference < 0)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			else
+			{
+				position = m_enqueue_position.load(std::memory_order_relaxed);
+			}
+		}
+
+		record->level = level;
+		record->format = &format_arguments<Tuple>;
+		record->destroy = &destroy_arguments<Tuple>;
+		new (record->arguments) Tuple(std::forward<Args>(args)...);
+		record->sequence.store(position + 1, std::memory_order_release);
+	}
+}
+
+//console output, the arguments are written one after another,
+//they are unused when LOG_LEVEL compiles the body out
+template <class... Args> void info([[maybe_unused]] Args &&... args) {
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+	Logger::get().write(LogLevel::info, std::forward<Args>(args)...);
 #endif
-	//then display the message
-	std::cout << value << std::endl;
-#ifdef COLORMODE
-	//reset the colors
-	std::cout << esc_char << esc_color_reset_char << esc_color_end_char;
+}
+
+//like info, in green
+template <class... Args> void succ([[maybe_unused]] Args &&... args) {
+#if LOG_LEVEL <= LOG_LEVEL_SUCC
+	Logger::get().write(LogLevel::succ, std::forward<Args>(args)...);
 #endif
-#endif // !_DEBUG
 }
 
-//this will use the info function, but give it a predefined color
-template <class T> void warn(T value) {
-	info(value, console_colors_foreground::yellow);
+//like info, in yellow
+template <class... Args> void warn([[maybe_unused]] Args &&... args) {
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+	Logger::get().write(LogLevel::warn, std::forward<Args>(args)...);
+#endif
 }
 
-//this will use the info function, but give it a predefined color
-template <class T> void err(T value) {
-	info(value, console_colors_foreground::red);
+//like info, in red
+template <class... Args> void err([[maybe_unused]] Args &&... args) {
+#if LOG_LEVEL <= LOG_LEVEL_ERR
+	Logger::get().write(LogLevel::err, std::forward<Args>(args)...);
+#endif
 }
 
-//this will use the info function, but give it a predefined color
-template <class T> void succ(T value) {
-	info(value, console_colors_foreground::green);
-}
\ No newline at end of file
+//waits for the logging thread, call before writing to std::cout directly
+inline void flush_log() {
+#if LOG_LEVEL < LOG_LEVEL_NONE
+	Logger::get().flush();
+#endif
+}
@@ -0,0 +1,375 @@
+#include "memory_allocator.hpp"
+
+//rounds value up to the next multiple of alignment
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+//rounds value down to the previous multiple of alignment
+static VkDeviceSize align_down(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return value / alignment * alignment;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Memory Allocator
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//gathers the memory layout of the device, no memory is allocated until the first resource needs it
+void MemoryAllocator::initialize(VkPhysicalDevice physical_device, VkDevice logical_device, VkDeviceSize block_size)
+{
+	info("Initializing memory allocator...");
+	m_logical_device = logical_device;
+	m_block_size = block_size;
+
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &m_memory_properties);
+	m_blocks.resize(m_memory_properties.memoryTypeCount);
+
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+	m_buffer_image_granularity = std::max<VkDeviceSize>(device_properties.limits.bufferImageGranularity, 1);
+	m_max_allocation_count = device_properties.limits.maxMemoryAllocationCount;
+
+	succ("Memory allocator initialized");
+}
+
+//frees every block, all resources bound to them have to be destroyed already
+void MemoryAllocator::destroy()
+{
+	info("Destroying memory allocator...");
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (std::vector<Block> &blocks : m_blocks)
+	{
+		for (Block &block : blocks)
+		{
+			if (!block.ranges.empty())
+			{
+				warn(block.ranges.size(), " allocations were not freed before destroying the allocator");
+			}
+			if (block.mapped)
+			{
+				vkUnmapMemory(m_logical_device, block.memory);
+			}
+			vkFreeMemory(m_logical_device, block.memory, nullptr);
+			MemoryTracker::get().untrack_block(block.size);
+		}
+		blocks.clear();
+	}
+	succ("Memory allocator destroyed");
+}
+
+//hands out a range that fulfills size, alignment and memory type of the requirements
+Allocation MemoryAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear, MemoryCategory category)
+{
+	uint32_t memory_type = find_memory_type(requirements.memoryTypeBits, properties);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::vector<Block> &blocks = m_blocks[memory_type];
+
+	Allocation allocation = {};
+	allocation.memory_type = memory_type;
+	allocation.size = requirements.size;
+	allocation.category = category;
+
+	//first fit through the existing blocks
+	VkDeviceSize offset = 0;
+	uint32_t block_index = 0;
+	for (; block_index < blocks.size(); block_index++)
+	{
+		if (try_allocate_in_block(blocks[block_index], requirements, linear, offset))
+			break;
+	}
+
+	//nothing fits, get a new block that is at least big enough for this resource
+	if (block_index == blocks.size())
+	{
+		//close to the budget a block just big enough may still fit where a full one does not
+		VkDeviceSize block_size = std::max(m_block_size, requirements.size);
+		if (!MemoryTracker::get().fits_budget(m_memory_properties.memoryTypes[memory_type].heapIndex, block_size))
+		{
+			block_size = requirements.size;
+		}
+		block_index = create_block(memory_type, block_size);
+		if (!try_allocate_in_block(blocks[block_index], requirements, linear, offset))
+		{
+			throw std::runtime_error("Allocation does not fit into a fresh memory block");
+		}
+	}
+
+	Block &block = blocks[block_index];
+	allocation.memory = block.memory;
+	allocation.offset = offset;
+	allocation.block_index = block_index;
+	allocation.mapped = block.mapped ? static_cast<char *>(block.mapped) + offset : nullptr;
+	MemoryTracker::get().track_device(category, allocation.size);
+	return allocation;
+}
+
+//returns the range of the allocation to its block
+void MemoryAllocator::free(Allocation &allocation)
+{
+	//freeing something that never got allocated is fine, just like vkFreeMemory with VK_NULL_HANDLE
+	if (allocation.memory == VK_NULL_HANDLE)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Block &block = m_blocks[allocation.memory_type][allocation.block_index];
+	auto range = std::find_if(block.ranges.begin(), block.ranges.end(), [&](const Range &r) { return r.offset == allocation.offset; });
+	if (range == block.ranges.end())
+	{
+		throw std::runtime_error("Freed allocation does not belong to the allocator");
+	}
+	block.ranges.erase(range);
+	MemoryTracker::get().untrack_device(allocation.category, allocation.size);
+	allocation = {};
+}
+
+//returns the memory type index that fulfills the properties needed
+uint32_t MemoryAllocator::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties)
+{
+	//work bit vodoo with flags
+	for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++)
+	{
+		//return if the memory type fits the type filter and fulfills the needed properties
+		if ((type_filter & (1 << i)) && (m_memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			return i;
+		}
+	}
+	throw std::runtime_error("No suitable memory found");
+}
+
+//walks the gaps between the used ranges of a block and takes the first one that fits
+bool MemoryAllocator::try_allocate_in_block(Block &block, const VkMemoryRequirements &requirements, bool linear, VkDeviceSize &offset)
+{
+	VkDeviceSize gap_start = 0;
+	for (size_t i = 0; i <= block.ranges.size(); i++)
+	{
+		const Range *previous = i > 0 ? &block.ranges[i - 1] : nullptr;
+		const Range *next = i < block.ranges.size() ? &block.ranges[i] : nullptr;
+		VkDeviceSize gap_end = next ? next->offset : block.size;
+
+		VkDeviceSize candidate = align_up(gap_start, requirements.alignment);
+		//linear and optimal resources sharing a granularity page may alias, so push them onto separate pages
+		if (previous && previous->linear != linear && align_down(previous->offset + previous->size - 1, m_buffer_image_granularity) == align_down(candidate, m_buffer_image_granularity))
+		{
+			candidate = align_up(candidate, m_buffer_image_granularity);
+		}
+
+		VkDeviceSize candidate_end = candidate + requirements.size;
+		bool fits = candidate_end <= gap_end;
+		if (fits && next && next->linear != linear && align_down(candidate_end - 1, m_buffer_image_granularity) == align_down(next->offset, m_buffer_image_granularity))
+		{
+			fits = false;
+		}
+
+		if (fits)
+		{
+			block.ranges.insert(block.ranges.begin() + i, { candidate, requirements.size, linear });
+			offset = candidate;
+			return true;
+		}
+		if (next)
+		{
+			gap_start = next->offset + next->size;
+		}
+	}
+	return false;
+}
+
+//allocates a new block of device memory and maps it if the memory type allows it
+uint32_t MemoryAllocator::create_block(uint32_t memory_type, VkDeviceSize size)
+{
+	info("\tAllocating memory block of ", size, " bytes for memory type ", memory_type);
+	if (m_max_allocation_count && get_block_count() + 1 > m_max_allocation_count)
+	{
+		throw std::runtime_error("Exceeding maxMemoryAllocationCount");
+	}
+	MemoryTracker::get().check_device_allocation(m_memory_properties.memoryTypes[memory_type].heapIndex, size);
+
+	VkMemoryAllocateInfo memory_allocate_info = {};
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = size;
+	memory_allocate_info.memoryTypeIndex = memory_type;
+
+	Block block = {};
+	block.size = size;
+	if (vkAllocateMemory(m_logical_device, &memory_allocate_info, nullptr, &block.memory) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Memory block allocation failed");
+	}
+
+	//memory can only be mapped once, so host visible blocks stay mapped for their whole lifetime
+	if (m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (vkMapMemory(m_logical_device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Mapping memory block failed");
+		}
+	}
+
+	MemoryTracker::get().track_block(size);
+	m_blocks[memory_type].push_back(block);
+	return static_cast<uint32_t>(m_blocks[memory_type].size() - 1);
+}
+
+//counts the blocks of all memory types, expects the mutex to be held
+uint32_t MemoryAllocator::get_block_count()
+{
+	uint32_t count = 0;
+	for (const std::vector<Block> &blocks : m_blocks)
+	{
+		count += static_cast<uint32_t>(blocks.size());
+	}
+	return count;
+}
+
+//collects block, usage and fragmentation numbers over all memory types
+MemoryStatistics MemoryAllocator::get_statistics()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	MemoryStatistics statistics = {};
+	VkDeviceSize bytes_free = 0;
+
+	for (const std::vector<Block> &blocks : m_blocks)
+	{
+		for (const Block &block : blocks)
+		{
+			statistics.block_count++;
+			statistics.bytes_reserved += block.size;
+
+			VkDeviceSize gap_start = 0;
+			for (const Range &range : block.ranges)
+			{
+				statistics.allocation_count++;
+				statistics.bytes_in_use += range.size;
+				statistics.largest_free_range = std::max(statistics.largest_free_range, range.offset - gap_start);
+				gap_start = range.offset + range.size;
+			}
+			statistics.largest_free_range = std::max(statistics.largest_free_range, block.size - gap_start);
+		}
+	}
+
+	bytes_free = statistics.bytes_reserved - statistics.bytes_in_use;
+	if (bytes_free > 0)
+	{
+		statistics.fragmentation = 1.0f - static_cast<float>(statistics.largest_free_range) / static_cast<float>(bytes_free);
+	}
+	return statistics;
+}
+
+//puts out the current statistics
+void MemoryAllocator::print_statistics()
+{
+	MemoryStatistics statistics = get_statistics();
+	info("Device memory:");
+	info("\tBlocks: ", statistics.block_count, " of ", m_max_allocation_count, " allowed");
+	info("\tAllocations: ", statistics.allocation_count);
+	info("\tIn use: ", statistics.bytes_in_use, " of ", statistics.bytes_reserved, " bytes reserved");
+	info("\tFragmentation: ", statistics.fragmentation);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Staging Arena
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//sets up the arena, the first chunk is created on the first allocation
+void StagingArena::initialize(VkDevice logical_device, MemoryAllocator *allocator, VkDeviceSize chunk_size)
+{
+	m_logical_device = logical_device;
+	m_allocator = allocator;
+	m_chunk_size = chunk_size;
+}
+
+//releases every chunk back to the allocator
+void StagingArena::destroy()
+{
+	for (Chunk &chunk : m_chunks)
+	{
+		destroy_chunk(chunk);
+	}
+	m_chunks.clear();
+}
+
+//bumps a region off the current chunk, starts a new chunk if it does not fit
+StagingRegion StagingArena::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+	if (m_chunks.empty() || align_up(m_chunks.back().head, alignment) + size > m_chunks.back().allocation.size)
+	{
+		create_chunk(std::max(m_chunk_size, size));
+	}
+
+	Chunk &chunk = m_chunks.back();
+	StagingRegion region = {};
+	region.buffer = chunk.buffer;
+	region.offset = align_up(chunk.head, alignment);
+	region.mapped = static_cast<char *>(chunk.allocation.mapped) + region.offset;
+	chunk.head = region.offset + size;
+	return region;
+}
+
+//makes the whole arena available again, keeps the first chunk around for the next uploads
+void StagingArena::reset()
+{
+	for (size_t i = 1; i < m_chunks.size(); i++)
+	{
+		destroy_chunk(m_chunks[i]);
+	}
+	if (m_chunks.size() > 1)
+	{
+		m_chunks.resize(1);
+	}
+	if (!m_chunks.empty())
+	{
+		m_chunks[0].head = 0;
+	}
+}
+
+//sums up what is currently handed out
+VkDeviceSize StagingArena::get_bytes_in_use()
+{
+	VkDeviceSize bytes = 0;
+	for (const Chunk &chunk : m_chunks)
+	{
+		bytes += chunk.head;
+	}
+	return bytes;
+}
+
+//creates a host visible transfer source buffer spanning the whole chunk
+void StagingArena::create_chunk(VkDeviceSize size)
+{
+	Chunk chunk = {};
+
+	VkBufferCreateInfo buffer_create_info = {};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(m_logical_device, &buffer_create_info, nullptr, &chunk.buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Staging buffer creation failed");
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(m_logical_device, chunk.buffer, &memory_requirements);
+	chunk.allocation = m_allocator->allocate(memory_requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true, MemoryCategory::staging);
+	//the allocation might be bigger than requested, the buffer is not
+	chunk.allocation.size = size;
+	vkBindBufferMemory(m_logical_device, chunk.buffer, chunk.allocation.memory, chunk.allocation.offset);
+
+	m_chunks.push_back(chunk);
+}
+
+//destroys the buffer of a chunk and gives its memory back
+void StagingArena::destroy_chunk(Chunk &chunk)
+{
+	vkDestroyBuffer(m_logical_device, chunk.buffer, nullptr);
+	m_allocator->free(chunk.allocation);
+}
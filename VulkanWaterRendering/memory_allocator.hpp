@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+#include "memory_tracker.hpp"
+
+//A range of device memory handed out by the MemoryAllocator.
+//Resources are bound at memory + offset, host visible memory is persistently mapped.
+struct Allocation
+{
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	//points to the first byte of the allocation if the memory is host visible, nullptr otherwise
+	void *mapped = nullptr;
+	uint32_t memory_type = 0;
+	uint32_t block_index = 0;
+	MemoryCategory category = MemoryCategory::other;
+};
+
+//A snapshot of what the allocator currently holds
+struct MemoryStatistics
+{
+	//number of vkAllocateMemory calls currently alive
+	uint32_t block_count = 0;
+	//number of resources living inside those blocks
+	uint32_t allocation_count = 0;
+	VkDeviceSize bytes_reserved = 0;
+	VkDeviceSize bytes_in_use = 0;
+	VkDeviceSize largest_free_range = 0;
+	//0 if all free memory is one contiguous range, approaching 1 the more scattered it is
+	float fragmentation = 0.0f;
+};
+
+//Sub-allocates resources from big memory blocks, one list of blocks per memory type.
+//Vulkan only guarantees a few thousand vkAllocateMemory calls (maxMemoryAllocationCount),
+//so every buffer and image gets a range inside a shared block instead of its own allocation.
+class MemoryAllocator
+{
+public:
+	void initialize(VkPhysicalDevice physical_device, VkDevice logical_device, VkDeviceSize block_size = 64 * 1024 * 1024);
+	void destroy();
+
+	//linear resources are buffers and linearly tiled images, they must keep bufferImageGranularity apart from optimal images
+	//the category is what the memory tracker counts the allocation as
+	Allocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear = true, MemoryCategory category = MemoryCategory::other);
+	void free(Allocation &allocation);
+
+	uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties);
+
+	MemoryStatistics get_statistics();
+	void print_statistics();
+
+private:
+	//a used range inside a block
+	struct Range
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		bool linear;
+	};
+
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		void *mapped = nullptr;
+		//sorted by offset
+		std::vector<Range> ranges;
+	};
+
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties m_memory_properties = {};
+	VkDeviceSize m_block_size = 0;
+	VkDeviceSize m_buffer_image_granularity = 1;
+	uint32_t m_max_allocation_count = 0;
+
+	//one list of blocks per memory type
+	std::vector<std::vector<Block>> m_blocks;
+	std::mutex m_mutex;
+
+	bool try_allocate_in_block(Block &block, const VkMemoryRequirements &requirements, bool linear, VkDeviceSize &offset);
+	uint32_t create_block(uint32_t memory_type, VkDeviceSize size);
+	uint32_t get_block_count();
+};
+
+//A piece of the staging arena, ready to be written to and copied from
+struct StagingRegion
+{
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	void *mapped = nullptr;
+};
+
+//Linear allocator for transient staging data.
+//Regions are bumped off a host visible buffer and all released at once with reset(),
+//once the transfers reading from them are known to be finished.
+class StagingArena
+{
+public:
+	void initialize(VkDevice logical_device, MemoryAllocator *allocator, VkDeviceSize chunk_size = 32 * 1024 * 1024);
+	void destroy();
+
+	StagingRegion allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+	//only call this when no transfer reads from the arena anymore
+	void reset();
+
+	VkDeviceSize get_bytes_in_use();
+
+private:
+	struct Chunk
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		Allocation allocation;
+		VkDeviceSize head = 0;
+	};
+
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	MemoryAllocator *m_allocator = nullptr;
+	VkDeviceSize m_chunk_size = 0;
+	std::vector<Chunk> m_chunks;
+
+	void create_chunk(VkDeviceSize size);
+	void destroy_chunk(Chunk &chunk);
+};
@@ -0,0 +1,318 @@
+#include "memory_tracker.hpp"
+
+const char *get_category_name(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::mesh:
+		return "mesh";
+	case MemoryCategory::displacement:
+		return "displacement";
+	case MemoryCategory::simulation:
+		return "simulation";
+	case MemoryCategory::staging:
+		return "staging";
+	case MemoryCategory::uniforms:
+		return "uniforms";
+	case MemoryCategory::textures:
+		return "textures";
+	case MemoryCategory::render_targets:
+		return "render targets";
+	default:
+		return "other";
+	}
+}
+
+//sits right in front of every block handed to the driver, so free knows what it gives back
+struct DriverAllocationHeader
+{
+	void *raw;
+	size_t size;
+	VkSystemAllocationScope scope;
+};
+
+MemoryTracker::MemoryTracker() : m_budget(0), m_reserved_bytes(0), m_driver_peak_bytes(0), m_driver_internal_bytes(0)
+{
+	for (std::atomic<VkDeviceSize> &bytes : m_device_bytes)
+	{
+		bytes.store(0);
+	}
+	for (std::atomic<int64_t> &bytes : m_driver_bytes)
+	{
+		bytes.store(0);
+	}
+
+	m_allocation_callbacks = {};
+	m_allocation_callbacks.pUserData = this;
+	m_allocation_callbacks.pfnAllocation = &MemoryTracker::allocation;
+	m_allocation_callbacks.pfnReallocation = &MemoryTracker::reallocation;
+	m_allocation_callbacks.pfnFree = &MemoryTracker::free;
+	m_allocation_callbacks.pfnInternalAllocation = &MemoryTracker::internal_allocation;
+	m_allocation_callbacks.pfnInternalFree = &MemoryTracker::internal_free;
+}
+
+//the one tracker, it has to outlive the instance the driver callbacks belong to
+MemoryTracker &MemoryTracker::get()
+{
+	static MemoryTracker tracker;
+	return tracker;
+}
+
+//the budget extension needs vkGetPhysicalDeviceMemoryProperties2, which vulkan 1.0 only has through VK_KHR_get_physical_device_properties2
+void MemoryTracker::initialize(VkInstance instance, VkPhysicalDevice physical_device, bool memory_budget_enabled)
+{
+	m_physical_device = physical_device;
+	m_get_memory_properties_2 = nullptr;
+	if (memory_budget_enabled)
+	{
+		m_get_memory_properties_2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+	}
+	if (m_get_memory_properties_2 == nullptr)
+	{
+		info("VK_EXT_memory_budget not available, heap budgets are unknown");
+	}
+}
+
+void MemoryTracker::set_budget(VkDeviceSize budget)
+{
+	m_budget.store(budget);
+}
+
+VkDeviceSize MemoryTracker::get_budget()
+{
+	return m_budget.load();
+}
+
+void MemoryTracker::track_device(MemoryCategory category, VkDeviceSize size)
+{
+	m_device_bytes[static_cast<size_t>(category)].fetch_add(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::untrack_device(MemoryCategory category, VkDeviceSize size)
+{
+	m_device_bytes[static_cast<size_t>(category)].fetch_sub(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::track_block(VkDeviceSize size)
+{
+	m_reserved_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::untrack_block(VkDeviceSize size)
+{
+	m_reserved_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::set_host_bytes(const std::string &owner, MemoryCategory category, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_host_mutex);
+	m_host_copies[owner] = { category, size };
+}
+
+void MemoryTracker::clear_host_bytes()
+{
+	std::lock_guard<std::mutex> lock(m_host_mutex);
+	m_host_copies.clear();
+}
+
+bool MemoryTracker::fits_budget(uint32_t heap_index, VkDeviceSize size)
+{
+	VkDeviceSize budget = m_budget.load();
+	if (budget > 0 && get_reserved_bytes() + get_host_bytes() + size > budget)
+		return false;
+
+	std::vector<HeapBudget> heap_budgets = get_heap_budgets();
+	return heap_index >= heap_budgets.size() || heap_budgets[heap_index].usage + size <= heap_budgets[heap_index].budget;
+}
+
+void MemoryTracker::check_device_allocation(uint32_t heap_index, VkDeviceSize size)
+{
+	VkDeviceSize budget = m_budget.load();
+	VkDeviceSize in_use = get_reserved_bytes() + get_host_bytes();
+	if (budget > 0 && in_use + size > budget)
+	{
+		throw std::runtime_error("Memory budget of " + std::to_string(budget) + " bytes exceeded, " + std::to_string(in_use) + " bytes in use and " + std::to_string(size) + " more requested");
+	}
+
+	std::vector<HeapBudget> heap_budgets = get_heap_budgets();
+	if (heap_index < heap_budgets.size() && heap_budgets[heap_index].usage + size > heap_budgets[heap_index].budget)
+	{
+		throw std::runtime_error("Memory heap " + std::to_string(heap_index) + " is out of budget, " + std::to_string(heap_budgets[heap_index].usage) + " of " + std::to_string(heap_budgets[heap_index].budget) + " bytes used and " + std::to_string(size) + " more requested");
+	}
+}
+
+std::vector<HeapBudget> MemoryTracker::get_heap_budgets()
+{
+	std::vector<HeapBudget> heap_budgets;
+	if (m_get_memory_properties_2 == nullptr)
+		return heap_budgets;
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = {};
+	budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	VkPhysicalDeviceMemoryProperties2 memory_properties = {};
+	memory_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	memory_properties.pNext = &budget_properties;
+	m_get_memory_properties_2(m_physical_device, &memory_properties);
+
+	for (uint32_t i = 0; i < memory_properties.memoryProperties.memoryHeapCount; i++)
+	{
+		HeapBudget heap_budget;
+		heap_budget.size = memory_properties.memoryProperties.memoryHeaps[i].size;
+		heap_budget.budget = budget_properties.heapBudget[i];
+		heap_budget.usage = budget_properties.heapUsage[i];
+		heap_budget.device_local = (memory_properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		heap_budgets.push_back(heap_budget);
+	}
+	return heap_budgets;
+}
+
+VkDeviceSize MemoryTracker::get_device_bytes()
+{
+	VkDeviceSize total = 0;
+	for (const std::atomic<VkDeviceSize> &bytes : m_device_bytes)
+	{
+		total += bytes.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+VkDeviceSize MemoryTracker::get_reserved_bytes()
+{
+	return m_reserved_bytes.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::get_host_bytes()
+{
+	std::lock_guard<std::mutex> lock(m_host_mutex);
+	size_t total = 0;
+	for (const auto &host_copy : m_host_copies)
+	{
+		total += host_copy.second.size;
+	}
+	return total;
+}
+
+const VkAllocationCallbacks *MemoryTracker::get_allocation_callbacks()
+{
+	return &m_allocation_callbacks;
+}
+
+//puts out where the memory goes, by category, by host copy, for the driver and per heap
+void MemoryTracker::print_report()
+{
+	//straight to the console, release builds compile info out
+	flush_log();
+	std::cout << "Memory report:" << std::endl;
+	std::cout << "\tDevice: " << get_device_bytes() << " bytes in use, " << get_reserved_bytes() << " bytes reserved" << std::endl;
+	for (size_t i = 0; i < m_device_bytes.size(); i++)
+	{
+		VkDeviceSize bytes = m_device_bytes[i].load(std::memory_order_relaxed);
+		if (bytes > 0)
+		{
+			std::cout << "\t\t" << get_category_name(static_cast<MemoryCategory>(i)) << ": " << bytes << " bytes" << std::endl;
+		}
+	}
+
+	std::cout << "\tHost copies: " << get_host_bytes() << " bytes" << std::endl;
+	{
+		std::lock_guard<std::mutex> lock(m_host_mutex);
+		for (const auto &host_copy : m_host_copies)
+		{
+			std::cout << "\t\t" << host_copy.first << " (" << get_category_name(host_copy.second.category) << "): " << host_copy.second.size << " bytes" << std::endl;
+		}
+	}
+
+	int64_t driver_bytes = 0;
+	for (const std::atomic<int64_t> &bytes : m_driver_bytes)
+	{
+		driver_bytes += bytes.load(std::memory_order_relaxed);
+	}
+	std::cout << "\tDriver: " << driver_bytes << " bytes, peak " << m_driver_peak_bytes.load() << ", internal " << m_driver_internal_bytes.load() << std::endl;
+
+	VkDeviceSize budget = m_budget.load();
+	if (budget > 0)
+	{
+		std::cout << "\tBudget: " << get_reserved_bytes() + get_host_bytes() << " of " << budget << " bytes used" << std::endl;
+	}
+
+	std::vector<HeapBudget> heap_budgets = get_heap_budgets();
+	for (size_t i = 0; i < heap_budgets.size(); i++)
+	{
+		std::cout << "\tHeap " << i << (heap_budgets[i].device_local ? " (device local)" : "") << ": " << heap_budgets[i].usage << " of " << heap_budgets[i].budget << " bytes budget, " << heap_budgets[i].size << " bytes total" << std::endl;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Driver Callbacks
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//over-allocates to fit the header and the alignment the driver asks for
+void *VKAPI_PTR MemoryTracker::allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (size == 0)
+		return nullptr;
+
+	MemoryTracker *tracker = static_cast<MemoryTracker *>(user_data);
+	alignment = std::max(alignment, alignof(DriverAllocationHeader));
+	char *raw = static_cast<char *>(std::malloc(size + sizeof(DriverAllocationHeader) + alignment));
+	if (raw == nullptr)
+		return nullptr;
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(raw) + sizeof(DriverAllocationHeader);
+	address = (address + alignment - 1) / alignment * alignment;
+	DriverAllocationHeader *header = reinterpret_cast<DriverAllocationHeader *>(address) - 1;
+	header->raw = raw;
+	header->size = size;
+	header->scope = scope;
+
+	int64_t total = tracker->m_driver_bytes[scope % 5].fetch_add(size, std::memory_order_relaxed) + size;
+	int64_t peak = tracker->m_driver_peak_bytes.load(std::memory_order_relaxed);
+	while (total > peak && !tracker->m_driver_peak_bytes.compare_exchange_weak(peak, total, std::memory_order_relaxed))
+	{
+	}
+	return reinterpret_cast<void *>(address);
+}
+
+//the original may have a different alignment, so always move to a fresh allocation
+void *VKAPI_PTR MemoryTracker::reallocation(void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (original == nullptr)
+		return allocation(user_data, size, alignment, scope);
+	if (size == 0)
+	{
+		free(user_data, original);
+		return nullptr;
+	}
+
+	void *memory = allocation(user_data, size, alignment, scope);
+	if (memory == nullptr)
+		return nullptr;
+
+	DriverAllocationHeader *header = static_cast<DriverAllocationHeader *>(original) - 1;
+	std::memcpy(memory, original, std::min(size, header->size));
+	free(user_data, original);
+	return memory;
+}
+
+void VKAPI_PTR MemoryTracker::free(void *user_data, void *memory)
+{
+	if (memory == nullptr)
+		return;
+
+	MemoryTracker *tracker = static_cast<MemoryTracker *>(user_data);
+	DriverAllocationHeader *header = static_cast<DriverAllocationHeader *>(memory) - 1;
+	tracker->m_driver_bytes[header->scope % 5].fetch_sub(header->size, std::memory_order_relaxed);
+	std::free(header->raw);
+}
+
+void VKAPI_PTR MemoryTracker::internal_allocation(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+	static_cast<MemoryTracker *>(user_data)->m_driver_internal_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void VKAPI_PTR MemoryTracker::internal_free(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+	static_cast<MemoryTracker *>(user_data)->m_driver_internal_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <array>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+
+//What memory is used for, every device allocation and tracked host copy belongs to one
+enum class MemoryCategory { mesh, displacement, simulation, staging, uniforms, textures, render_targets, other, count };
+
+const char *get_category_name(MemoryCategory category);
+
+//What a device heap may still take according to VK_EXT_memory_budget
+struct HeapBudget
+{
+	VkDeviceSize size = 0;
+	//what the process may use of the heap, including what it already uses
+	VkDeviceSize budget = 0;
+	VkDeviceSize usage = 0;
+	bool device_local = false;
+};
+
+//Keeps count of the memory the application uses, sorted by category.
+//Device memory is counted by the MemoryAllocator, big host side copies register themselves by name,
+//and what the driver allocates on the host is counted through the allocation callbacks handed to vulkan.
+//With a budget set, device allocations that would exceed it are refused.
+class MemoryTracker
+{
+public:
+	static MemoryTracker &get();
+
+	//picks up the heap budgets of the device if VK_EXT_memory_budget is enabled on it
+	void initialize(VkInstance instance, VkPhysicalDevice physical_device, bool memory_budget_enabled);
+	//0 means no budget, the budget covers device memory and tracked host copies together
+	void set_budget(VkDeviceSize budget);
+	VkDeviceSize get_budget();
+
+	//what the resources of a category use
+	void track_device(MemoryCategory category, VkDeviceSize size);
+	void untrack_device(MemoryCategory category, VkDeviceSize size);
+	//what the allocator reserved with vkAllocateMemory, the budget is checked against this
+	void track_block(VkDeviceSize size);
+	void untrack_block(VkDeviceSize size);
+	//sets the size of a named host copy, setting it again replaces the old size
+	void set_host_bytes(const std::string &owner, MemoryCategory category, size_t size);
+	void clear_host_bytes();
+
+	//whether a new device memory block of that size stays within the budget and the heap budget
+	bool fits_budget(uint32_t heap_index, VkDeviceSize size);
+	//throws if it does not
+	void check_device_allocation(uint32_t heap_index, VkDeviceSize size);
+
+	//empty if VK_EXT_memory_budget is not available
+	std::vector<HeapBudget> get_heap_budgets();
+	VkDeviceSize get_device_bytes();
+	VkDeviceSize get_reserved_bytes();
+	size_t get_host_bytes();
+
+	//counts what the driver allocates on the host, pass to instance and device creation and destruction
+	const VkAllocationCallbacks *get_allocation_callbacks();
+
+	void print_report();
+
+private:
+	struct HostCopy
+	{
+		MemoryCategory category;
+		size_t size;
+	};
+
+	VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+	PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_get_memory_properties_2 = nullptr;
+	std::atomic<VkDeviceSize> m_budget;
+
+	std::array<std::atomic<VkDeviceSize>, static_cast<size_t>(MemoryCategory::count)> m_device_bytes;
+	std::atomic<VkDeviceSize> m_reserved_bytes;
+	std::mutex m_host_mutex;
+	std::map<std::string, HostCopy> m_host_copies;
+
+	//driver side, split by VkSystemAllocationScope
+	std::array<std::atomic<int64_t>, 5> m_driver_bytes;
+	std::atomic<int64_t> m_driver_peak_bytes;
+	std::atomic<int64_t> m_driver_internal_bytes;
+	VkAllocationCallbacks m_allocation_callbacks;
+
+	MemoryTracker();
+
+	static void *VKAPI_PTR allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static void *VKAPI_PTR reallocation(void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static void VKAPI_PTR free(void *user_data, void *memory);
+	static void VKAPI_PTR internal_allocation(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+	static void VKAPI_PTR internal_free(void *user_data, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+};
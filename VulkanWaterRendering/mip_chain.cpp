@@ -0,0 +1,66 @@
+#include "mip_chain.hpp"
+
+uint32_t get_mip_level_count(uint32_t width, uint32_t height)
+{
+	uint32_t size = std::max(width, height);
+	uint32_t levels = 1;
+	while ((size >> levels) > 0)
+		levels++;
+	return levels;
+}
+
+bool supports_mip_blits(VkPhysicalDevice physical_device, VkFormat format)
+{
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_properties);
+	VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (format_properties.optimalTilingFeatures & required) == required;
+}
+
+//all images go through a level together, so there is one barrier per level instead of one per image and level
+void record_mip_chain(VkCommandBuffer command_buffer, const std::vector<VkImage> &images, uint32_t width, uint32_t height, uint32_t mip_levels)
+{
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (uint32_t level = 1; level < mip_levels; level++)
+	{
+		VkImageBlit blit = {};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { static_cast<int32_t>(std::max(width >> (level - 1), 1u)), static_cast<int32_t>(std::max(height >> (level - 1), 1u)), 1 };
+		blit.dstSubresource = blit.srcSubresource;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { static_cast<int32_t>(std::max(width >> level, 1u)), static_cast<int32_t>(std::max(height >> level, 1u)), 1 };
+
+		barriers.clear();
+		for (VkImage image : images)
+		{
+			vkCmdBlitImage(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+			//the next level is blitted from this one
+			barriers.push_back(mip_barrier(image, level, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+		}
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+	}
+}
+
+VkImageMemoryBarrier mip_barrier(VkImage image, uint32_t first_level, uint32_t level_count, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access)
+{
+	VkImageMemoryBarrier image_memory_barrier = {};
+	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_memory_barrier.oldLayout = old_layout;
+	image_memory_barrier.newLayout = new_layout;
+	image_memory_barrier.srcAccessMask = src_access;
+	image_memory_barrier.dstAccessMask = dst_access;
+	image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.image = image;
+	image_memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_memory_barrier.subresourceRange.baseMipLevel = first_level;
+	image_memory_barrier.subresourceRange.levelCount = level_count;
+	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
+	image_memory_barrier.subresourceRange.layerCount = 1;
+	return image_memory_barrier;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+//Mip chains built on the device, every level is blitted with a linear filter from the one before, which averages
+//2x2 texels. Blits only run on a graphics queue and the format has to support them, see supports_mip_blits.
+//Distant surfaces then read a level where a texel is about as large as a pixel instead of skipping texels, which
+//reads less memory and does not shimmer.
+
+//levels down to 1x1, a 512x256 image has 10
+uint32_t get_mip_level_count(uint32_t width, uint32_t height);
+//if images of the format can be blitted into each other with a linear filter
+bool supports_mip_blits(VkPhysicalDevice physical_device, VkFormat format);
+//fills every level but 0 of the images, which all have the same size and level count
+//level 0 has to be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, all others in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+//afterwards every level is in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+void record_mip_chain(VkCommandBuffer command_buffer, const std::vector<VkImage> &images, uint32_t width, uint32_t height, uint32_t mip_levels);
+//a barrier over some levels of a color image on the same queue family
+VkImageMemoryBarrier mip_barrier(VkImage image, uint32_t first_level, uint32_t level_count, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access);
@@ -61,27 +61,51 @@ void Ocean::initializeVertices(uint32_t resolution)
 }
 
 //adds new gerstner waves to the ocean
-void Ocean::initializeWave(uint32_t resolution)
+void Ocean::initializeWave(uint32_t resolution, uint32_t wave_count, const SpectrumParameters &spectrum)
 {
+	if (spectrum.type != SpectrumType::none)
+	{
+		//x0 counts grid cells, a wave shorter than 4 of them would alias, one longer than the grid looks flat
+		WaveSpectrum wave_spectrum(spectrum);
+		m_waves = wave_spectrum.sample(wave_count == 0 ? DEFAULT_SPECTRUM_WAVE_COUNT : wave_count, 4.0f, 2.0f * resolution);
+		info("Sampled ", m_waves.size(), " waves from the spectrum, peak wavelength ", 2.0f * 3.14159265f * 9.81f / (wave_spectrum.get_peak_frequency() * wave_spectrum.get_peak_frequency()));
+		return;
+	}
+
 	//m_waves.push_back(Gerstner(glm::vec2(1.0f, 0.7f), 3.0f, 80.0f, 20.0f));
-	m_waves.push_back(Gerstner(glm::vec2(-0.50f, 3.0f), 1.20f, 32.0f, 40.4f));
-	//m_waves.push_back(Gerstner(glm::vec2(-2.0f, -3.0f), 1.30f, 120.0f, 30.4f));
-	m_waves.push_back(Gerstner(glm::vec2(2.0f, -4.0f), 1.40f, 26.0f, 15.4f));
-	//m_waves.push_back(Gerstner(glm::vec2(2.0f, 4.0f), 1.50f, 200.0f, 10.4f));
-	m_waves.push_back(Gerstner(glm::vec2(2.0f, 7.0f), 1.0f, 30.0f, 17.8f));
-	m_waves.push_back(Gerstner(glm::vec2(-3.0f, 4.0f), 1.820f, 160.0f, 18.3f));
-	m_waves.push_back(Gerstner(glm::vec2(56.0f, -34.0f), 1.670f, 34.0f, 21.1f));
+	m_waves.push_back(Gerstner(glm::vec2(-0.50f, 3.0f), 1.20f, 32.0f));
+	//m_waves.push_back(Gerstner(glm::vec2(-2.0f, -3.0f), 1.30f, 120.0f));
+	m_waves.push_back(Gerstner(glm::vec2(2.0f, -4.0f), 1.40f, 26.0f));
+	//m_waves.push_back(Gerstner(glm::vec2(2.0f, 4.0f), 1.50f, 200.0f));
+	m_waves.push_back(Gerstner(glm::vec2(2.0f, 7.0f), 1.0f, 30.0f));
+	m_waves.push_back(Gerstner(glm::vec2(-3.0f, 4.0f), 1.820f, 160.0f));
+	m_waves.push_back(Gerstner(glm::vec2(56.0f, -34.0f), 1.670f, 34.0f));
 
-	//random waves look bad
+	//random waves look bad, a spectrum gives them the right amplitudes
 
 	//for (uint32_t i = 0; i < 5; i++) {
 	//	m_waves.push_back(Gerstner(glm::vec2(random(), random()), random(5.0f), random(resolution), random(32)));
 	//}
+
+	if (wave_count == 0)
+		return;
+
+	//instead every further wave is a turned, shorter and flatter copy of a predefined one, so runs stay comparable
+	uint32_t predefined_count = static_cast<uint32_t>(m_waves.size());
+	for (uint32_t i = predefined_count; i < wave_count; i++)
+	{
+		m_waves.push_back(m_waves[i % predefined_count].get_variation(i / predefined_count));
+	}
+	while (m_waves.size() > wave_count)
+	{
+		m_waves.pop_back();
+	}
 }
 
 //setting up the ocean surface
-Ocean::Ocean(uint32_t resolution, float tilesize)
+Ocean::Ocean(uint32_t resolution, float tilesize, uint32_t wave_count, const SpectrumParameters &spectrum)
 {
+	PROFILE_FUNCTION();
 	info("Setting up Ocean...");
 	if (resolution > 64) {
 		warn("WARNING: Entering resolutions higher than 128 might become very demanding and will require considerable time to generate the ocean surface and indices.");
@@ -89,7 +113,9 @@ Ocean::Ocean(uint32_t resolution, float tilesize)
 	this->resolution = resolution;
 	tile_size = tilesize;
 	initializeVertices(resolution);
-	initializeWave(resolution);
+	initializeWave(resolution, wave_count, spectrum);
+	//the lod evaluates a prefix of the waves, the further from the camera the shorter it gets
+	std::stable_sort(m_waves.begin(), m_waves.end(), [](const Gerstner &a, const Gerstner &b) { return a.get_wavelength() > b.get_wavelength(); });
 	succ("Ocean successfully initialized");
 }
 
@@ -106,14 +132,366 @@ std::vector<uint32_t> Ocean::getIndices()
 }
 
 //applies all known waves and returns a vector containing all displacements necessary
-std::vector<Displacement> Ocean::update_waves(float time) {
-	std::vector<Displacement> current_displacement = {};
+std::vector<Displacement> Ocean::update_waves(float time, const WaveLod &lod) {
+	PROFILE_FUNCTION();
+	std::vector<Displacement> current_displacement(m_vertices.size());
+	update_waves(time, lod, 0, 0, resolution, resolution, current_displacement.data());
+	return current_displacement;
+}
+
+//the phase of vertex (x, y) is step_x * x + step_y * y + start, the same as in Gerstner::get_displacement
+struct WaveTerms
+{
+	float step_x;
+	float step_y;
+	float start;
+	float horizontal_x;
+	float horizontal_y;
+	float amplitude;
+	float wavelength;
+};
+
+//adds the waves [first_wave, last_wave) at the vertices first + (column, row) * spacing, for columns < width and rows < height,
+//to displacements[row * row_stride + column]
+static void add_waves(const std::vector<WaveTerms> &terms, size_t first_wave, size_t last_wave, const WaveLod &lod, uint32_t first_x, uint32_t first_y, uint32_t width, uint32_t height, uint32_t spacing, Displacement *displacements, size_t row_stride) {
+	//the recurrence is a chain of dependent multiplies, so every wave walks the row as LANES interleaved
+	//chains, lane i covers the columns i, i + LANES, ... which keeps the cpu busy instead of waiting
+	const uint32_t LANES = 4;
+	//rows are split into segments that each decide which waves they need, short waves only reach the segments near the camera
+	const uint32_t SEGMENT = 64;
+	float cutoffs[SEGMENT];
+	float weights[SEGMENT];
+	float full_weights[SEGMENT];
+	std::fill(full_weights, full_weights + SEGMENT, 1.0f);
+
+	for (uint32_t row = 0; row < height; row++) {
+		float y = static_cast<float>(first_y + row * spacing);
+		for (uint32_t first = 0; first < width; first += SEGMENT) {
+			uint32_t length = std::min(SEGMENT, width - first);
+			Displacement *segment_displacement = displacements + row * row_stride + first;
+
+			float nearest_cutoff = std::numeric_limits<float>::max();
+			float furthest_cutoff = 0.0f;
+			for (uint32_t column = 0; column < length; column++) {
+				cutoffs[column] = lod.get_cutoff(glm::vec2(static_cast<float>(first_x + (first + column) * spacing), y));
+				nearest_cutoff = std::min(nearest_cutoff, cutoffs[column]);
+				furthest_cutoff = std::max(furthest_cutoff, cutoffs[column]);
+			}
+
+			for (size_t i = first_wave; i < last_wave; i++) {
+				const WaveTerms &wave = terms[i];
+				//the waves are sorted longest first, everything after this one is even shorter
+				if (nearest_cutoff > 0.0f && wave.wavelength <= nearest_cutoff)
+					break;
+
+				//only waves in the middle of fading out need a weight per vertex
+				const float *wave_weights = full_weights;
+				if (wave.wavelength < 2.0f * furthest_cutoff) {
+					for (uint32_t column = 0; column < length; column++) {
+						weights[column] = WaveLod::get_weight(wave.wavelength, cutoffs[column]);
+					}
+					wave_weights = weights;
+				}
+
+				//cos and sin of the first vertices in the segment, every further vertex of a lane turns them by the same angle
+				float c[LANES];
+				float s[LANES];
+				for (uint32_t lane = 0; lane < LANES; lane++) {
+					float phase = wave.step_x * (first_x + (first + lane) * spacing) + wave.step_y * y + wave.start;
+					c[lane] = cosf(phase);
+					s[lane] = sinf(phase);
+				}
+				float step_c = cosf(wave.step_x * spacing * LANES);
+				float step_s = sinf(wave.step_x * spacing * LANES);
+				for (uint32_t column = 0; column < length; column += LANES) {
+					for (uint32_t lane = 0; lane < LANES && column + lane < length; lane++) {
+						glm::vec3 &displacement = segment_displacement[column + lane].displacement;
+						float weight = wave_weights[column + lane];
+						displacement.x += wave.horizontal_x * weight * c[lane];
+						displacement.y += wave.horizontal_y * weight * c[lane];
+						displacement.z += wave.amplitude * weight * s[lane];
+
+						float next_c = c[lane] * step_c - s[lane] * step_s;
+						s[lane] = s[lane] * step_c + c[lane] * step_s;
+						c[lane] = next_c;
+					}
+				}
+			}
+		}
+	}
+}
+
+void Ocean::update_waves(float time, const WaveLod &lod, uint32_t first_x, uint32_t first_y, uint32_t width, uint32_t height, Displacement *displacements) {
+	if (m_cached_frames > 0) {
+		//where in the loop the time is, between which two frames and how far between them
+		double loops = static_cast<double>(time) / m_cache_period;
+		double frame = (loops - std::floor(loops)) * m_cached_frames;
+		uint32_t first_frame = std::min(static_cast<uint32_t>(frame), m_cached_frames - 1);
+		uint32_t second_frame = (first_frame + 1) % m_cached_frames;
+		float t = static_cast<float>(frame - first_frame);
+		size_t frame_size = static_cast<size_t>(resolution) * resolution;
+		const Displacement *first_displacements = m_frame_cache.data() + first_frame * frame_size;
+		const Displacement *second_displacements = m_frame_cache.data() + second_frame * frame_size;
+		for (uint32_t y = first_y; y < first_y + height; y++) {
+			size_t row = static_cast<size_t>(y) * resolution;
+			for (size_t i = row + first_x; i < row + first_x + width; i++) {
+				displacements[i].displacement += first_displacements[i].displacement + (second_displacements[i].displacement - first_displacements[i].displacement) * t;
+			}
+		}
+		return;
+	}
+
+	std::vector<WaveTerms> terms;
+	terms.reserve(m_waves.size());
+	for (Gerstner &wave : m_waves) {
+		GerstnerParameters parameters = wave.get_parameters();
+		terms.push_back({
+			parameters.frequency * parameters.direction.x,
+			parameters.frequency * parameters.direction.y,
+			parameters.phase_constant * time + parameters.phase_offset,
+			parameters.steepness * parameters.amplitude * parameters.direction.x,
+			parameters.steepness * parameters.amplitude * parameters.direction.y,
+			parameters.amplitude,
+			parameters.wavelength
+		});
+	}
 
-	if (current_displacement.size() != m_vertices.size()) {
-		current_displacement.resize(m_vertices.size());
+	//the longest waves are a prefix, those that keep enough samples per wavelength go on the coarse grid
+	size_t coarse_count = 0;
+	if (m_coarse_factor > 1) {
+		float shortest_coarse = static_cast<float>(COARSE_SAMPLES_PER_WAVELENGTH * m_coarse_factor);
+		while (coarse_count < terms.size() && terms[coarse_count].wavelength >= shortest_coarse)
+			coarse_count++;
 	}
+
+	if (coarse_count > 0) {
+		//coarse nodes from the one at or before the region to one past its end, so every vertex has four around it
+		uint32_t f = m_coarse_factor;
+		uint32_t node_x = first_x / f;
+		uint32_t node_y = first_y / f;
+		uint32_t nodes_x = (first_x + width - 1) / f - node_x + 2;
+		uint32_t nodes_y = (first_y + height - 1) / f - node_y + 2;
+		std::vector<Displacement> coarse(static_cast<size_t>(nodes_x) * nodes_y);
+		add_waves(terms, 0, coarse_count, lod, node_x * f, node_y * f, nodes_x, nodes_y, f, coarse.data(), nodes_x);
+
+		//the node left of each column and how far between it and the next one the column is, the same for every row
+		std::vector<uint32_t> left_nodes(width);
+		std::vector<float> column_fractions(width);
+		float inverse_f = 1.0f / f;
+		for (uint32_t x = 0; x < width; x++) {
+			uint32_t local_x = first_x + x - node_x * f;
+			left_nodes[x] = local_x / f;
+			column_fractions[x] = (local_x % f) * inverse_f;
+		}
+		for (uint32_t y = first_y; y < first_y + height; y++) {
+			uint32_t local_y = y - node_y * f;
+			float fy = (local_y % f) * inverse_f;
+			const Displacement *top = coarse.data() + static_cast<size_t>(local_y / f) * nodes_x;
+			const Displacement *bottom = top + nodes_x;
+			Displacement *row = displacements + static_cast<size_t>(y) * resolution + first_x;
+			for (uint32_t x = 0; x < width; x++) {
+				uint32_t i = left_nodes[x];
+				float fx = column_fractions[x];
+				glm::vec3 upper = top[i].displacement + (top[i + 1].displacement - top[i].displacement) * fx;
+				glm::vec3 lower = bottom[i].displacement + (bottom[i + 1].displacement - bottom[i].displacement) * fx;
+				row[x].displacement += upper + (lower - upper) * fy;
+			}
+		}
+	}
+
+	add_waves(terms, coarse_count, terms.size(), lod, first_x, first_y, width, height, 1, displacements + static_cast<size_t>(first_y) * resolution + first_x, resolution);
+}
+
+void Ocean::set_coarse_factor(uint32_t factor)
+{
+	if (factor != 1 && factor != 2 && factor != 4 && factor != 8)
+	{
+		throw std::runtime_error("The coarse grid has to be 1, 2, 4 or 8 times coarser, not " + std::to_string(factor));
+	}
+	m_coarse_factor = factor;
+}
+
+//evaluates the waves at time 0 with and without the coarse grid and prints how far apart and how fast they are
+void Ocean::report_coarse_grid(const WaveLod &lod)
+{
+	PROFILE_FUNCTION();
+	if (m_coarse_factor == 1)
+		return;
+
+	//no wave moves a vertex further than its amplitude, horizontally scaled by its steepness
+	float largest_displacement = 0.0f;
+	size_t coarse_count = 0;
+	for (const GerstnerParameters &wave : get_wave_parameters())
+	{
+		largest_displacement += wave.amplitude * std::max(1.0f, wave.steepness);
+		if (wave.wavelength >= COARSE_SAMPLES_PER_WAVELENGTH * m_coarse_factor)
+			coarse_count++;
+	}
+
+	//the fastest of a few runs, a single one is easily thrown off by whatever else the machine does
+	auto time_update = [this, &lod](std::vector<Displacement> &displacements)
+	{
+		double fastest = std::numeric_limits<double>::max();
+		for (uint32_t run = 0; run < 3; run++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			displacements = update_waves(0.0f, lod);
+			fastest = std::min(fastest, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return fastest;
+	};
+	std::vector<Displacement> coarse;
+	double coarse_milliseconds = time_update(coarse);
+	uint32_t factor = m_coarse_factor;
+	m_coarse_factor = 1;
+	std::vector<Displacement> full;
+	double full_milliseconds = time_update(full);
+	m_coarse_factor = factor;
+
+	float max_error = 0.0f;
+	for (size_t i = 0; i < full.size(); i++)
+	{
+		max_error = std::max(max_error, glm::length(coarse[i].displacement - full[i].displacement));
+	}
+	//straight to the console, release builds compile info out and debug timings mean little
+	flush_log();
+	std::cout << "Coarse grid " << factor << "x: " << coarse_count << " of " << m_waves.size() << " waves coarse, " << full_milliseconds / std::max(coarse_milliseconds, 1e-3) << "x faster, max error "
+		<< max_error << " (" << 100.0f * max_error / std::max(largest_displacement, 1e-6f) << "% of the largest displacement)" << std::endl;
+}
+
+//a loop is a multiple of the longest period, so only those need checking
+float Ocean::find_loop_period(float max_period)
+{
+	//radians a wave may be off after the loop, in double as the phase grows large over long loops
+	const double TOLERANCE = 1e-3;
+	const double TWO_PI = 2.0 * 3.14159265358979;
+	std::vector<double> speeds;
+	double slowest = std::numeric_limits<double>::max();
+	for (const GerstnerParameters &wave : get_wave_parameters()) {
+		speeds.push_back(wave.phase_constant);
+		slowest = std::min(slowest, static_cast<double>(wave.phase_constant));
+	}
+	if (speeds.empty() || slowest <= 0.0)
+		return 0.0f;
+
+	double longest_period = TWO_PI / slowest;
+	for (double period = longest_period; period <= max_period; period += longest_period) {
+		bool repeats = true;
+		for (double speed : speeds) {
+			double turns = speed * period / TWO_PI;
+			if (std::abs(turns - std::round(turns)) * TWO_PI > TOLERANCE) {
+				repeats = false;
+				break;
+			}
+		}
+		if (repeats)
+			return static_cast<float>(period);
+	}
+	return 0.0f;
+}
+
+float Ocean::force_loop_period(float period)
+{
+	if (period <= 0.0f)
+	{
+		throw std::runtime_error("A loop has to be longer than 0 seconds");
+	}
+	float largest_change = 0.0f;
+	for (Gerstner &wave : m_waves) {
+		float speed = wave.get_parameters().phase_constant;
+		wave.set_loop_period(period);
+		largest_change = std::max(largest_change, std::abs(wave.get_parameters().phase_constant - speed) / speed);
+	}
+	info("The waves repeat every ", period, "s now, their speeds changed by up to ", 100.0f * largest_change, "%");
+	return largest_change;
+}
+
+float Ocean::snap_waves_to_tile(float tile)
+{
+	if (tile <= 0.0f)
+	{
+		throw std::runtime_error("A tile has to be larger than 0 cells");
+	}
+	float largest_change = 0.0f;
+	for (Gerstner &wave : m_waves) {
+		float wavelength = wave.get_wavelength();
+		wave.set_tile(tile);
+		largest_change = std::max(largest_change, std::abs(wave.get_wavelength() - wavelength) / wavelength);
+	}
+	//rounding can swap waves of about the same length, the lod needs them longest first
+	std::stable_sort(m_waves.begin(), m_waves.end(), [](const Gerstner &a, const Gerstner &b) { return a.get_wavelength() > b.get_wavelength(); });
+	info("The waves repeat every ", tile, " cells now, their wavelengths changed by up to ", 100.0f * largest_change, "%");
+	return largest_change;
+}
+
+//the frames are independent, so they are spread over all cores, the calling thread takes frames as well
+void Ocean::fill_frame_cache(float period, float frame_rate, size_t memory_cap)
+{
+	PROFILE_FUNCTION();
+	m_frame_cache.clear();
+	m_cached_frames = 0;
+	size_t frame_size = static_cast<size_t>(resolution) * resolution;
+	uint32_t frame_count = static_cast<uint32_t>(std::min<double>(std::ceil(period * frame_rate), static_cast<double>(memory_cap / (frame_size * sizeof(Displacement)))));
+	if (frame_count < 2)
+	{
+		warn("Not caching the waves, ", memory_cap, " bytes do not hold two frames of the ", period, "s loop");
+		return;
+	}
+
+	std::vector<Displacement> frames(frame_count * frame_size);
+	std::atomic<uint32_t> next_frame(0);
+	auto work = [&]()
+	{
+		for (uint32_t frame = next_frame++; frame < frame_count; frame = next_frame++)
+		{
+			update_waves(period * frame / frame_count, {}, 0, 0, resolution, resolution, frames.data() + frame * frame_size);
+		}
+	};
+	size_t worker_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), frame_count) - 1;
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < worker_count; i++)
+	{
+		workers.emplace_back(work);
+	}
+	work();
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+
+	m_frame_cache.swap(frames);
+	m_cached_frames = frame_count;
+	m_cache_period = period;
+	track_host_copies();
+	info("Cached ", frame_count, " frames of the ", period, "s loop, ", frame_count / period, " per second, ", m_frame_cache.size() * sizeof(Displacement) / (1024.0 * 1024.0), "MB");
+}
+
+//returns the parameters of all known waves
+std::vector<GerstnerParameters> Ocean::get_wave_parameters() {
+	std::vector<GerstnerParameters> parameters = {};
 	for (Gerstner wave : m_waves) {
-		current_displacement = wave.apply_wave(current_displacement, resolution, tile_size, time);
+		parameters.push_back(wave.get_parameters());
 	}
-	return current_displacement;
-}
\ No newline at end of file
+	return parameters;
+}
+
+std::vector<WaterSample> Ocean::query_surface(const std::vector<glm::vec2> &positions, float time)
+{
+	std::vector<WaterSample> samples(positions.size());
+	create_surface_query().sample(positions.data(), positions.size(), time, samples.data());
+	return samples;
+}
+
+//the mesh is centered on the origin, see initializeVertices
+SurfaceQuery Ocean::create_surface_query()
+{
+	return SurfaceQuery(get_wave_parameters(), glm::vec2(-0.5f * tile_size), tile_size / resolution);
+}
+
+void Ocean::track_host_copies()
+{
+	MemoryTracker &tracker = MemoryTracker::get();
+	tracker.set_host_bytes("Ocean vertices", MemoryCategory::mesh, m_vertices.capacity() * sizeof(Vertex));
+	tracker.set_host_bytes("Ocean indices", MemoryCategory::mesh, m_indices.capacity() * sizeof(uint32_t));
+	tracker.set_host_bytes("Ocean frame cache", MemoryCategory::displacement, m_frame_cache.capacity() * sizeof(Displacement));
+}
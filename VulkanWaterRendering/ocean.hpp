@@ -2,12 +2,23 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <stdexcept>
 
 //#include "application.hpp"
 #include "vertex.hpp"
 #include "logger.hpp"
 #include "gerstner_waves.hpp"
+#include "wave_spectrum.hpp"
+#include "surface_query.hpp"
 #include "helper.hpp"
+#include "profiler.hpp"
+#include "memory_tracker.hpp"
 
 class Ocean
 {
@@ -17,16 +28,61 @@ class Ocean
 	std::vector<Gerstner> m_waves;
 	std::vector<Vertex> m_vertices = {}; //vertices of the plane
 	std::vector<uint32_t> m_indices = {}; //indeces for draw order
+	//the long waves are evaluated on every m_coarse_factor-th vertex and interpolated in between
+	uint32_t m_coarse_factor = 1;
+	//one loop of displacements, update_waves interpolates between these frames instead of summing waves while it is filled
+	std::vector<Displacement> m_frame_cache;
+	uint32_t m_cached_frames = 0;
+	float m_cache_period = 0.0f;
 
 	void initializeVertices(uint32_t resolution);
-	void initializeWave(uint32_t resolution);
+	void initializeWave(uint32_t resolution, uint32_t wave_count, const SpectrumParameters &spectrum);
 
 public:
 	uint32_t resolution;
+	static const uint32_t DEFAULT_SPECTRUM_WAVE_COUNT = 64;
+	//a wave goes on the coarse grid if it keeps this many coarse vertices per wavelength, the bilinear interpolation
+	//is then off by at most (pi / 8)^2 / 2, about 8% of its amplitude, but those are short and flat and long waves are off far less
+	static const uint32_t COARSE_SAMPLES_PER_WAVELENGTH = 8;
 
-	Ocean(uint32_t resolution = 1024, float tilesize = 256);
+	//a wave count of 0 uses the predefined waves, more than those adds shorter variations of them
+	//with a spectrum all waves are sampled from it instead, 0 then means DEFAULT_SPECTRUM_WAVE_COUNT
+	Ocean(uint32_t resolution = 1024, float tilesize = 256, uint32_t wave_count = 0, const SpectrumParameters &spectrum = {});
 	std::vector<Vertex> getVertices();
 	std::vector<uint32_t> getIndices();
 	//std::vector<glm::vec3> getHeightmap();
-	std::vector<Displacement> update_waves(float time);
+	//Sums the waves the lod leaves for every vertex, by default all of them. The phase along a row grows by the same step
+	//from vertex to vertex, so each wave needs one sin and cos per segment of a row and walks along it by rotating,
+	//which is what keeps hundreds of waves affordable. Segments far from the camera stop at the first wave that is too short.
+	//Budget, measured on one core without lod: about 4-5ns per wave and vertex, 64 waves on a 256^2 grid take ~20ms, 256 waves ~80ms.
+	//That keeps the cpu fallback usable up to about 64 waves, anything that has to hold 60 fps with 256+ waves
+	//should simulate on the gpu (compute or vertex), which runs the same sum for every vertex in parallel.
+	std::vector<Displacement> update_waves(float time, const WaveLod &lod = {});
+	//the same for the vertices in [first_x, first_x + width) x [first_y, first_y + height) only, added to displacements,
+	//which is laid out like the whole grid
+	void update_waves(float time, const WaveLod &lod, uint32_t first_x, uint32_t first_y, uint32_t width, uint32_t height, Displacement *displacements);
+	//1, 2, 4 or 8, the long waves in update_waves are evaluated on a grid that much coarser and interpolated,
+	//only the short ones are evaluated at every vertex
+	void set_coarse_factor(uint32_t factor);
+	//prints the error and speedup of the coarse grid against evaluating every wave at every vertex
+	void report_coarse_grid(const WaveLod &lod = {});
+	//the shortest time after which every wave is back where it started, 0 if there is none up to max_period seconds
+	float find_loop_period(float max_period = 600.0f);
+	//rounds the speed of every wave so all of them repeat after period seconds, also for the gpu, returns the largest
+	//relative change of a speed, long periods change them less
+	float force_loop_period(float period);
+	//rounds every wave to the nearest one that repeats every tile cells along x and y, so a texture of one tile wraps
+	//without a seam, returns the largest relative change of a wavelength, long waves change the most
+	float snap_waves_to_tile(float tile);
+	//fills one loop of period seconds with frames at the given rate, fewer if they would take more than memory_cap bytes,
+	//from then on update_waves interpolates between them and ignores the lod, an empty cache is simply not used
+	void fill_frame_cache(float period, float frame_rate, size_t memory_cap);
+	//the parameters of all waves, for evaluating them on the gpu
+	std::vector<GerstnerParameters> get_wave_parameters();
+	//the height, normal and velocity of the water above each world position, all waves count, the lod is only for rendering
+	std::vector<WaterSample> query_surface(const std::vector<glm::vec2> &positions, float time);
+	//a query with a copy of the current waves, for asking from other threads
+	SurfaceQuery create_surface_query();
+	//publishes the sizes of vertices and indices to the memory tracker
+	void track_host_copies();
 };
\ No newline at end of file
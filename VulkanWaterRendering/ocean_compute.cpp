@@ -0,0 +1,436 @@
+#include "ocean_compute.hpp"
+
+//handed to shader.comp as its local size
+static const uint32_t WORKGROUP_SIZE = 64;
+
+//sets up everything needed to simulate on the compute queue
+//the shader module is only needed for pipeline creation and can be destroyed afterwards
+void OceanCompute::initialize(VkPhysicalDevice physical_device, VkDevice logical_device, MemoryAllocator *allocator, uint32_t compute_family, VkQueue compute_queue, uint32_t graphics_family, VkShaderModule shader_module, uint32_t resolution, uint32_t vertex_count, const std::vector<GerstnerParameters> &waves)
+{
+	info("Initializing ocean compute...");
+	m_logical_device = logical_device;
+	m_allocator = allocator;
+	m_compute_family = compute_family;
+	m_compute_queue = compute_queue;
+	m_graphics_family = graphics_family;
+
+	m_vertex_count = vertex_count;
+	m_specialization.workgroup_size = WORKGROUP_SIZE;
+	m_specialization.wave_count = static_cast<uint32_t>(waves.size());
+	m_specialization.resolution = resolution;
+
+	if (needs_ownership_transfer())
+	{
+		info("\tSimulating on a dedicated compute queue");
+	}
+
+	create_buffers(waves);
+	create_descriptors();
+	create_pipeline(shader_module);
+	create_command_buffers();
+	m_timer.initialize(physical_device, m_logical_device, m_compute_family, "GPU compute queue", static_cast<uint32_t>(m_slots.size()));
+	succ("Ocean compute initialized");
+}
+
+//waits for outstanding simulations and destroys everything, fine to call if initialize never ran or threw
+void OceanCompute::destroy()
+{
+	if (m_logical_device == VK_NULL_HANDLE)
+		return;
+
+	m_timer.destroy();
+	for (Slot &slot : m_slots)
+	{
+		if (slot.fence != VK_NULL_HANDLE)
+		{
+			vkWaitForFences(m_logical_device, 1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+		vkDestroyFence(m_logical_device, slot.fence, nullptr);
+		vkDestroySemaphore(m_logical_device, slot.simulated_semaphore, nullptr);
+		vkDestroySemaphore(m_logical_device, slot.released_semaphore, nullptr);
+		vkDestroyBuffer(m_logical_device, slot.buffer, nullptr);
+		m_allocator->free(slot.allocation);
+	}
+	vkDestroyBuffer(m_logical_device, m_wave_buffer, nullptr);
+	m_allocator->free(m_wave_allocation);
+
+	vkDestroyPipeline(m_logical_device, m_pipeline, nullptr);
+	vkDestroyPipelineLayout(m_logical_device, m_pipeline_layout, nullptr);
+	vkDestroyDescriptorPool(m_logical_device, m_descriptor_pool, nullptr);
+	vkDestroyDescriptorSetLayout(m_logical_device, m_descriptor_set_layout, nullptr);
+	vkDestroyCommandPool(m_logical_device, m_command_pool, nullptr);
+}
+
+//both slots may still be simulating with the old pipeline, so it goes once they are done
+void OceanCompute::replace_pipeline(VkPipeline pipeline)
+{
+	std::array<VkFence, 2> fences = { m_slots[0].fence, m_slots[1].fence };
+	vkWaitForFences(m_logical_device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+	vkDestroyPipeline(m_logical_device, m_pipeline, nullptr);
+	m_pipeline = pipeline;
+}
+
+//records and submits the simulation into the slot the graphics queue is not using
+void OceanCompute::dispatch(float time, const WaveLod &lod)
+{
+	PROFILE_FUNCTION();
+	//the last result was not drawn yet, there is no free slot to write to
+	if (m_ready_slot >= 0)
+		return;
+
+	int slot_index = m_graphics_slot == 0 ? 1 : 0;
+	Slot &slot = m_slots[slot_index];
+
+	//the previous simulation into this slot has to be done before its command buffer is reused
+	vkWaitForFences(m_logical_device, 1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	vkResetFences(m_logical_device, 1, &slot.fence);
+	vkResetCommandBuffer(slot.command_buffer, 0);
+
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(slot.command_buffer, &command_buffer_begin_info);
+	m_timer.begin(slot.command_buffer, slot_index);
+	uint32_t simulation_zone = m_timer.begin_zone(slot.command_buffer, "simulation");
+
+	//take the buffer back from the graphics queue, the matching release was recorded there
+	if (slot.released && needs_ownership_transfer())
+	{
+		VkBufferMemoryBarrier acquire = ownership_barrier(slot.buffer, m_graphics_family, m_compute_family, 0, VK_ACCESS_SHADER_WRITE_BIT);
+		vkCmdPipelineBarrier(slot.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &acquire, 0, nullptr);
+	}
+
+	m_constants.time = time;
+	m_constants.lod = lod;
+	vkCmdBindPipeline(slot.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+	vkCmdBindDescriptorSets(slot.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &slot.descriptor_set, 0, nullptr);
+	vkCmdPushConstants(slot.command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationConstants), &m_constants);
+	vkCmdDispatch(slot.command_buffer, (m_vertex_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	m_timer.end_zone(slot.command_buffer, simulation_zone);
+
+	//hand the buffer over to the graphics queue, which acquires it before drawing
+	if (needs_ownership_transfer())
+	{
+		VkBufferMemoryBarrier release = ownership_barrier(slot.buffer, m_compute_family, m_graphics_family, VK_ACCESS_SHADER_WRITE_BIT, 0);
+		vkCmdPipelineBarrier(slot.command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &release, 0, nullptr);
+	}
+
+	if (vkEndCommandBuffer(slot.command_buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Compute command buffer recording failed");
+	}
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	//the graphics queue might still read from the buffer, it signals once it moved on to the other one
+	VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	if (slot.released)
+	{
+		submit_info.waitSemaphoreCount = 1;
+		submit_info.pWaitSemaphores = &slot.released_semaphore;
+		submit_info.pWaitDstStageMask = &wait_stage;
+	}
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &slot.command_buffer;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &slot.simulated_semaphore;
+
+	m_timer.mark_submitted();
+	if (vkQueueSubmit(m_compute_queue, 1, &submit_info, slot.fence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Compute submission failed");
+	}
+	slot.released = false;
+	m_ready_slot = slot_index;
+}
+
+//switches the graphics queue to the newest simulated buffer, if there is one
+//without a new one the current buffer is simply drawn again, it is still owned by the graphics queue
+void OceanCompute::record_graphics_barriers(VkCommandBuffer command_buffer)
+{
+	m_graphics_wait_semaphore = VK_NULL_HANDLE;
+	m_graphics_signal_semaphore = VK_NULL_HANDLE;
+	if (m_ready_slot < 0)
+		return;
+
+	int previous_slot = m_graphics_slot;
+	m_graphics_slot = m_ready_slot;
+	m_ready_slot = -1;
+
+	Slot &slot = m_slots[m_graphics_slot];
+	m_graphics_wait_semaphore = slot.simulated_semaphore;
+	if (needs_ownership_transfer())
+	{
+		VkBufferMemoryBarrier acquire = ownership_barrier(slot.buffer, m_compute_family, m_graphics_family, 0, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &acquire, 0, nullptr);
+	}
+
+	//the old buffer is not drawn anymore, give it back to the compute queue
+	if (previous_slot >= 0)
+	{
+		Slot &previous = m_slots[previous_slot];
+		if (needs_ownership_transfer())
+		{
+			//only reads happened, nothing to make available
+			VkBufferMemoryBarrier release = ownership_barrier(previous.buffer, m_graphics_family, m_compute_family, 0, 0);
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &release, 0, nullptr);
+		}
+		m_graphics_signal_semaphore = previous.released_semaphore;
+		previous.released = true;
+	}
+}
+
+//the buffer the frame being recorded reads its displacement from
+VkBuffer OceanCompute::get_displacement_buffer()
+{
+	return m_slots[m_graphics_slot < 0 ? 0 : m_graphics_slot].buffer;
+}
+
+//the graphics submission waits on this at the vertex input stage
+VkSemaphore OceanCompute::get_graphics_wait_semaphore()
+{
+	return m_graphics_wait_semaphore;
+}
+
+//the graphics submission signals this once it does not read the old buffer anymore
+VkSemaphore OceanCompute::get_graphics_signal_semaphore()
+{
+	return m_graphics_signal_semaphore;
+}
+
+//creates the wave parameter buffer and both displacement buffers
+void OceanCompute::create_buffers(const std::vector<GerstnerParameters> &waves)
+{
+	//the waves do not change, host visible memory is fine for a handful of them
+	VkDeviceSize wave_buffer_size = sizeof(GerstnerParameters) * std::max<size_t>(waves.size(), 1);
+	m_wave_buffer = create_buffer(wave_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::simulation, m_wave_allocation);
+	memcpy(m_wave_allocation.mapped, waves.data(), sizeof(GerstnerParameters) * waves.size());
+
+	VkDeviceSize displacement_buffer_size = sizeof(Displacement) * m_vertex_count;
+	for (Slot &slot : m_slots)
+	{
+		slot.buffer = create_buffer(displacement_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::displacement, slot.allocation);
+	}
+}
+
+//one descriptor set per slot, both read the same waves
+void OceanCompute::create_descriptors()
+{
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+	descriptor_set_layout_create_info.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(m_logical_device, &descriptor_set_layout_create_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed creating compute descriptor set layout");
+	}
+
+	VkDescriptorPoolSize descriptor_pool_size = {};
+	descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_size.descriptorCount = static_cast<uint32_t>(bindings.size() * m_slots.size());
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
+	descriptor_pool_create_info.maxSets = static_cast<uint32_t>(m_slots.size());
+
+	if (vkCreateDescriptorPool(m_logical_device, &descriptor_pool_create_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Compute descriptor pool creation failed");
+	}
+
+	for (Slot &slot : m_slots)
+	{
+		VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+		descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocate_info.descriptorPool = m_descriptor_pool;
+		descriptor_set_allocate_info.descriptorSetCount = 1;
+		descriptor_set_allocate_info.pSetLayouts = &m_descriptor_set_layout;
+
+		if (vkAllocateDescriptorSets(m_logical_device, &descriptor_set_allocate_info, &slot.descriptor_set) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Compute descriptor set allocation failed");
+		}
+
+		VkDescriptorBufferInfo wave_buffer_info = {};
+		wave_buffer_info.buffer = m_wave_buffer;
+		wave_buffer_info.offset = 0;
+		wave_buffer_info.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo displacement_buffer_info = {};
+		displacement_buffer_info.buffer = slot.buffer;
+		displacement_buffer_info.offset = 0;
+		displacement_buffer_info.range = VK_WHOLE_SIZE;
+
+		std::array<VkWriteDescriptorSet, 2> write_descriptor_sets = {};
+		write_descriptor_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[0].dstSet = slot.descriptor_set;
+		write_descriptor_sets[0].dstBinding = 0;
+		write_descriptor_sets[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write_descriptor_sets[0].descriptorCount = 1;
+		write_descriptor_sets[0].pBufferInfo = &wave_buffer_info;
+		write_descriptor_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[1].dstSet = slot.descriptor_set;
+		write_descriptor_sets[1].dstBinding = 1;
+		write_descriptor_sets[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write_descriptor_sets[1].descriptorCount = 1;
+		write_descriptor_sets[1].pBufferInfo = &displacement_buffer_info;
+
+		vkUpdateDescriptorSets(m_logical_device, static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, nullptr);
+	}
+}
+
+//creates the pipeline layout with the simulation push constants and builds the compute pipeline
+void OceanCompute::create_pipeline(VkShaderModule shader_module)
+{
+	VkPushConstantRange push_constant_range = {};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = sizeof(SimulationConstants);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &m_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	if (vkCreatePipelineLayout(m_logical_device, &pipeline_layout_create_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Compute pipeline layout creation failed");
+	}
+	m_pipeline = build_pipeline(shader_module);
+}
+
+//the specialization constants stay the same for every shader the pipeline is built from
+VkPipeline OceanCompute::build_pipeline(VkShaderModule shader_module)
+{
+	//the constants are baked into the pipeline, the driver folds the loop bound and the grid math
+	std::array<VkSpecializationMapEntry, 3> specialization_map_entries = {};
+	specialization_map_entries[0] = { 0, offsetof(SimulationSpecialization, workgroup_size), sizeof(uint32_t) };
+	specialization_map_entries[1] = { 1, offsetof(SimulationSpecialization, wave_count), sizeof(uint32_t) };
+	specialization_map_entries[2] = { 2, offsetof(SimulationSpecialization, resolution), sizeof(uint32_t) };
+
+	VkSpecializationInfo specialization_info = {};
+	specialization_info.mapEntryCount = static_cast<uint32_t>(specialization_map_entries.size());
+	specialization_info.pMapEntries = specialization_map_entries.data();
+	specialization_info.dataSize = sizeof(SimulationSpecialization);
+	specialization_info.pData = &m_specialization;
+
+	VkComputePipelineCreateInfo compute_pipeline_create_info = {};
+	compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	compute_pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compute_pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compute_pipeline_create_info.stage.module = shader_module;
+	compute_pipeline_create_info.stage.pName = "main";
+	compute_pipeline_create_info.stage.pSpecializationInfo = &specialization_info;
+	compute_pipeline_create_info.layout = m_pipeline_layout;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (vkCreateComputePipelines(m_logical_device, VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Compute pipeline creation failed");
+	}
+	return pipeline;
+}
+
+//one command buffer, fence and pair of semaphores per slot
+void OceanCompute::create_command_buffers()
+{
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.queueFamilyIndex = m_compute_family;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	if (vkCreateCommandPool(m_logical_device, &command_pool_create_info, nullptr, &m_command_pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create compute command pool");
+	}
+
+	VkSemaphoreCreateInfo semaphore_create_info = {};
+	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkFenceCreateInfo fence_create_info = {};
+	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	//start signaled, nothing has been submitted yet
+	fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (Slot &slot : m_slots)
+	{
+		VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.commandPool = m_command_pool;
+		command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_allocate_info.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(m_logical_device, &command_buffer_allocate_info, &slot.command_buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Compute command buffer allocation failed");
+		}
+		if (vkCreateFence(m_logical_device, &fence_create_info, nullptr, &slot.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Compute fence creation failed");
+		}
+		if (vkCreateSemaphore(m_logical_device, &semaphore_create_info, nullptr, &slot.simulated_semaphore) != VK_SUCCESS || vkCreateSemaphore(m_logical_device, &semaphore_create_info, nullptr, &slot.released_semaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Compute semaphore creation failed");
+		}
+	}
+}
+
+//creates an exclusive buffer and binds memory from the allocator
+VkBuffer OceanCompute::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MemoryCategory category, Allocation &allocation)
+{
+	VkBufferCreateInfo buffer_create_info = {};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	if (vkCreateBuffer(m_logical_device, &buffer_create_info, nullptr, &buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Compute buffer creation failed");
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(m_logical_device, buffer, &memory_requirements);
+	allocation = m_allocator->allocate(memory_requirements, properties, true, category);
+	vkBindBufferMemory(m_logical_device, buffer, allocation.memory, allocation.offset);
+	return buffer;
+}
+
+//a barrier moving the whole buffer from one queue family to another
+//it has to be recorded on both queues with the same families, as release on the source and as acquire on the destination
+VkBufferMemoryBarrier OceanCompute::ownership_barrier(VkBuffer buffer, uint32_t src_family, uint32_t dst_family, VkAccessFlags src_access, VkAccessFlags dst_access)
+{
+	VkBufferMemoryBarrier buffer_memory_barrier = {};
+	buffer_memory_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_memory_barrier.srcAccessMask = src_access;
+	buffer_memory_barrier.dstAccessMask = dst_access;
+	buffer_memory_barrier.srcQueueFamilyIndex = src_family;
+	buffer_memory_barrier.dstQueueFamilyIndex = dst_family;
+	buffer_memory_barrier.buffer = buffer;
+	buffer_memory_barrier.offset = 0;
+	buffer_memory_barrier.size = VK_WHOLE_SIZE;
+	return buffer_memory_barrier;
+}
+
+//ownership only has to move if compute and graphics are different families
+//on the same family the semaphores alone order the accesses
+bool OceanCompute::needs_ownership_transfer()
+{
+	return m_compute_family != m_graphics_family;
+}
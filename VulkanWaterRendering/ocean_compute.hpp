@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include <limits>
+#include <cstring>
+#include <cstddef>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+#include "memory_allocator.hpp"
+#include "gerstner_waves.hpp"
+#include "profiler.hpp"
+
+//The push constants of shader.comp
+struct SimulationConstants
+{
+	float time;
+	//the vec3 of the lod starts at the next 16 bytes
+	float padding[3];
+	WaveLod lod;
+};
+
+//The specialization constants of shader.comp, they never change while the ocean exists
+struct SimulationSpecialization
+{
+	uint32_t workgroup_size;
+	uint32_t wave_count;
+	uint32_t resolution;
+};
+
+//Simulates the ocean displacement with a compute shader.
+//The work goes to a dedicated compute queue family if the device has one, so simulating the next frame
+//overlaps with rendering the current one. Two displacement buffers take turns: while the graphics queue
+//reads one, the compute queue writes the other.
+//The buffers are exclusive, if compute and graphics are different families the ownership is handed over
+//with release and acquire barriers, the semaphores order the two halves of each handover.
+class OceanCompute
+{
+public:
+	void initialize(VkPhysicalDevice physical_device, VkDevice logical_device, MemoryAllocator *allocator, uint32_t compute_family, VkQueue compute_queue, uint32_t graphics_family, VkShaderModule shader_module, uint32_t resolution, uint32_t vertex_count, const std::vector<GerstnerParameters> &waves);
+	void destroy();
+
+	//submits the simulation for the given time into the buffer the graphics queue is not reading from
+	void dispatch(float time, const WaveLod &lod);
+
+	//builds the simulation pipeline from another shader with the same specialization constants, safe to call from another thread
+	VkPipeline build_pipeline(VkShaderModule shader_module);
+	//takes over a pipeline from build_pipeline, waits for the simulations still using the old one
+	void replace_pipeline(VkPipeline pipeline);
+
+	//graphics side, call while recording a frame and outside of a render pass
+	//picks up the newest simulated buffer and records the ownership barriers that come with it
+	void record_graphics_barriers(VkCommandBuffer command_buffer);
+	//the buffer to bind as displacement vertex buffer in the frame being recorded
+	VkBuffer get_displacement_buffer();
+	//the semaphores the graphics submission of the recorded frame has to wait on and signal, VK_NULL_HANDLE if there is none
+	VkSemaphore get_graphics_wait_semaphore();
+	VkSemaphore get_graphics_signal_semaphore();
+
+private:
+	//everything belonging to one of the two displacement buffers
+	struct Slot
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		Allocation allocation;
+		VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+		VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+		//signaled when the command buffer can be recorded again
+		VkFence fence = VK_NULL_HANDLE;
+		//compute is done writing, waited on by graphics
+		VkSemaphore simulated_semaphore = VK_NULL_HANDLE;
+		//graphics is done reading, waited on by compute
+		VkSemaphore released_semaphore = VK_NULL_HANDLE;
+		//graphics signaled released_semaphore and the next simulation has to wait on it
+		bool released = false;
+	};
+
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	MemoryAllocator *m_allocator = nullptr;
+	VkQueue m_compute_queue = VK_NULL_HANDLE;
+	uint32_t m_compute_family = 0;
+	uint32_t m_graphics_family = 0;
+
+	VkCommandPool m_command_pool = VK_NULL_HANDLE;
+	VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+	VkDescriptorPool m_descriptor_pool = VK_NULL_HANDLE;
+	VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+	VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+	VkBuffer m_wave_buffer = VK_NULL_HANDLE;
+	Allocation m_wave_allocation;
+
+	std::array<Slot, 2> m_slots;
+	//the slot the graphics queue currently draws from, -1 before the first frame
+	int m_graphics_slot = -1;
+	//a slot that has been simulated but not picked up by the graphics queue yet, -1 if there is none
+	int m_ready_slot = -1;
+
+	VkSemaphore m_graphics_wait_semaphore = VK_NULL_HANDLE;
+	VkSemaphore m_graphics_signal_semaphore = VK_NULL_HANDLE;
+
+	SimulationConstants m_constants = {};
+	SimulationSpecialization m_specialization = {};
+	uint32_t m_vertex_count = 0;
+	//one query set per slot, a set is read once the fence of its slot was waited on
+	GpuTimer m_timer;
+
+	void create_buffers(const std::vector<GerstnerParameters> &waves);
+	void create_descriptors();
+	void create_pipeline(VkShaderModule shader_module);
+	void create_command_buffers();
+	VkBuffer create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MemoryCategory category, Allocation &allocation);
+	VkBufferMemoryBarrier ownership_barrier(VkBuffer buffer, uint32_t src_family, uint32_t dst_family, VkAccessFlags src_access, VkAccessFlags dst_access);
+	bool needs_ownership_transfer();
+};
@@ -0,0 +1,405 @@
+#include "ocean_texture.hpp"
+
+//handed to shader.comp as its local size
+static const uint32_t WORKGROUP_SIZE = 64;
+
+//sets up the maps and the compute pipeline that fills them, everything runs on the given queue family
+void OceanTexture::initialize(VkPhysicalDevice physical_device, VkDevice logical_device, MemoryAllocator *allocator, uint32_t queue_family, VkShaderModule shader_module, uint32_t texture_resolution, float plane_size, float max_anisotropy, const std::vector<GerstnerParameters> &waves)
+{
+	info("Initializing ocean texture...");
+	m_logical_device = logical_device;
+	m_allocator = allocator;
+	m_resolution = texture_resolution;
+	m_mip_levels = get_mip_level_count(m_resolution, m_resolution);
+
+	uint32_t queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+	if (queue_family >= queue_family_count || !(queue_families[queue_family].queueFlags & VK_QUEUE_COMPUTE_BIT))
+	{
+		throw std::runtime_error("The graphics queue can not run compute shaders, the texture simulation needs it to");
+	}
+	check_format_support(physical_device);
+
+	m_specialization.workgroup_size = WORKGROUP_SIZE;
+	m_specialization.wave_count = static_cast<uint32_t>(waves.size());
+	m_specialization.resolution = m_resolution;
+	m_specialization.texel_size = plane_size / m_resolution;
+
+	create_maps(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, queue_family, queue_family);
+	create_sampler(max_anisotropy);
+	create_wave_buffer(waves);
+	create_descriptors();
+	create_pipeline(shader_module);
+	succ("Ocean texture initialized, ", m_resolution, "x", m_resolution, " texels with ", m_mip_levels, " mip levels");
+}
+
+//the maps are uploaded once and never simulated, the graphics pipeline only needs valid descriptors
+void OceanTexture::initialize_placeholder(VkDevice logical_device, MemoryAllocator *allocator, UploadBatcher *upload_batcher, uint32_t graphics_family, uint32_t transfer_family)
+{
+	m_logical_device = logical_device;
+	m_allocator = allocator;
+	m_resolution = 1;
+	m_mip_levels = 1;
+
+	create_maps(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, graphics_family, transfer_family);
+	create_sampler(1.0f);
+
+	//four half floats of 0, a flat surface pointing nowhere
+	const uint16_t texel[4] = {};
+	for (Map &map : m_maps)
+	{
+		upload_batcher->upload_image(texel, sizeof(texel), map.image, 1, 1);
+	}
+}
+
+//the caller makes sure no frame using the maps is still in flight, fine to call if nothing was initialized
+void OceanTexture::destroy()
+{
+	if (m_logical_device == VK_NULL_HANDLE)
+		return;
+
+	for (Map &map : m_maps)
+	{
+		vkDestroyImageView(m_logical_device, map.storage_view, nullptr);
+		vkDestroyImageView(m_logical_device, map.view, nullptr);
+		vkDestroyImage(m_logical_device, map.image, nullptr);
+		m_allocator->free(map.allocation);
+	}
+	vkDestroySampler(m_logical_device, m_sampler, nullptr);
+	//the placeholder has no simulation, the null handles of its pipeline are simply ignored
+	if (m_wave_buffer != VK_NULL_HANDLE)
+	{
+		vkDestroyBuffer(m_logical_device, m_wave_buffer, nullptr);
+		m_allocator->free(m_wave_allocation);
+	}
+	vkDestroyPipeline(m_logical_device, m_pipeline, nullptr);
+	vkDestroyPipelineLayout(m_logical_device, m_pipeline_layout, nullptr);
+	vkDestroyDescriptorPool(m_logical_device, m_descriptor_pool, nullptr);
+	vkDestroyDescriptorSetLayout(m_logical_device, m_descriptor_set_layout, nullptr);
+}
+
+//the simulation is recorded into the frame, once the last frame is done nothing uses the old pipeline
+void OceanTexture::replace_pipeline(VkPipeline pipeline)
+{
+	vkDestroyPipeline(m_logical_device, m_pipeline, nullptr);
+	m_pipeline = pipeline;
+}
+
+//the last frame has been waited on before its command buffer is recorded again, so the old contents can be dropped
+void OceanTexture::record(VkCommandBuffer command_buffer, float time)
+{
+	PROFILE_FUNCTION();
+	//mip 0 gets written by the compute shader, the rest by blits, what the last frame sampled is not needed anymore
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (const Map &map : m_maps)
+	{
+		barriers.push_back(mip_barrier(map.image, 0, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT));
+		if (m_mip_levels > 1)
+			barriers.push_back(mip_barrier(map.image, 1, m_mip_levels - 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+	}
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	m_constants.time = time;
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_descriptor_set, 0, nullptr);
+	vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationConstants), &m_constants);
+	uint32_t texel_count = m_resolution * m_resolution;
+	vkCmdDispatch(command_buffer, (texel_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	barriers.clear();
+	for (const Map &map : m_maps)
+	{
+		barriers.push_back(mip_barrier(map.image, 0, 1, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+	}
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	record_mip_chain(command_buffer, { m_maps[0].image, m_maps[1].image }, m_resolution, m_resolution, m_mip_levels);
+
+	barriers.clear();
+	for (const Map &map : m_maps)
+	{
+		barriers.push_back(mip_barrier(map.image, 0, m_mip_levels, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+	}
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+//sampled with every mip level in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+VkDescriptorImageInfo OceanTexture::get_displacement_info()
+{
+	VkDescriptorImageInfo image_info = {};
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	image_info.imageView = m_maps[0].view;
+	image_info.sampler = m_sampler;
+	return image_info;
+}
+
+VkDescriptorImageInfo OceanTexture::get_normal_info()
+{
+	VkDescriptorImageInfo image_info = get_displacement_info();
+	image_info.imageView = m_maps[1].view;
+	return image_info;
+}
+
+//the compute shader writes the maps as storage images, the shaders filter them and blits build the mips
+void OceanTexture::check_format_support(VkPhysicalDevice physical_device)
+{
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(physical_device, FORMAT, &format_properties);
+	if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) || !supports_mip_blits(physical_device, FORMAT))
+	{
+		throw std::runtime_error("The device can not store, filter and blit half float images, the texture simulation needs all of it");
+	}
+}
+
+//both maps with the full mip chain, device local and only ever touched by one queue family,
+//unless a placeholder is filled by a transfer queue of another family
+void OceanTexture::create_maps(VkImageUsageFlags usage, uint32_t graphics_family, uint32_t transfer_family)
+{
+	uint32_t queue_family_indices[] = { graphics_family, transfer_family };
+	for (Map &map : m_maps)
+	{
+		VkImageCreateInfo image_create_info = {};
+		image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_create_info.imageType = VK_IMAGE_TYPE_2D;
+		image_create_info.extent = { m_resolution, m_resolution, 1 };
+		image_create_info.mipLevels = m_mip_levels;
+		image_create_info.arrayLayers = 1;
+		image_create_info.format = FORMAT;
+		image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		image_create_info.usage = usage;
+		image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		if (graphics_family != transfer_family)
+		{
+			image_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			image_create_info.queueFamilyIndexCount = 2;
+			image_create_info.pQueueFamilyIndices = queue_family_indices;
+		}
+
+		if (vkCreateImage(m_logical_device, &image_create_info, nullptr, &map.image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Ocean texture image creation failed");
+		}
+
+		VkMemoryRequirements memory_requirements;
+		vkGetImageMemoryRequirements(m_logical_device, map.image, &memory_requirements);
+		//optimal tiling images must not share a granularity page with buffers
+		map.allocation = m_allocator->allocate(memory_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, MemoryCategory::textures);
+		vkBindImageMemory(m_logical_device, map.image, map.allocation.memory, map.allocation.offset);
+
+		map.view = create_view(map.image, m_mip_levels);
+		if (usage & VK_IMAGE_USAGE_STORAGE_BIT)
+		{
+			map.storage_view = create_view(map.image, 1);
+		}
+	}
+}
+
+//the maps cover the plane once, so they repeat, between mips it blends linearly
+//anisotropic filtering keeps the normals sharp along the view direction where the water is seen at a grazing angle
+void OceanTexture::create_sampler(float max_anisotropy)
+{
+	VkSamplerCreateInfo sampler_create_info = {};
+	sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_create_info.magFilter = VK_FILTER_LINEAR;
+	sampler_create_info.minFilter = VK_FILTER_LINEAR;
+	sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	sampler_create_info.anisotropyEnable = max_anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+	sampler_create_info.maxAnisotropy = std::max(max_anisotropy, 1.0f);
+	sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+	sampler_create_info.unnormalizedCoordinates = VK_FALSE;
+	sampler_create_info.compareEnable = VK_FALSE;
+	sampler_create_info.compareOp = VK_COMPARE_OP_ALWAYS;
+	sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	sampler_create_info.minLod = 0.0f;
+	sampler_create_info.maxLod = static_cast<float>(m_mip_levels);
+
+	if (vkCreateSampler(m_logical_device, &sampler_create_info, nullptr, &m_sampler) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture sampler creation failed");
+	}
+}
+
+//the waves do not change, host visible memory is fine for a handful of them
+void OceanTexture::create_wave_buffer(const std::vector<GerstnerParameters> &waves)
+{
+	VkBufferCreateInfo buffer_create_info = {};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = sizeof(GerstnerParameters) * std::max<size_t>(waves.size(), 1);
+	buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(m_logical_device, &buffer_create_info, nullptr, &m_wave_buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture wave buffer creation failed");
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(m_logical_device, m_wave_buffer, &memory_requirements);
+	m_wave_allocation = m_allocator->allocate(memory_requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, true, MemoryCategory::simulation);
+	vkBindBufferMemory(m_logical_device, m_wave_buffer, m_wave_allocation.memory, m_wave_allocation.offset);
+	memcpy(m_wave_allocation.mapped, waves.data(), sizeof(GerstnerParameters) * waves.size());
+}
+
+//the waves at binding 0, mip 0 of the displacement and normal map at 1 and 2
+void OceanTexture::create_descriptors()
+{
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	for (uint32_t i = 1; i < bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+	descriptor_set_layout_create_info.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(m_logical_device, &descriptor_set_layout_create_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed creating ocean texture descriptor set layout");
+	}
+
+	std::array<VkDescriptorPoolSize, 2> descriptor_pool_sizes = {};
+	descriptor_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_sizes[0].descriptorCount = 1;
+	descriptor_pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	descriptor_pool_sizes[1].descriptorCount = static_cast<uint32_t>(m_maps.size());
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(descriptor_pool_sizes.size());
+	descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes.data();
+	descriptor_pool_create_info.maxSets = 1;
+
+	if (vkCreateDescriptorPool(m_logical_device, &descriptor_pool_create_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture descriptor pool creation failed");
+	}
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.descriptorPool = m_descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &m_descriptor_set_layout;
+
+	if (vkAllocateDescriptorSets(m_logical_device, &descriptor_set_allocate_info, &m_descriptor_set) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture descriptor set allocation failed");
+	}
+
+	VkDescriptorBufferInfo wave_buffer_info = {};
+	wave_buffer_info.buffer = m_wave_buffer;
+	wave_buffer_info.offset = 0;
+	wave_buffer_info.range = VK_WHOLE_SIZE;
+
+	std::array<VkDescriptorImageInfo, 2> map_infos = {};
+	std::array<VkWriteDescriptorSet, 3> write_descriptor_sets = {};
+	write_descriptor_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_sets[0].dstSet = m_descriptor_set;
+	write_descriptor_sets[0].dstBinding = 0;
+	write_descriptor_sets[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write_descriptor_sets[0].descriptorCount = 1;
+	write_descriptor_sets[0].pBufferInfo = &wave_buffer_info;
+	for (uint32_t i = 0; i < m_maps.size(); i++)
+	{
+		//storage images are written in the general layout
+		map_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		map_infos[i].imageView = m_maps[i].storage_view;
+		write_descriptor_sets[i + 1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[i + 1].dstSet = m_descriptor_set;
+		write_descriptor_sets[i + 1].dstBinding = i + 1;
+		write_descriptor_sets[i + 1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		write_descriptor_sets[i + 1].descriptorCount = 1;
+		write_descriptor_sets[i + 1].pImageInfo = &map_infos[i];
+	}
+
+	vkUpdateDescriptorSets(m_logical_device, static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, nullptr);
+}
+
+//the same push constants as the buffer simulation, plus the texel size as specialization constant
+void OceanTexture::create_pipeline(VkShaderModule shader_module)
+{
+	VkPushConstantRange push_constant_range = {};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = sizeof(SimulationConstants);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &m_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	if (vkCreatePipelineLayout(m_logical_device, &pipeline_layout_create_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture pipeline layout creation failed");
+	}
+	m_pipeline = build_pipeline(shader_module);
+}
+
+//the specialization constants stay the same for every shader the pipeline is built from
+VkPipeline OceanTexture::build_pipeline(VkShaderModule shader_module)
+{
+	std::array<VkSpecializationMapEntry, 4> specialization_map_entries = {};
+	specialization_map_entries[0] = { 0, offsetof(TextureSpecialization, workgroup_size), sizeof(uint32_t) };
+	specialization_map_entries[1] = { 1, offsetof(TextureSpecialization, wave_count), sizeof(uint32_t) };
+	specialization_map_entries[2] = { 2, offsetof(TextureSpecialization, resolution), sizeof(uint32_t) };
+	specialization_map_entries[3] = { 3, offsetof(TextureSpecialization, texel_size), sizeof(float) };
+
+	VkSpecializationInfo specialization_info = {};
+	specialization_info.mapEntryCount = static_cast<uint32_t>(specialization_map_entries.size());
+	specialization_info.pMapEntries = specialization_map_entries.data();
+	specialization_info.dataSize = sizeof(TextureSpecialization);
+	specialization_info.pData = &m_specialization;
+
+	VkComputePipelineCreateInfo compute_pipeline_create_info = {};
+	compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	compute_pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	compute_pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	compute_pipeline_create_info.stage.module = shader_module;
+	compute_pipeline_create_info.stage.pName = "main";
+	compute_pipeline_create_info.stage.pSpecializationInfo = &specialization_info;
+	compute_pipeline_create_info.layout = m_pipeline_layout;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (vkCreateComputePipelines(m_logical_device, VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture pipeline creation failed");
+	}
+	return pipeline;
+}
+
+VkImageView OceanTexture::create_view(VkImage image, uint32_t mip_levels)
+{
+	VkImageViewCreateInfo image_view_create_info = {};
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.image = image;
+	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	image_view_create_info.format = FORMAT;
+	image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_view_create_info.subresourceRange.baseMipLevel = 0;
+	image_view_create_info.subresourceRange.levelCount = mip_levels;
+	image_view_create_info.subresourceRange.baseArrayLayer = 0;
+	image_view_create_info.subresourceRange.layerCount = 1;
+
+	VkImageView image_view;
+	if (vkCreateImageView(m_logical_device, &image_view_create_info, nullptr, &image_view) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Ocean texture image view creation failed");
+	}
+	return image_view;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+#include "memory_allocator.hpp"
+#include "upload_batcher.hpp"
+#include "mip_chain.hpp"
+#include "ocean_compute.hpp"
+#include "gerstner_waves.hpp"
+#include "profiler.hpp"
+
+//The specialization constants of shader.comp built with TEXTURE_OUTPUT
+struct TextureSpecialization
+{
+	uint32_t workgroup_size;
+	uint32_t wave_count;
+	//texels across the maps
+	uint32_t resolution;
+	//grid cells one texel covers
+	float texel_size;
+};
+
+//Simulates the ocean into a displacement and a normal map instead of a buffer with one displacement per vertex.
+//The vertex shader samples the displacement and the fragment shader the normals, so the mesh can be finer or coarser
+//than the simulation. The maps cover the plane once and wrap, the waves have to be snapped to it for that.
+//Everything is recorded into the frame command buffer in front of the render pass, on the graphics queue:
+//the compute shader writes mip 0 of both maps, blits fill the rest of the mip chain.
+//Both maps are half floats, the one format with storage, linear filtering and blits every device supports.
+class OceanTexture
+{
+public:
+	static const VkFormat FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	//the shader module is only needed for pipeline creation and can be destroyed afterwards
+	//queue_family is the one the frames are recorded for, plane_size the number of grid cells the maps cover,
+	//max_anisotropy is handed to the sampler, 1 or less samples without anisotropic filtering
+	void initialize(VkPhysicalDevice physical_device, VkDevice logical_device, MemoryAllocator *allocator, uint32_t queue_family, VkShaderModule shader_module, uint32_t texture_resolution, float plane_size, float max_anisotropy, const std::vector<GerstnerParameters> &waves);
+	//a flat 1x1 map of each and no simulation, for pipelines that declare the maps without reading them
+	void initialize_placeholder(VkDevice logical_device, MemoryAllocator *allocator, UploadBatcher *upload_batcher, uint32_t graphics_family, uint32_t transfer_family);
+	void destroy();
+
+	//simulates the given time into the maps and leaves them ready to be sampled by the vertex and fragment shader
+	//call while recording a frame and outside of a render pass
+	void record(VkCommandBuffer command_buffer, float time);
+
+	//builds the simulation pipeline from another shader with the same specialization constants, safe to call from another thread
+	VkPipeline build_pipeline(VkShaderModule shader_module);
+	//takes over a pipeline from build_pipeline, call once the last frame recorded with the old one is done
+	void replace_pipeline(VkPipeline pipeline);
+
+	VkDescriptorImageInfo get_displacement_info();
+	VkDescriptorImageInfo get_normal_info();
+
+private:
+	//one of the two maps
+	struct Map
+	{
+		VkImage image = VK_NULL_HANDLE;
+		Allocation allocation;
+		//every mip level, for sampling
+		VkImageView view = VK_NULL_HANDLE;
+		//mip level 0 only, for the compute shader to write
+		VkImageView storage_view = VK_NULL_HANDLE;
+	};
+
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	MemoryAllocator *m_allocator = nullptr;
+
+	VkDescriptorSetLayout m_descriptor_set_layout = VK_NULL_HANDLE;
+	VkDescriptorPool m_descriptor_pool = VK_NULL_HANDLE;
+	VkDescriptorSet m_descriptor_set = VK_NULL_HANDLE;
+	VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+	VkPipeline m_pipeline = VK_NULL_HANDLE;
+	VkSampler m_sampler = VK_NULL_HANDLE;
+
+	VkBuffer m_wave_buffer = VK_NULL_HANDLE;
+	Allocation m_wave_allocation;
+
+	//the displacement map, then the normal map
+	std::array<Map, 2> m_maps;
+	uint32_t m_resolution = 1;
+	uint32_t m_mip_levels = 1;
+
+	//the lod is left at 0, the maps are sampled everywhere and distant water reads the smaller mips instead
+	SimulationConstants m_constants = {};
+	TextureSpecialization m_specialization = {};
+
+	void check_format_support(VkPhysicalDevice physical_device);
+	//the maps are shared between the families if they differ
+	void create_maps(VkImageUsageFlags usage, uint32_t graphics_family, uint32_t transfer_family);
+	void create_sampler(float max_anisotropy);
+	void create_wave_buffer(const std::vector<GerstnerParameters> &waves);
+	void create_descriptors();
+	void create_pipeline(VkShaderModule shader_module);
+	VkImageView create_view(VkImage image, uint32_t mip_levels);
+};
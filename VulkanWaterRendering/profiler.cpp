@@ -0,0 +1,351 @@
+#include "profiler.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Tracks
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ProfileTrack::ProfileTrack(const std::string &name, uint32_t id, size_t capacity) : m_name(name), m_id(id), m_events(capacity), m_count(0)
+{
+}
+
+//overwrites the oldest event once the buffer is full
+void ProfileTrack::push(const char *name, int64_t start, int64_t end)
+{
+	uint64_t count = m_count.load(std::memory_order_relaxed);
+	m_events[count % m_events.size()] = { name, start, end };
+	m_count.store(count + 1, std::memory_order_release);
+}
+
+//copies the held events in the order they were pushed
+std::vector<ProfileEvent> ProfileTrack::get_events()
+{
+	uint64_t count = m_count.load(std::memory_order_acquire);
+	uint64_t held = std::min<uint64_t>(count, m_events.size());
+
+	std::vector<ProfileEvent> events;
+	events.reserve(static_cast<size_t>(held));
+	for (uint64_t i = count - held; i < count; i++)
+	{
+		events.push_back(m_events[i % m_events.size()]);
+	}
+	return events;
+}
+
+void ProfileTrack::clear()
+{
+	m_count.store(0, std::memory_order_release);
+}
+
+const std::string &ProfileTrack::get_name()
+{
+	return m_name;
+}
+
+uint32_t ProfileTrack::get_id()
+{
+	return m_id;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Profiler
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//events each track can hold before the oldest get overwritten
+static const size_t TRACK_CAPACITY = 1 << 16;
+
+std::atomic<bool> Profiler::s_enabled(false);
+
+Profiler::Profiler() : m_epoch(std::chrono::steady_clock::now())
+{
+}
+
+//the one profiler everything records into
+Profiler &Profiler::get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+bool Profiler::is_enabled()
+{
+#ifdef ENABLE_PROFILING
+	return s_enabled.load(std::memory_order_relaxed);
+#else
+	return false;
+#endif
+}
+
+void Profiler::set_enabled(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const auto &track : m_tracks)
+	{
+		track->clear();
+	}
+	m_epoch = std::chrono::steady_clock::now();
+}
+
+int64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+//every thread registers its track once and keeps a pointer to it
+ProfileTrack *Profiler::get_thread_track()
+{
+	thread_local ProfileTrack *track = nullptr;
+	if (track == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::string name = m_thread_count == 0 ? "Main thread" : std::string("Thread ") + std::to_string(m_thread_count);
+		m_thread_count++;
+		m_tracks.push_back(std::make_unique<ProfileTrack>(name, static_cast<uint32_t>(m_tracks.size()), TRACK_CAPACITY));
+		track = m_tracks.back().get();
+	}
+	return track;
+}
+
+//creates a track owned by the profiler, or hands out the one created for the last run
+ProfileTrack *Profiler::create_track(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto existing = std::find_if(m_tracks.begin(), m_tracks.end(), [&name](const std::unique_ptr<ProfileTrack> &track) { return track->get_name() == name; });
+	if (existing != m_tracks.end())
+		return existing->get();
+
+	m_tracks.push_back(std::make_unique<ProfileTrack>(name, static_cast<uint32_t>(m_tracks.size()), TRACK_CAPACITY));
+	return m_tracks.back().get();
+}
+
+//escapes the few characters json does not like in a string
+static std::string escape_json(const char *text)
+{
+	std::string escaped;
+	for (const char *c = text; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			escaped += '\\';
+		escaped += *c;
+	}
+	return escaped;
+}
+
+//writes all tracks as complete events, one row per track
+void Profiler::write_chrome_trace(const std::string &path)
+{
+	info("Writing trace to ", path, "...");
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open trace file");
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	file << "{\"traceEvents\":[";
+	bool first = true;
+	for (const auto &track : m_tracks)
+	{
+		//threads of earlier runs keep their empty tracks
+		std::vector<ProfileEvent> events = track->get_events();
+		if (events.empty())
+			continue;
+
+		//name the row
+		file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->get_id() << ",\"args\":{\"name\":\"" << escape_json(track->get_name().c_str()) << "\"}}";
+		first = false;
+
+		for (const ProfileEvent &event : events)
+		{
+			//chrome wants microseconds
+			file << ",\n{\"name\":\"" << escape_json(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << track->get_id()
+				<< ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+		}
+	}
+	file << "\n]}\n";
+	succ("Trace written");
+}
+
+//starts timing if the profiler is enabled
+ProfileZone::ProfileZone(const char *name)
+{
+	if (!Profiler::is_enabled())
+		return;
+
+	m_name = name;
+	m_start = Profiler::get().now();
+}
+
+//records the zone on the current thread
+ProfileZone::~ProfileZone()
+{
+	if (m_name == nullptr)
+		return;
+
+	Profiler &profiler = Profiler::get();
+	profiler.get_thread_track()->push(m_name, m_start, profiler.now());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+////
+////							Gpu Timer
+////
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//creates a query pool with two timestamps per zone
+//if the queue family can not write timestamps the timer stays silent
+void GpuTimer::initialize(VkPhysicalDevice physical_device, VkDevice logical_device, uint32_t queue_family, const std::string &track_name, uint32_t set_count, uint32_t zones_per_set)
+{
+	m_logical_device = logical_device;
+	m_zones_per_set = zones_per_set;
+	m_sets.resize(set_count);
+	m_last_milliseconds.assign(zones_per_set, -1.0);
+
+	VkPhysicalDeviceProperties physical_device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+	m_timestamp_period = physical_device_properties.limits.timestampPeriod;
+
+	uint32_t queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+
+	uint32_t valid_bits = queue_families[queue_family].timestampValidBits;
+	if (valid_bits == 0)
+	{
+		warn("Queue family ", queue_family, " does not support timestamps, ", track_name, " will not be profiled");
+		return;
+	}
+	m_timestamp_mask = valid_bits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << valid_bits) - 1;
+
+	VkQueryPoolCreateInfo query_pool_create_info = {};
+	query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_create_info.queryCount = set_count * zones_per_set * 2;
+
+	if (vkCreateQueryPool(m_logical_device, &query_pool_create_info, nullptr, &m_query_pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Timestamp query pool creation failed");
+	}
+	if (Profiler::is_enabled())
+	{
+		m_track = Profiler::get().create_track(track_name);
+	}
+}
+
+void GpuTimer::destroy()
+{
+	if (m_logical_device == VK_NULL_HANDLE)
+		return;
+	vkDestroyQueryPool(m_logical_device, m_query_pool, nullptr);
+}
+
+//collects what the set measured last time and resets its queries
+void GpuTimer::begin(VkCommandBuffer command_buffer, uint32_t set)
+{
+	m_current_set = set;
+	QuerySet &query_set = m_sets[set];
+	if (query_set.pending)
+	{
+		collect(set);
+	}
+	query_set.names.clear();
+	query_set.active = m_query_pool != VK_NULL_HANDLE && (m_always_measure || m_track != nullptr);
+	if (!query_set.active)
+		return;
+
+	vkCmdResetQueryPool(command_buffer, m_query_pool, set * m_zones_per_set * 2, m_zones_per_set * 2);
+}
+
+//writes the starting timestamp of a zone, returns UINT32_MAX if nothing is measured
+uint32_t GpuTimer::begin_zone(VkCommandBuffer command_buffer, const char *name, VkPipelineStageFlagBits stage)
+{
+	QuerySet &query_set = m_sets[m_current_set];
+	if (!query_set.active || query_set.names.size() >= m_zones_per_set)
+		return UINT32_MAX;
+
+	uint32_t zone = static_cast<uint32_t>(query_set.names.size());
+	query_set.names.push_back(name);
+	vkCmdWriteTimestamp(command_buffer, stage, m_query_pool, (m_current_set * m_zones_per_set + zone) * 2);
+	return zone;
+}
+
+//writes the ending timestamp of a zone
+void GpuTimer::end_zone(VkCommandBuffer command_buffer, uint32_t zone, VkPipelineStageFlagBits stage)
+{
+	if (zone == UINT32_MAX)
+		return;
+
+	vkCmdWriteTimestamp(command_buffer, stage, m_query_pool, (m_current_set * m_zones_per_set + zone) * 2 + 1);
+}
+
+//remembers when the set went to the gpu, to place its timestamps on the cpu timeline
+void GpuTimer::mark_submitted()
+{
+	QuerySet &query_set = m_sets[m_current_set];
+	if (!query_set.active || query_set.names.empty())
+		return;
+
+	query_set.submit_time = Profiler::get().now();
+	query_set.pending = true;
+}
+
+//collects all sets that were submitted but not read yet
+void GpuTimer::read_back()
+{
+	for (uint32_t set = 0; set < m_sets.size(); set++)
+	{
+		if (m_sets[set].pending)
+		{
+			collect(set);
+		}
+	}
+}
+
+void GpuTimer::set_always_measure(bool always_measure)
+{
+	m_always_measure = always_measure;
+}
+
+double GpuTimer::get_last_milliseconds(uint32_t zone)
+{
+	if (zone >= m_last_milliseconds.size())
+		return -1.0;
+
+	return m_last_milliseconds[zone];
+}
+
+//reads the timestamps of a finished set and pushes them to the track
+void GpuTimer::collect(uint32_t set)
+{
+	QuerySet &query_set = m_sets[set];
+	query_set.pending = false;
+
+	std::vector<uint64_t> timestamps(query_set.names.size() * 2);
+	VkResult result = vkGetQueryPoolResults(m_logical_device, m_query_pool, set * m_zones_per_set * 2, static_cast<uint32_t>(timestamps.size()), timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	//not ready means the caller did not wait for the set, better drop it than stall
+	if (result != VK_SUCCESS)
+		return;
+
+	uint64_t first_timestamp = timestamps[0] & m_timestamp_mask;
+	for (size_t zone = 0; zone < query_set.names.size(); zone++)
+	{
+		uint64_t begin_timestamp = (timestamps[zone * 2] & m_timestamp_mask) - first_timestamp;
+		uint64_t end_timestamp = (timestamps[zone * 2 + 1] & m_timestamp_mask) - first_timestamp;
+		int64_t start = query_set.submit_time + static_cast<int64_t>(begin_timestamp * m_timestamp_period);
+		int64_t end = query_set.submit_time + static_cast<int64_t>(end_timestamp * m_timestamp_period);
+		if (m_track != nullptr)
+		{
+			m_track->push(query_set.names[zone], start, end);
+		}
+		m_last_milliseconds[zone] = (end - start) / 1000000.0;
+	}
+}
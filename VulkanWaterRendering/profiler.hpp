@@ -0,0 +1,157 @@
+#pragma once
+//comment this out to compile all profiling zones away
+#define ENABLE_PROFILING
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+
+//A timed section of cpu or gpu work, times are nanoseconds since the profiler was created
+struct ProfileEvent
+{
+	const char *name;
+	int64_t start;
+	int64_t end;
+};
+
+//A ring buffer of events that show up as one row in the trace.
+//Every track has exactly one writer, so pushing needs no lock, the oldest events get overwritten once it is full.
+class ProfileTrack
+{
+public:
+	ProfileTrack(const std::string &name, uint32_t id, size_t capacity);
+
+	void push(const char *name, int64_t start, int64_t end);
+	//the events currently held, oldest first
+	std::vector<ProfileEvent> get_events();
+	//drops every event, only call while nothing pushes
+	void clear();
+
+	const std::string &get_name();
+	uint32_t get_id();
+
+private:
+	std::string m_name;
+	uint32_t m_id;
+	std::vector<ProfileEvent> m_events;
+	std::atomic<uint64_t> m_count;
+};
+
+//Collects the tracks of all threads and gpu queues and writes them out as chrome trace json,
+//which can be opened in chrome://tracing or ui.perfetto.dev
+class Profiler
+{
+public:
+	static Profiler &get();
+
+	//zones check this before doing anything, so a disabled profiler costs a single load, it starts out disabled
+	static bool is_enabled();
+	void set_enabled(bool enabled);
+	//drops all recorded events and restarts the clock, so a trace only holds what came after
+	//only call this when no zone is being recorded, for example before a run
+	void reset();
+
+	//nanoseconds since the profiler was created
+	int64_t now();
+
+	//the track of the calling thread, created on first use
+	ProfileTrack *get_thread_track();
+	//a track not tied to a thread, for example a gpu queue, asking for the same name again hands out the same track
+	ProfileTrack *create_track(const std::string &name);
+
+	//only call this when no zone is being recorded, for example after the main loop
+	void write_chrome_trace(const std::string &path);
+
+private:
+	Profiler();
+
+	static std::atomic<bool> s_enabled;
+	std::chrono::steady_clock::time_point m_epoch;
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<ProfileTrack>> m_tracks;
+	uint32_t m_thread_count = 0;
+};
+
+//Times the scope it lives in and records it on the track of the current thread
+class ProfileZone
+{
+public:
+	ProfileZone(const char *name);
+	~ProfileZone();
+
+private:
+	const char *m_name = nullptr;
+	int64_t m_start = 0;
+};
+
+#ifdef ENABLE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+//names have to outlive the profiler, so use string literals
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#endif
+
+//Measures zones inside command buffers with timestamp queries.
+//The queries are split into sets, one per command buffer that can be in flight, and a set is only read back
+//once the caller knows the gpu is done with it, so reading never stalls.
+//Without calibrated timestamps gpu time can not be mapped to cpu time exactly,
+//so the first timestamp of a set is placed at the moment the set was submitted.
+class GpuTimer
+{
+public:
+	void initialize(VkPhysicalDevice physical_device, VkDevice logical_device, uint32_t queue_family, const std::string &track_name, uint32_t set_count = 1, uint32_t zones_per_set = 8);
+	void destroy();
+
+	//starts recording a set, call outside of a render pass
+	//the last submission of this set must be finished, its results are collected here
+	void begin(VkCommandBuffer command_buffer, uint32_t set);
+	//returns the zone to pass to end_zone
+	uint32_t begin_zone(VkCommandBuffer command_buffer, const char *name, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+	void end_zone(VkCommandBuffer command_buffer, uint32_t zone, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+	//call right before submitting the command buffer of the current set
+	void mark_submitted();
+	//collects every submitted set right away, only call once the gpu is known to be done with them
+	void read_back();
+	//duration of a zone when its set was last collected, negative if it was not measured
+	double get_last_milliseconds(uint32_t zone);
+	//keeps measuring while the profiler is disabled, for callers of get_last_milliseconds, nothing is traced then
+	void set_always_measure(bool always_measure);
+
+private:
+	struct QuerySet
+	{
+		std::vector<const char *> names;
+		int64_t submit_time = 0;
+		//written and submitted, but not read back yet
+		bool pending = false;
+		bool active = false;
+	};
+
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	VkQueryPool m_query_pool = VK_NULL_HANDLE;
+	bool m_always_measure = false;
+	float m_timestamp_period = 1.0f;
+	uint64_t m_timestamp_mask = 0;
+	uint32_t m_zones_per_set = 0;
+	uint32_t m_current_set = 0;
+	std::vector<QuerySet> m_sets;
+	std::vector<double> m_last_milliseconds;
+	ProfileTrack *m_track = nullptr;
+
+	void collect(uint32_t set);
+};
@@ -0,0 +1,155 @@
+#include "ripple_field.hpp"
+
+#include <emmintrin.h>
+
+RippleField::RippleField(uint32_t size, float wave_speed, float damping) : m_size(size), m_wave_speed(wave_speed), m_damping(damping)
+{
+	m_stride = (size + 2 + 3) / 4 * 4;
+	m_current.assign(static_cast<size_t>(m_stride) * (size + 2), 0.0f);
+	m_previous.assign(m_current.size(), 0.0f);
+}
+
+size_t RippleField::index(uint32_t x, uint32_t y) const
+{
+	return static_cast<size_t>(y + 1) * m_stride + x + 1;
+}
+
+void RippleField::follow(glm::vec2 center)
+{
+	glm::ivec2 origin(static_cast<int>(floorf(center.x)) - static_cast<int>(m_size / 2), static_cast<int>(floorf(center.y)) - static_cast<int>(m_size / 2));
+	int dx = origin.x - m_origin.x;
+	int dy = origin.y - m_origin.y;
+	if (dx == 0 && dy == 0)
+		return;
+
+	shift(m_current, dx, dy);
+	shift(m_previous, dx, dy);
+	m_origin = origin;
+}
+
+void RippleField::shift(std::vector<float> &heights, int dx, int dy) const
+{
+	std::vector<float> shifted(heights.size(), 0.0f);
+	int size = static_cast<int>(m_size);
+	//the cells that are in the patch before and after
+	int first_x = std::max(0, -dx), last_x = std::min(size, size - dx);
+	int first_y = std::max(0, -dy), last_y = std::min(size, size - dy);
+	for (int y = first_y; y < last_y; y++)
+	{
+		if (first_x >= last_x)
+			break;
+		const float *source = heights.data() + index(first_x + dx, y + dy);
+		std::copy(source, source + (last_x - first_x), shifted.data() + index(first_x, y));
+	}
+	heights.swap(shifted);
+}
+
+//a smooth bump, so a splash does not start with a hard edge that the grid can not carry
+void RippleField::disturb(glm::vec2 position, float radius, float strength)
+{
+	glm::vec2 local = position - glm::vec2(static_cast<float>(m_origin.x), static_cast<float>(m_origin.y));
+	int first_x = std::max(0, static_cast<int>(floorf(local.x - radius)));
+	int last_x = std::min(static_cast<int>(m_size) - 1, static_cast<int>(ceilf(local.x + radius)));
+	int first_y = std::max(0, static_cast<int>(floorf(local.y - radius)));
+	int last_y = std::min(static_cast<int>(m_size) - 1, static_cast<int>(ceilf(local.y + radius)));
+	for (int y = first_y; y <= last_y; y++)
+	{
+		for (int x = first_x; x <= last_x; x++)
+		{
+			float distance_squared = ((x - local.x) * (x - local.x) + (y - local.y) * (y - local.y)) / (radius * radius);
+			if (distance_squared >= 1.0f)
+				continue;
+			float falloff = 1.0f - distance_squared;
+			m_current[index(x, y)] -= strength * falloff * falloff;
+		}
+	}
+}
+
+//the explicit scheme is stable while a ripple moves at most half a cell per step
+void RippleField::step(float delta_time)
+{
+	PROFILE_FUNCTION();
+	if (delta_time <= 0.0f)
+		return;
+
+	float longest_step = 0.5f / m_wave_speed;
+	uint32_t substeps = std::min(static_cast<uint32_t>(ceilf(delta_time / longest_step)), MAX_SUBSTEPS);
+	float substep = std::min(delta_time / substeps, longest_step);
+	float courant = m_wave_speed * substep;
+	float damping = expf(-m_damping * substep);
+
+	uint32_t thread_count = std::min<uint32_t>(std::max(1u, std::thread::hardware_concurrency()), std::max(m_size / ROWS_PER_THREAD, 1u));
+	uint32_t rows_per_thread = (m_size + thread_count - 1) / thread_count;
+	for (uint32_t i = 0; i < substeps; i++)
+	{
+		std::vector<std::thread> threads;
+		for (uint32_t first_row = rows_per_thread; first_row < m_size; first_row += rows_per_thread)
+		{
+			threads.emplace_back(&RippleField::step_rows, this, first_row, std::min(first_row + rows_per_thread, m_size), courant * courant, damping);
+		}
+		step_rows(0, std::min(rows_per_thread, m_size), courant * courant, damping);
+		for (std::thread &thread : threads)
+		{
+			thread.join();
+		}
+		m_current.swap(m_previous);
+	}
+}
+
+//h' = damping * ((2 - 4k) h + k (sum of the four neighbours) - h_previous), with k = (speed * step / cell)^2
+//each row only reads the current heights and writes the previous ones, so rows can go on different threads
+void RippleField::step_rows(uint32_t first_row, uint32_t last_row, float courant_squared, float damping)
+{
+	const float *current = m_current.data();
+	float *previous = m_previous.data();
+	float center_weight = 2.0f - 4.0f * courant_squared;
+
+	__m128 center_weights = _mm_set1_ps(center_weight);
+	__m128 neighbour_weights = _mm_set1_ps(courant_squared);
+	__m128 dampings = _mm_set1_ps(damping);
+	for (uint32_t y = first_row; y < last_row; y++)
+	{
+		uint32_t x = 0;
+		for (; x + 4 <= m_size; x += 4)
+		{
+			size_t i = index(x, y);
+			__m128 neighbours = _mm_add_ps(
+				_mm_add_ps(_mm_loadu_ps(current + i - 1), _mm_loadu_ps(current + i + 1)),
+				_mm_add_ps(_mm_loadu_ps(current + i - m_stride), _mm_loadu_ps(current + i + m_stride)));
+			__m128 next = _mm_add_ps(_mm_mul_ps(center_weights, _mm_loadu_ps(current + i)), _mm_mul_ps(neighbour_weights, neighbours));
+			next = _mm_mul_ps(_mm_sub_ps(next, _mm_loadu_ps(previous + i)), dampings);
+			_mm_storeu_ps(previous + i, next);
+		}
+		for (; x < m_size; x++)
+		{
+			size_t i = index(x, y);
+			float neighbours = current[i - 1] + current[i + 1] + current[i - m_stride] + current[i + m_stride];
+			previous[i] = (center_weight * current[i] + courant_squared * neighbours - previous[i]) * damping;
+		}
+	}
+}
+
+void RippleField::add_to(std::vector<Displacement> &displacements, uint32_t resolution) const
+{
+	PROFILE_FUNCTION();
+	int first_x = std::max(0, -m_origin.x), last_x = std::min(static_cast<int>(m_size), static_cast<int>(resolution) - m_origin.x);
+	int first_y = std::max(0, -m_origin.y), last_y = std::min(static_cast<int>(m_size), static_cast<int>(resolution) - m_origin.y);
+	for (int y = first_y; y < last_y; y++)
+	{
+		Displacement *row = displacements.data() + static_cast<size_t>(m_origin.y + y) * resolution + m_origin.x;
+		for (int x = first_x; x < last_x; x++)
+		{
+			row[x].displacement.z += m_current[index(x, y)];
+		}
+	}
+}
+
+glm::ivec2 RippleField::get_origin() const
+{
+	return m_origin;
+}
+
+uint32_t RippleField::get_size() const
+{
+	return m_size;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include "displacement.hpp"
+#include "profiler.hpp"
+
+//A small patch of water that carries ripples, wakes and splashes on top of the gerstner waves.
+//It solves the damped wave equation on its own square grid with one cell per ocean vertex, so its heights can be
+//added straight to the displacement. The patch only covers the region it is told to follow, everything outside stays
+//untouched, so what it costs depends on its size and not on the resolution of the ocean.
+//Rows are updated with an sse stencil, four cells at a time, large patches split their rows across threads.
+class RippleField
+{
+public:
+	//fewer rows than this per thread cost more to hand out than to update
+	static const uint32_t ROWS_PER_THREAD = 64;
+	//long frames are caught up with at most this many steps, the rest of the time is dropped
+	static const uint32_t MAX_SUBSTEPS = 8;
+
+	//wave speed in cells per second, ripples lose e^-damping of their height every second
+	RippleField(uint32_t size, float wave_speed = 12.0f, float damping = 0.6f);
+
+	//moves the patch so it is centered near the given ocean grid position, whole cells at a time
+	//ripples that leave the patch are gone, those that stay keep going
+	void follow(glm::vec2 center);
+	//pushes the water in a round area down, a negative strength lifts it, in ocean grid cells
+	void disturb(glm::vec2 position, float radius, float strength);
+	//advances by delta_time in steps short enough to stay stable
+	void step(float delta_time);
+	//adds the heights of the patch to the part of a resolution^2 ocean displacement it covers
+	void add_to(std::vector<Displacement> &displacements, uint32_t resolution) const;
+
+	//the grid position of the first cell of the patch and its size in cells
+	glm::ivec2 get_origin() const;
+	uint32_t get_size() const;
+
+private:
+	uint32_t m_size;
+	//cells in a row including the border of zeros around the patch, rounded up for whole sse loads
+	uint32_t m_stride;
+	float m_wave_speed;
+	float m_damping;
+	glm::ivec2 m_origin = glm::ivec2(0, 0);
+
+	//heights now and one step ago, the next step is written over the older one
+	std::vector<float> m_current;
+	std::vector<float> m_previous;
+
+	//index of a cell of the patch in the height arrays, skipping the border
+	size_t index(uint32_t x, uint32_t y) const;
+	//one step of the given length on the rows [first_row, last_row)
+	void step_rows(uint32_t first_row, uint32_t last_row, float courant_squared, float damping);
+	//moves the contents of one array by whole cells, what moves out is lost and what moves in is calm water
+	void shift(std::vector<float> &heights, int dx, int dy) const;
+};
@@ -0,0 +1,220 @@
+#include "shader_reloader.hpp"
+
+//how often the directory is looked at
+static const std::chrono::milliseconds POLL_INTERVAL(250);
+
+uint32_t ShaderReloader::add_pipeline(const std::vector<std::string> &spirv_files, std::function<VkPipeline()> build_pipeline)
+{
+	Target target;
+	target.spirv_files = spirv_files;
+	target.build_pipeline = build_pipeline;
+	m_targets.push_back(target);
+	return static_cast<uint32_t>(m_targets.size() - 1);
+}
+
+void ShaderReloader::set_defines(const std::string &extension, const std::vector<std::string> &defines)
+{
+	m_defines[extension] = defines;
+}
+
+//remembers the current state of the directory, so only later changes count
+void ShaderReloader::start(VkDevice logical_device, const std::string &directory)
+{
+	info("Watching ", directory, " for shader changes...");
+	m_logical_device = logical_device;
+	m_directory = directory;
+	scan();
+
+	m_running = true;
+	m_thread = std::thread(&ShaderReloader::run, this);
+}
+
+//waits for a build in progress and destroys the pipelines nobody took
+void ShaderReloader::stop()
+{
+	if (!m_running)
+		return;
+
+	m_running = false;
+	m_thread.join();
+	for (uint32_t pipeline_id = 0; pipeline_id < m_targets.size(); pipeline_id++)
+	{
+		discard_pipeline(pipeline_id);
+	}
+}
+
+VkPipeline ShaderReloader::take_pipeline(uint32_t pipeline_id)
+{
+	if (pipeline_id >= m_targets.size())
+		return VK_NULL_HANDLE;
+
+	std::lock_guard<std::mutex> lock(m_pending_mutex);
+	VkPipeline pipeline = m_targets[pipeline_id].pending_pipeline;
+	m_targets[pipeline_id].pending_pipeline = VK_NULL_HANDLE;
+	return pipeline;
+}
+
+void ShaderReloader::discard_pipeline(uint32_t pipeline_id)
+{
+	if (pipeline_id >= m_targets.size())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_pending_mutex);
+	Target &target = m_targets[pipeline_id];
+	if (target.pending_pipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(m_logical_device, target.pending_pipeline, nullptr);
+		target.pending_pipeline = VK_NULL_HANDLE;
+	}
+	target.generation++;
+}
+
+bool ShaderReloader::has_changed(const std::string &file_name)
+{
+	return m_changed_spirv.count(file_name) != 0;
+}
+
+//editors tend to write a file more than once, so changes are only acted on once a scan finds nothing new
+void ShaderReloader::run()
+{
+	std::vector<std::filesystem::path> changed_sources;
+	std::set<std::string> changed_spirv;
+
+	while (m_running)
+	{
+		std::this_thread::sleep_for(POLL_INTERVAL);
+
+		std::vector<std::filesystem::path> changes = scan();
+		for (const std::filesystem::path &path : changes)
+		{
+			if (path.extension() == ".spv")
+			{
+				m_changed_spirv.insert(path.filename().string());
+				changed_spirv.insert(path.filename().string());
+			}
+			else if (std::find(changed_sources.begin(), changed_sources.end(), path) == changed_sources.end())
+			{
+				changed_sources.push_back(path);
+			}
+		}
+		if (!changes.empty())
+			continue;
+
+		//the compiled files show up as changes in the next scan and trigger the rebuild from there
+		for (const std::filesystem::path &source : changed_sources)
+		{
+			compile(source);
+		}
+		changed_sources.clear();
+
+		//only the pipelines built from one of the changed files
+		for (uint32_t pipeline_id = 0; pipeline_id < m_targets.size(); pipeline_id++)
+		{
+			const std::vector<std::string> &spirv_files = m_targets[pipeline_id].spirv_files;
+			if (std::any_of(spirv_files.begin(), spirv_files.end(), [&](const std::string &file) { return changed_spirv.count(file) != 0; }))
+			{
+				rebuild(pipeline_id);
+			}
+		}
+		changed_spirv.clear();
+	}
+}
+
+//looks at the GLSL sources and the SPIR-V next to them
+std::vector<std::filesystem::path> ShaderReloader::scan()
+{
+	static const std::vector<std::string> watched_extensions = { ".vert", ".geom", ".frag", ".comp", ".spv" };
+
+	std::vector<std::filesystem::path> changes;
+	std::error_code error;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(m_directory, error))
+	{
+		std::filesystem::path path = entry.path();
+		if (std::find(watched_extensions.begin(), watched_extensions.end(), path.extension().string()) == watched_extensions.end())
+			continue;
+
+		std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path, error);
+		if (error)
+			continue;
+
+		auto known = m_write_times.find(path);
+		if (known == m_write_times.end() || known->second != write_time)
+		{
+			m_write_times[path] = write_time;
+			changes.push_back(path);
+		}
+	}
+	return changes;
+}
+
+//compiles like compile.bat does, shader.vert becomes vert.spv
+bool ShaderReloader::compile(const std::filesystem::path &source)
+{
+	PROFILE_FUNCTION();
+	std::filesystem::path output = m_directory / (source.extension().string().substr(1) + ".spv");
+
+	//the sdk puts the compiler into its Bin directory, otherwise hope it is on the path
+	std::string compiler = "glslangValidator";
+	const char *sdk = std::getenv("VULKAN_SDK");
+	if (sdk != nullptr)
+	{
+		compiler = (std::filesystem::path(sdk) / "Bin" / "glslangValidator").string();
+	}
+
+	info("Compiling ", source.string(), "...");
+	std::string command = "\"" + compiler + "\" -V \"" + source.string() + "\"";
+	for (const std::string &define : m_defines[source.extension().string()])
+	{
+		command += " -D" + define;
+	}
+	command += " -o \"" + output.string() + "\"";
+#ifdef _WIN32
+	//cmd strips the outer quotes of the whole command
+	command = "\"" + command + "\"";
+#endif
+	if (std::system(command.c_str()) != 0)
+	{
+		err("Compiling ", source.string(), " failed, keeping the old shader");
+		return false;
+	}
+	return true;
+}
+
+//builds the pipeline from the changed .spv files and hands it to the render loop
+void ShaderReloader::rebuild(uint32_t pipeline_id)
+{
+	PROFILE_FUNCTION();
+	info("Shaders changed, rebuilding pipeline...");
+	Target &target = m_targets[pipeline_id];
+
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+		generation = target.generation;
+	}
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	try
+	{
+		pipeline = target.build_pipeline();
+	}
+	catch (const std::runtime_error &error)
+	{
+		err("Rebuilding the pipeline failed, keeping the old one: ", error.what());
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_pending_mutex);
+	//something the pipeline was built against changed in the meantime
+	if (generation != target.generation)
+	{
+		vkDestroyPipeline(m_logical_device, pipeline, nullptr);
+		return;
+	}
+	//a pipeline the render loop did not take yet is outdated now
+	if (target.pending_pipeline != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(m_logical_device, target.pending_pipeline, nullptr);
+	}
+	target.pending_pipeline = pipeline;
+}
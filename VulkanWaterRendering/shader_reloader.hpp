@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <filesystem>
+#include <cstdlib>
+#include <stdexcept>
+#include <limits>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+#include "profiler.hpp"
+
+//Watches the shader directory and rebuilds the pipelines when a shader changes, without stopping the frames.
+//A changed GLSL source is compiled to SPIR-V with glslangValidator, a changed .spv file triggers the build of every pipeline using it.
+//Only the stages whose .spv was written while watching are newer than the embedded shaders, the rest should come from those.
+//Both happen on the watcher thread, the render loop only picks up the finished pipelines between frames.
+class ShaderReloader
+{
+public:
+	//an id no pipeline was added under, taking or discarding it does nothing
+	static const uint32_t NO_PIPELINE = std::numeric_limits<uint32_t>::max();
+
+	//call before start, build_pipeline runs on the watcher thread when one of the .spv files changed
+	//and may throw if the shaders are broken, the old pipeline is kept then
+	//returns the id to take or discard the rebuilt pipeline with
+	uint32_t add_pipeline(const std::vector<std::string> &spirv_files, std::function<VkPipeline()> build_pipeline);
+	//call before start, sources with the extension are compiled with these defines, like the build does for the variant in use
+	void set_defines(const std::string &extension, const std::vector<std::string> &defines);
+	void start(VkDevice logical_device, const std::string &directory);
+	void stop();
+
+	//the newest rebuilt pipeline, VK_NULL_HANDLE if there is none, the caller owns it from then on
+	VkPipeline take_pipeline(uint32_t pipeline_id);
+	//drops the pipeline waiting to be taken and any build in progress, call when what the pipeline depends on changed
+	void discard_pipeline(uint32_t pipeline_id);
+	//whether the .spv file with the given name was written since start, only call from build_pipeline
+	bool has_changed(const std::string &file_name);
+
+private:
+	//a pipeline and the .spv files it is built from
+	struct Target
+	{
+		std::vector<std::string> spirv_files;
+		std::function<VkPipeline()> build_pipeline;
+		VkPipeline pending_pipeline = VK_NULL_HANDLE;
+		//counts discards, a build that started before the last discard is thrown away
+		uint64_t generation = 0;
+	};
+
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	std::filesystem::path m_directory;
+	std::vector<Target> m_targets;
+	std::map<std::string, std::vector<std::string>> m_defines;
+
+	std::thread m_thread;
+	std::atomic<bool> m_running{ false };
+
+	//guards the pending pipelines and generations of the targets
+	std::mutex m_pending_mutex;
+
+	//last write times of all watched files
+	std::map<std::filesystem::path, std::filesystem::file_time_type> m_write_times;
+	//names of the .spv files written since start, only touched by the watcher thread
+	std::set<std::string> m_changed_spirv;
+
+	void run();
+	//collects the files whose write time changed since the last scan
+	std::vector<std::filesystem::path> scan();
+	bool compile(const std::filesystem::path &source);
+	void rebuild(uint32_t pipeline_id);
+};
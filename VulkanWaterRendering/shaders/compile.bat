@@ -1,4 +1,5 @@
 %VULKAN_SDK%\Bin\glslangValidator -V shader.vert
 %VULKAN_SDK%\Bin\glslangValidator -V shader.geom
 %VULKAN_SDK%\Bin\glslangValidator -V shader.frag
+%VULKAN_SDK%\Bin\glslangValidator -V shader.comp
 pause
\ No newline at end of file
@@ -1,7 +1,17 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-//layout(binding = 1) uniform sampler2D texture_sampler;
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 model;
+	mat4 view;
+	mat4 projection;
+	float time;
+	vec3 lod_camera;
+	float lod_cutoff_per_distance;
+} ubo;
+
+//the normals OceanTexture simulated, read at the map coordinate the vertex shader passed on
+layout(binding = 1) uniform sampler2D normal_map;
 
 layout(location = 0) in vec3 fragment_color;
 layout(location = 1) in vec2 fragment_texture_coordinate;
@@ -12,6 +22,11 @@ layout(location = 5) in vec3 vert_position;
 
 layout(location = 0) out vec4 outColor;
 
+//0 lights the surface, 1 shows its normals, set when the pipeline is built
+layout(constant_id = 0) const uint shading_mode = 0;
+//with sample_normals every fragment gets the normal of the water under it, instead of the one of its triangle
+layout(constant_id = 1) const bool sample_normals = false;
+
 //general luminosity
 vec4 ambient_light_color = vec4(0.3f,0.3f,0.3f,1.0f);
 //ocean color
@@ -22,12 +37,24 @@ vec4 diffuse_color = vec4(0.406f, 0.368f, 0.225f, 1.0f);
 vec4 specular_color = vec4(1.0f,1.0f,1.0f,1.0f);
 
 void main() {
+    vec3 surface_normal = normal;
+    vec3 reflection = light_reflection;
+    if(sample_normals){
+        //the map points up out of the water, the triangle normals of the geometry shader point into it
+        surface_normal = -normalize(mat3(ubo.view * ubo.model) * texture(normal_map, fragment_texture_coordinate).xyz);
+        reflection = reflect(-light_direction, surface_normal);
+    }
+
+    if(shading_mode == 1){
+        outColor = vec4(surface_normal * 0.5f + 0.5f, 1.0f);
+        return;
+    }
 
-    float lambertian = max(dot(light_direction, -normal), 0.0f);
+    float lambertian = max(dot(light_direction, -surface_normal), 0.0f);
     float specular = 0.0f;
 
     if(lambertian>0.0f){
-        float specAngle = max(dot(light_reflection, normalize(-vert_position)), 0.0f);
+        float specAngle = max(dot(reflection, normalize(-vert_position)), 0.0f);
         specular = pow(specAngle, 4.0f);
     }
     //add all light sources together
@@ -5,8 +5,43 @@ layout(binding = 0) uniform UniformBufferObject {
 	mat4 model;
 	mat4 view;
 	mat4 projection;
+	float time;
+	//the wave lod, see WaveLod
+	vec3 lod_camera;
+	float lod_cutoff_per_distance;
 } ubo;
 
+//with evaluate_waves the waves are evaluated here instead of being read from the displacement buffer,
+//same as Gerstner::get_displacement on the cpu, the counts are baked in when the pipeline is built
+layout(constant_id = 0) const bool evaluate_waves = false;
+layout(constant_id = 1) const uint wave_count = 1;
+layout(constant_id = 2) const uint resolution = 2;
+//with sample_texture the displacement comes from the map OceanTexture simulated, which covers the whole plane
+layout(constant_id = 3) const bool sample_texture = false;
+
+layout(binding = 4) uniform sampler2D displacement_map;
+
+struct Wave {
+	vec2 direction;
+	float amplitude;
+	float frequency;
+	float phase_constant;
+	float steepness;
+	float phase_offset;
+	float wavelength;
+};
+
+layout(std430, binding = 2) readonly buffer Waves {
+	Wave waves[];
+};
+
+//the parity check build writes what it evaluated, so the cpu can compare it with its own waves
+#ifdef WRITE_DISPLACEMENT
+layout(std430, binding = 3) writeonly buffer EvaluatedDisplacements {
+	float evaluated_displacements[];
+};
+#endif
+
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec3 in_color;
 layout(location = 2) in vec2 in_tex_coord;
@@ -24,9 +59,60 @@ out gl_PerVertex {
     vec4 gl_Position;
 };
 
+//smoothstep from the cutoff to twice of it, same as WaveLod::get_weight on the cpu, so waves fade out instead of popping
+float lod_weight(float wavelength, float cutoff) {
+	if (cutoff <= 0.0)
+		return 1.0;
+	float t = clamp(wavelength / cutoff - 1.0, 0.0, 1.0);
+	return t * t * (3.0 - 2.0 * t);
+}
+
+vec3 evaluate_displacement() {
+	uint index = uint(gl_VertexIndex);
+	//undisturbed position on the grid
+	vec2 x0 = vec2(index % resolution, index / resolution);
+
+	//the waves are sorted longest first, those shorter than the cutoff are too small to see this far from the camera
+	float cutoff = ubo.lod_cutoff_per_distance * distance(vec3(x0, 0.0), ubo.lod_camera);
+
+	vec3 displacement = vec3(0.0);
+	for (uint i = 0; i < wave_count; i++) {
+		Wave wave = waves[i];
+		if (cutoff > 0.0 && wave.wavelength <= cutoff)
+			break;
+		float phase = wave.frequency * dot(wave.direction, x0) + wave.phase_constant * ubo.time + wave.phase_offset;
+		float amplitude = wave.amplitude * lod_weight(wave.wavelength, cutoff);
+		float horizontal = wave.steepness * amplitude * cos(phase);
+		displacement.xy += horizontal * wave.direction;
+		displacement.z += amplitude * sin(phase);
+	}
+
+#ifdef WRITE_DISPLACEMENT
+	evaluated_displacements[index * 3 + 0] = displacement.x;
+	evaluated_displacements[index * 3 + 1] = displacement.y;
+	evaluated_displacements[index * 3 + 2] = displacement.z;
+#endif
+	return displacement;
+}
+
+//texel i of the map holds the waves at grid position i * resolution / map size, its center is half a texel further
+vec2 map_coordinate() {
+	uint index = uint(gl_VertexIndex);
+	vec2 x0 = vec2(index % resolution, index / resolution);
+	return x0 / float(resolution) + 0.5 / vec2(textureSize(displacement_map, 0));
+}
+
+//a mesh coarser than the map reads a mip level where a texel is about as large as a cell, so nothing in between is skipped
+vec3 sample_displacement(vec2 coordinate) {
+	float lod = log2(max(float(textureSize(displacement_map, 0).x) / float(resolution), 1.0));
+	return textureLod(displacement_map, coordinate, lod).xyz;
+}
+
 void main() {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(in_position+in_displacement, 1.0);
+    vec2 coordinate = sample_texture ? map_coordinate() : in_tex_coord;
+    vec3 displacement = evaluate_waves ? evaluate_displacement() : sample_texture ? sample_displacement(coordinate) : in_displacement;
+    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(in_position+displacement, 1.0);
     out_color = in_color;
-    out_texture_coord = in_tex_coord;
+    out_texture_coord = coordinate;
     out_view = ubo.view;
 }
\ No newline at end of file
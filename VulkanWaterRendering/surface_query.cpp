@@ -0,0 +1,201 @@
+#include "surface_query.hpp"
+
+#include <emmintrin.h>
+
+//sine and cosine of four angles, reduced to a quarter turn and approximated with the polynomials of cephes,
+//accurate to a few ulp, which is all the floats going in have anyway
+static inline void sincos_ps(__m128 x, __m128 &sine, __m128 &cosine)
+{
+	const __m128 TWO_OVER_PI = _mm_set1_ps(0.636619772f);
+	//pi / 2 split in three, so subtracting multiples of it does not lose the low bits
+	const __m128 HALF_PI_1 = _mm_set1_ps(1.5703125f);
+	const __m128 HALF_PI_2 = _mm_set1_ps(4.837512969970703125e-4f);
+	const __m128 HALF_PI_3 = _mm_set1_ps(7.54978995489188216e-8f);
+
+	__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, TWO_OVER_PI));
+	__m128 turns = _mm_cvtepi32_ps(quadrant);
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(turns, HALF_PI_1));
+	r = _mm_sub_ps(r, _mm_mul_ps(turns, HALF_PI_2));
+	r = _mm_sub_ps(r, _mm_mul_ps(turns, HALF_PI_3));
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	//both are only accurate between -pi / 4 and pi / 4
+	__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(-1.6666654611e-1f));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+	__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+	c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(4.166664568298827e-2f));
+	c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, r2), r2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)));
+
+	//every quarter turn swaps sine and cosine, the sign follows from the half turns
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	__m128 sine_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	__m128 cosine_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+	sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sine_sign);
+	cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosine_sign);
+}
+
+SurfaceQuery::SurfaceQuery(const std::vector<GerstnerParameters> &waves, glm::vec2 origin, float cell_size) : m_origin(origin), m_cell_size(cell_size)
+{
+	for (const GerstnerParameters &wave : waves)
+	{
+		m_step_x.push_back(wave.frequency * wave.direction.x);
+		m_step_y.push_back(wave.frequency * wave.direction.y);
+		m_omega.push_back(wave.phase_constant);
+		m_phase_offset.push_back(wave.phase_offset);
+		m_horizontal_x.push_back(wave.steepness * wave.amplitude * wave.direction.x);
+		m_horizontal_y.push_back(wave.steepness * wave.amplitude * wave.direction.y);
+		m_amplitude.push_back(wave.amplitude);
+	}
+}
+
+//the caller evaluates the first batch itself, so a small query never starts a thread
+void SurfaceQuery::sample(const glm::vec2 *positions, size_t count, float time, WaterSample *samples) const
+{
+	PROFILE_FUNCTION();
+	size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), std::max<size_t>(count / POSITIONS_PER_THREAD, 1));
+	size_t batch_size = (count + thread_count - 1) / thread_count;
+
+	std::vector<std::thread> threads;
+	for (size_t first = batch_size; first < count; first += batch_size)
+	{
+		threads.emplace_back(&SurfaceQuery::sample_range, this, positions + first, std::min(batch_size, count - first), time, samples + first);
+	}
+	sample_range(positions, std::min(batch_size, count), time, samples);
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void SurfaceQuery::sample_range(const glm::vec2 *positions, size_t count, float time, WaterSample *samples) const
+{
+	std::vector<float> starts(m_omega.size());
+	for (size_t i = 0; i < starts.size(); i++)
+	{
+		starts[i] = m_omega[i] * time + m_phase_offset[i];
+	}
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		sample_four(positions + i, starts.data(), samples + i);
+	}
+
+	//the last few are padded with copies of the final position
+	if (i < count)
+	{
+		glm::vec2 padded_positions[4];
+		WaterSample padded_samples[4];
+		for (size_t j = 0; j < 4; j++)
+		{
+			padded_positions[j] = positions[std::min(i + j, count - 1)];
+		}
+		sample_four(padded_positions, starts.data(), padded_samples);
+		std::copy(padded_samples, padded_samples + (count - i), samples + i);
+	}
+}
+
+void SurfaceQuery::sample_four(const glm::vec2 *positions, const float *starts, WaterSample *samples) const
+{
+	//where the positions are on the grid, in cells like x0
+	__m128 inverse_cell_size = _mm_set1_ps(1.0f / m_cell_size);
+	__m128 target_x = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(positions[0].x, positions[1].x, positions[2].x, positions[3].x), _mm_set1_ps(m_origin.x)), inverse_cell_size);
+	__m128 target_y = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(positions[0].y, positions[1].y, positions[2].y, positions[3].y), _mm_set1_ps(m_origin.y)), inverse_cell_size);
+
+	//the displacement is added to the world position as it is, so it moves a point by D / cell_size cells
+	//newton steps on x0 + D(x0) / cell_size = target, with the jacobian of the displacement, converge in a couple of steps
+	__m128 x = target_x;
+	__m128 y = target_y;
+	for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++)
+	{
+		__m128 displacement_x = _mm_setzero_ps(), displacement_y = _mm_setzero_ps();
+		__m128 dx_dx = _mm_setzero_ps(), dx_dy = _mm_setzero_ps(), dy_dx = _mm_setzero_ps(), dy_dy = _mm_setzero_ps();
+		for (size_t wave = 0; wave < m_amplitude.size(); wave++)
+		{
+			__m128 step_x = _mm_set1_ps(m_step_x[wave]);
+			__m128 step_y = _mm_set1_ps(m_step_y[wave]);
+			__m128 phase = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, step_x), _mm_mul_ps(y, step_y)), _mm_set1_ps(starts[wave]));
+			__m128 sine, cosine;
+			sincos_ps(phase, sine, cosine);
+			__m128 horizontal_x = _mm_set1_ps(m_horizontal_x[wave]);
+			__m128 horizontal_y = _mm_set1_ps(m_horizontal_y[wave]);
+			displacement_x = _mm_add_ps(displacement_x, _mm_mul_ps(horizontal_x, cosine));
+			displacement_y = _mm_add_ps(displacement_y, _mm_mul_ps(horizontal_y, cosine));
+			horizontal_x = _mm_mul_ps(horizontal_x, sine);
+			horizontal_y = _mm_mul_ps(horizontal_y, sine);
+			dx_dx = _mm_sub_ps(dx_dx, _mm_mul_ps(horizontal_x, step_x));
+			dx_dy = _mm_sub_ps(dx_dy, _mm_mul_ps(horizontal_x, step_y));
+			dy_dx = _mm_sub_ps(dy_dx, _mm_mul_ps(horizontal_y, step_x));
+			dy_dy = _mm_sub_ps(dy_dy, _mm_mul_ps(horizontal_y, step_y));
+		}
+		//the residual and the 2x2 jacobian of x0 + D(x0) / cell_size, solved with cramers rule
+		__m128 residual_x = _mm_sub_ps(_mm_add_ps(x, _mm_mul_ps(displacement_x, inverse_cell_size)), target_x);
+		__m128 residual_y = _mm_sub_ps(_mm_add_ps(y, _mm_mul_ps(displacement_y, inverse_cell_size)), target_y);
+		__m128 a = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(dx_dx, inverse_cell_size));
+		__m128 b = _mm_mul_ps(dx_dy, inverse_cell_size);
+		__m128 c = _mm_mul_ps(dy_dx, inverse_cell_size);
+		__m128 d = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(dy_dy, inverse_cell_size));
+		__m128 determinant = _mm_sub_ps(_mm_mul_ps(a, d), _mm_mul_ps(b, c));
+		//where the waves loop the jacobian folds over, a plain fixed point step is the best there is
+		__m128 folded = _mm_cmple_ps(determinant, _mm_set1_ps(0.05f));
+		__m128 inverse_determinant = _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(_mm_and_ps(folded, _mm_set1_ps(1.0f)), _mm_andnot_ps(folded, determinant)));
+		__m128 newton_x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(d, residual_x), _mm_mul_ps(b, residual_y)), inverse_determinant);
+		__m128 newton_y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(a, residual_y), _mm_mul_ps(c, residual_x)), inverse_determinant);
+		x = _mm_sub_ps(x, _mm_or_ps(_mm_and_ps(folded, residual_x), _mm_andnot_ps(folded, newton_x)));
+		y = _mm_sub_ps(y, _mm_or_ps(_mm_and_ps(folded, residual_y), _mm_andnot_ps(folded, newton_y)));
+	}
+
+	//height, the derivatives of the displacement along x0 and its change over time at the point that was found
+	__m128 height = _mm_setzero_ps();
+	__m128 dx_dx = _mm_setzero_ps(), dx_dy = _mm_setzero_ps(), dy_dx = _mm_setzero_ps(), dy_dy = _mm_setzero_ps();
+	__m128 dz_dx = _mm_setzero_ps(), dz_dy = _mm_setzero_ps();
+	__m128 velocity_x = _mm_setzero_ps(), velocity_y = _mm_setzero_ps(), velocity_z = _mm_setzero_ps();
+	for (size_t wave = 0; wave < m_amplitude.size(); wave++)
+	{
+		__m128 step_x = _mm_set1_ps(m_step_x[wave]);
+		__m128 step_y = _mm_set1_ps(m_step_y[wave]);
+		__m128 phase = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, step_x), _mm_mul_ps(y, step_y)), _mm_set1_ps(starts[wave]));
+		__m128 sine, cosine;
+		sincos_ps(phase, sine, cosine);
+
+		__m128 amplitude = _mm_set1_ps(m_amplitude[wave]);
+		__m128 omega = _mm_set1_ps(m_omega[wave]);
+		__m128 vertical = _mm_mul_ps(amplitude, cosine);
+		__m128 horizontal_x = _mm_mul_ps(_mm_set1_ps(m_horizontal_x[wave]), sine);
+		__m128 horizontal_y = _mm_mul_ps(_mm_set1_ps(m_horizontal_y[wave]), sine);
+
+		height = _mm_add_ps(height, _mm_mul_ps(amplitude, sine));
+		dz_dx = _mm_add_ps(dz_dx, _mm_mul_ps(vertical, step_x));
+		dz_dy = _mm_add_ps(dz_dy, _mm_mul_ps(vertical, step_y));
+		dx_dx = _mm_sub_ps(dx_dx, _mm_mul_ps(horizontal_x, step_x));
+		dx_dy = _mm_sub_ps(dx_dy, _mm_mul_ps(horizontal_x, step_y));
+		dy_dx = _mm_sub_ps(dy_dx, _mm_mul_ps(horizontal_y, step_x));
+		dy_dy = _mm_sub_ps(dy_dy, _mm_mul_ps(horizontal_y, step_y));
+		velocity_x = _mm_sub_ps(velocity_x, _mm_mul_ps(horizontal_x, omega));
+		velocity_y = _mm_sub_ps(velocity_y, _mm_mul_ps(horizontal_y, omega));
+		velocity_z = _mm_add_ps(velocity_z, _mm_mul_ps(vertical, omega));
+	}
+
+	float heights[4], derivatives[6][4], velocities[3][4];
+	_mm_storeu_ps(heights, height);
+	_mm_storeu_ps(derivatives[0], dx_dx);
+	_mm_storeu_ps(derivatives[1], dx_dy);
+	_mm_storeu_ps(derivatives[2], dy_dx);
+	_mm_storeu_ps(derivatives[3], dy_dy);
+	_mm_storeu_ps(derivatives[4], dz_dx);
+	_mm_storeu_ps(derivatives[5], dz_dy);
+	_mm_storeu_ps(velocities[0], velocity_x);
+	_mm_storeu_ps(velocities[1], velocity_y);
+	_mm_storeu_ps(velocities[2], velocity_z);
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		//the surface moves along the tangents as x0 does, the normal is their cross product
+		glm::vec3 tangent_x(m_cell_size + derivatives[0][i], derivatives[2][i], derivatives[4][i]);
+		glm::vec3 tangent_y(derivatives[1][i], m_cell_size + derivatives[3][i], derivatives[5][i]);
+		samples[i].height = heights[i];
+		samples[i].normal = glm::normalize(glm::cross(tangent_x, tangent_y));
+		samples[i].velocity = glm::vec3(velocities[0][i], velocities[1][i], velocities[2][i]);
+	}
+}
@@ -0,0 +1,107 @@
+#include "sweep.hpp"
+
+SweepRunner::SweepRunner(const ApplicationConfig &base_config) : m_base_config(base_config)
+{
+	build_configs();
+}
+
+//runs every configuration, a failing one is written down and the sweep goes on
+void SweepRunner::run()
+{
+	info("Sweeping ", m_configs.size(), " configurations...");
+	std::ofstream file(m_base_config.sweep_output);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open sweep output " + m_base_config.sweep_output);
+	}
+	write_header(file);
+
+	for (size_t i = 0; i < m_configs.size(); i++)
+	{
+		const ApplicationConfig &config = m_configs[i];
+		info("Configuration ", i + 1, "/", m_configs.size(), ": resolution ", config.resolution, ", waves ", config.wave_count, ", present mode ", config.present_mode, ", simulation ", config.simulation);
+
+		Application application;
+		try
+		{
+			application.configure(config);
+			application.run();
+			write_row(file, config, application.get_benchmark_result(), "ok");
+		}
+		catch (const std::runtime_error &error)
+		{
+			err(error.what());
+			write_row(file, config, application.get_benchmark_result(), error.what());
+		}
+	}
+	succ("Sweep results written to ", m_base_config.sweep_output);
+}
+
+//the cartesian product of all swept values, options that are not swept keep the value of the base config
+void SweepRunner::build_configs()
+{
+	std::vector<uint32_t> resolutions = m_base_config.sweep_resolutions;
+	if (resolutions.empty())
+		resolutions.push_back(m_base_config.resolution);
+	std::vector<uint32_t> wave_counts = m_base_config.sweep_wave_counts;
+	if (wave_counts.empty())
+		wave_counts.push_back(m_base_config.wave_count);
+	std::vector<std::string> present_modes = m_base_config.sweep_present_modes;
+	if (present_modes.empty())
+		present_modes.push_back(m_base_config.present_mode);
+	std::vector<std::string> simulations = m_base_config.sweep_simulations;
+	if (simulations.empty())
+		simulations.push_back(m_base_config.simulation);
+
+	ApplicationConfig sweep_config = m_base_config;
+	sweep_config.interactive = false;
+	sweep_config.headless = m_base_config.sweep_present_modes.empty();
+	//every run would overwrite the same files
+	sweep_config.timings_path.clear();
+	sweep_config.trace_path.clear();
+	sweep_config.dump_frames.clear();
+	sweep_config.record_path.clear();
+	if (sweep_config.frame_count == 0)
+	{
+		sweep_config.frame_count = 100;
+	}
+
+	for (uint32_t resolution : resolutions)
+	{
+		for (uint32_t wave_count : wave_counts)
+		{
+			for (const std::string &present_mode : present_modes)
+			{
+				for (const std::string &simulation : simulations)
+				{
+					ApplicationConfig config = sweep_config;
+					config.resolution = resolution;
+					config.wave_count = wave_count;
+					config.present_mode = present_mode;
+					config.simulation = simulation;
+					m_configs.push_back(config);
+				}
+			}
+		}
+	}
+}
+
+void SweepRunner::write_header(std::ofstream &file)
+{
+	file << "resolution,used_resolution,waves,requested_present_mode,present_mode,requested_simulation,simulation,frames,cpu_avg_ms,cpu_min_ms,cpu_max_ms,gpu_avg_ms,gpu_min_ms,gpu_max_ms,status" << std::endl;
+}
+
+//flushes every row, so a crash halfway through keeps the finished runs
+void SweepRunner::write_row(std::ofstream &file, const ApplicationConfig &config, const BenchmarkResult &result, const std::string &status)
+{
+	std::string escaped_status = status;
+	std::replace(escaped_status.begin(), escaped_status.end(), ',', ';');
+
+	file << config.resolution << ',' << result.resolution << ',' << config.wave_count << ','
+		<< config.present_mode << ',' << result.present_mode << ','
+		<< config.simulation << ',' << result.simulation << ','
+		<< result.frames << ','
+		<< result.cpu_average_milliseconds << ',' << result.cpu_min_milliseconds << ',' << result.cpu_max_milliseconds << ','
+		<< result.gpu_average_milliseconds << ',' << result.gpu_min_milliseconds << ',' << result.gpu_max_milliseconds << ','
+		<< escaped_status << std::endl;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+
+#include "logger.hpp"
+#include "config.hpp"
+#include "application.hpp"
+
+//Runs the renderer once for every combination of the swept resolutions, wave counts, present modes and simulations
+//and collects the frame times of all runs in one csv file.
+//Every run gets a fresh application, so nothing carries over from one configuration to the next.
+//Sweeps run headless unless present modes are swept, those need a window to mean anything.
+class SweepRunner
+{
+public:
+	SweepRunner(const ApplicationConfig &base_config);
+
+	void run();
+
+private:
+	ApplicationConfig m_base_config;
+	std::vector<ApplicationConfig> m_configs;
+
+	void build_configs();
+	void write_header(std::ofstream &file);
+	void write_row(std::ofstream &file, const ApplicationConfig &config, const BenchmarkResult &result, const std::string &status);
+};
@@ -0,0 +1,191 @@
+#include "task_graph.hpp"
+
+TaskGraph::TaskId TaskGraph::add(const char *name, std::function<void()> work, const std::vector<TaskId> &dependencies, bool main_thread)
+{
+	TaskId id = m_tasks.size();
+	Task task = {};
+	task.name = name;
+	task.work = work;
+	task.dependencies = dependencies;
+	task.main_thread = main_thread;
+	task.waiting_for = dependencies.size();
+	for (TaskId dependency : dependencies)
+	{
+		if (dependency >= id)
+		{
+			throw std::runtime_error("Tasks can only depend on tasks added before them");
+		}
+		m_tasks[dependency].dependents.push_back(id);
+	}
+	m_tasks.push_back(task);
+	return id;
+}
+
+//spawns a worker per core, but never more than there are tasks they could run
+void TaskGraph::run()
+{
+	PROFILE_FUNCTION();
+	size_t worker_task_count = 0;
+	for (TaskId id = 0; id < m_tasks.size(); id++)
+	{
+		if (m_tasks[id].main_thread)
+			m_main_remaining++;
+		else
+			worker_task_count++;
+
+		if (m_tasks[id].waiting_for == 0)
+			push_ready(id);
+	}
+
+	size_t worker_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), worker_task_count);
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < worker_count; i++)
+	{
+		workers.emplace_back(&TaskGraph::work, this, false);
+	}
+	work(true);
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+
+	if (m_exception)
+	{
+		std::rethrow_exception(m_exception);
+	}
+}
+
+//walks back from the task that finished last, always to the dependency that finished last
+void TaskGraph::print_critical_path()
+{
+	if (m_tasks.empty())
+		return;
+
+	TaskId current = 0;
+	for (TaskId id = 1; id < m_tasks.size(); id++)
+	{
+		if (m_tasks[id].end > m_tasks[current].end)
+			current = id;
+	}
+
+	std::vector<TaskId> path = { current };
+	while (!m_tasks[current].dependencies.empty())
+	{
+		const std::vector<TaskId> &dependencies = m_tasks[current].dependencies;
+		current = *std::max_element(dependencies.begin(), dependencies.end(), [this](TaskId a, TaskId b) { return m_tasks[a].end < m_tasks[b].end; });
+		path.push_back(current);
+	}
+	std::reverse(path.begin(), path.end());
+
+	ProfileTrack *track = Profiler::is_enabled() ? Profiler::get().create_track("Startup critical path") : nullptr;
+	std::string description;
+	for (TaskId id : path)
+	{
+		const Task &task = m_tasks[id];
+		description += (description.empty() ? "" : " -> ") + std::string(task.name) + " " + std::to_string((task.end - task.start) / 1000000.0) + "ms";
+		if (track != nullptr)
+		{
+			track->push(task.name, task.start, task.end);
+		}
+	}
+	info("Startup critical path: ", description);
+	info("Startup took ", (m_tasks[path.back()].end - m_tasks[path.front()].start) / 1000000.0, "ms from the first task on the path to the last");
+}
+
+void TaskGraph::work(bool main_thread)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_condition.wait(lock, [this, main_thread]()
+		{
+			return m_finished == m_tasks.size() || !(main_thread ? m_main_ready : m_ready).empty() || (main_thread && m_main_remaining == 0 && !m_ready.empty());
+		});
+		if (m_finished == m_tasks.size())
+			return;
+
+		std::deque<TaskId> &queue = main_thread && !m_main_ready.empty() ? m_main_ready : m_ready;
+		TaskId id = queue.front();
+		queue.pop_front();
+
+		lock.unlock();
+		execute(id);
+		lock.lock();
+
+		m_finished++;
+		if (m_tasks[id].main_thread)
+			m_main_remaining--;
+
+		if (m_tasks[id].skipped)
+		{
+			for (TaskId dependent : m_tasks[id].dependents)
+			{
+				skip(dependent);
+			}
+		}
+		else
+		{
+			release_dependents(id);
+		}
+		m_condition.notify_all();
+	}
+}
+
+//times the task and keeps its exception for the caller
+void TaskGraph::execute(TaskId id)
+{
+	Task &task = m_tasks[id];
+	ProfileZone zone(task.name);
+	task.start = Profiler::get().now();
+	try
+	{
+		task.work();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_exception)
+		{
+			m_exception = std::current_exception();
+		}
+		task.skipped = true;
+	}
+	task.end = Profiler::get().now();
+}
+
+void TaskGraph::skip(TaskId id)
+{
+	Task &task = m_tasks[id];
+	if (task.skipped)
+		return;
+
+	warn("Skipping startup task ", task.name, ", something it depends on failed");
+	task.skipped = true;
+	m_finished++;
+	if (task.main_thread)
+		m_main_remaining--;
+
+	for (TaskId dependent : task.dependents)
+	{
+		skip(dependent);
+	}
+}
+
+void TaskGraph::release_dependents(TaskId id)
+{
+	for (TaskId dependent : m_tasks[id].dependents)
+	{
+		if (--m_tasks[dependent].waiting_for == 0 && !m_tasks[dependent].skipped)
+		{
+			push_ready(dependent);
+		}
+	}
+}
+
+void TaskGraph::push_ready(TaskId id)
+{
+	if (m_tasks[id].main_thread)
+		m_main_ready.push_back(id);
+	else
+		m_ready.push_back(id);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "profiler.hpp"
+
+//A set of named jobs with dependencies, run once on a few worker threads.
+//A task starts as soon as everything it depends on is done, so independent work overlaps and the caller
+//only waits for the whole graph. Tasks marked main thread run on the thread calling run, for apis like glfw
+//that insist on it, the calling thread helps with the other tasks once none of those are left.
+//Every task is a profiler zone on the thread that ran it, the critical path gets its own track.
+class TaskGraph
+{
+public:
+	using TaskId = size_t;
+
+	//names have to outlive the profiler, so use string literals
+	TaskId add(const char *name, std::function<void()> work, const std::vector<TaskId> &dependencies = {}, bool main_thread = false);
+
+	//runs every task and blocks until all are done
+	//if a task throws, whatever depends on it is skipped and the first exception is rethrown here
+	void run();
+
+	//logs the chain of tasks that decided how long the graph took
+	void print_critical_path();
+
+private:
+	struct Task
+	{
+		const char *name;
+		std::function<void()> work;
+		std::vector<TaskId> dependencies;
+		std::vector<TaskId> dependents;
+		bool main_thread;
+		//dependencies that are not done yet
+		size_t waiting_for = 0;
+		bool skipped = false;
+		int64_t start = 0;
+		int64_t end = 0;
+	};
+
+	std::vector<Task> m_tasks;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<TaskId> m_ready;
+	std::deque<TaskId> m_main_ready;
+	size_t m_finished = 0;
+	//main thread tasks not finished yet, the calling thread keeps itself free for them until this hits zero
+	size_t m_main_remaining = 0;
+	std::exception_ptr m_exception;
+
+	//runs tasks until the graph is done, returns when there is nothing left
+	void work(bool main_thread);
+	void execute(TaskId id);
+	//marks the task and everything depending on it as done without running them
+	void skip(TaskId id);
+	//hands the dependents of a finished task out once they have nothing to wait for, expects the lock
+	void release_dependents(TaskId id);
+	void push_ready(TaskId id);
+};
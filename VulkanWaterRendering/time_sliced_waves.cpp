@@ -0,0 +1,165 @@
+#include "time_sliced_waves.hpp"
+
+TimeSlicedWaves::TimeSlicedWaves(Ocean *ocean, uint32_t budget_microseconds) : m_ocean(ocean), m_resolution(ocean->resolution), m_budget(budget_microseconds)
+{
+	for (uint32_t y = 0; y < m_resolution; y += CHUNK_SIZE)
+	{
+		for (uint32_t x = 0; x < m_resolution; x += CHUNK_SIZE)
+		{
+			Chunk chunk = {};
+			chunk.x = x;
+			chunk.y = y;
+			chunk.width = std::min(CHUNK_SIZE, m_resolution - x);
+			chunk.height = std::min(CHUNK_SIZE, m_resolution - y);
+			m_chunks.push_back(chunk);
+		}
+	}
+	size_t vertex_count = static_cast<size_t>(m_resolution) * m_resolution;
+	m_from.resize(vertex_count);
+	m_to.resize(vertex_count);
+}
+
+void TimeSlicedWaves::update(float time, float delta_time, const WaveLod &lod, std::vector<Displacement> &displacements)
+{
+	PROFILE_FUNCTION();
+	auto start = std::chrono::high_resolution_clock::now();
+	//the first frame has no length yet
+	if (delta_time <= 0.0f)
+		delta_time = 1.0f / 60.0f;
+
+	//the water moves across the screen slower the further away it is, a chunk twice as far as the nearest one
+	//can wait twice as long for the same movement in pixels
+	std::vector<float> distances(m_chunks.size());
+	float nearest = std::numeric_limits<float>::max();
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		const Chunk &chunk = m_chunks[i];
+		glm::vec3 center(chunk.x + 0.5f * chunk.width, chunk.y + 0.5f * chunk.height, 0.0f);
+		distances[i] = glm::length(center - lod.camera);
+		nearest = std::min(nearest, distances[i]);
+	}
+	nearest = std::max(nearest, 1.0f);
+
+	//a chunk costs one evaluation every interval frames, if that does not fit the budget at the measured cost
+	//the intervals start closer to the camera, down to every chunk at the longest interval
+	float reach = nearest;
+	while (true)
+	{
+		float evaluations = 0.0f;
+		bool stretched = true;
+		for (size_t i = 0; i < m_chunks.size(); i++)
+		{
+			Chunk &chunk = m_chunks[i];
+			chunk.interval = 1;
+			while (chunk.interval < MAX_INTERVAL && distances[i] >= 2.0f * chunk.interval * reach)
+				chunk.interval *= 2;
+			evaluations += 1.0f / chunk.interval;
+			stretched = stretched && chunk.interval == MAX_INTERVAL;
+		}
+		//a chunk the camera is right above stays at every frame
+		if (m_evaluation_cost <= 0.0f || evaluations * m_evaluation_cost <= m_budget.count() || stretched || reach < 1.0f / MAX_INTERVAL)
+			break;
+		reach *= 0.5f;
+	}
+
+	std::vector<size_t> due;
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		Chunk &chunk = m_chunks[i];
+		//never simulated chunks have nothing to show, the nearest ones come next, then the ones furthest behind
+		if (!chunk.simulated)
+			chunk.priority = std::numeric_limits<float>::max();
+		else if (chunk.interval == 1)
+			chunk.priority = std::numeric_limits<float>::max() / 2.0f;
+		else
+			chunk.priority = (time + delta_time - chunk.to_time) / (chunk.interval * delta_time);
+
+		//due once the next frame would be past the last result, or if it came closer and waits too long now
+		if (!chunk.simulated || time + delta_time > chunk.to_time || chunk.to_time - time > 1.5f * chunk.interval * delta_time)
+			due.push_back(i);
+	}
+	std::sort(due.begin(), due.end(), [this](size_t a, size_t b) { return m_chunks[a].priority > m_chunks[b].priority; });
+
+	m_updated_chunk_count = 0;
+	for (size_t i : due)
+	{
+		Chunk &chunk = m_chunks[i];
+		//the first frame simulates everything, after that a chunk only goes if its measured cost still fits,
+		//one that misses its turn keeps extrapolating and then stands still until there is time for it,
+		//the first one always goes, so a budget below a single chunk still moves the water
+		uint32_t evaluations = (!chunk.simulated || chunk.interval == 1 ? 1 : 0) + (chunk.interval > 1 ? 1 : 0);
+		auto chunk_start = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<float, std::micro> elapsed = chunk_start - start;
+		if (chunk.simulated && m_updated_chunk_count > 0 && elapsed.count() + evaluations * m_evaluation_cost > m_budget.count())
+			break;
+		simulate(chunk, time, delta_time, lod);
+		m_updated_chunk_count++;
+
+		std::chrono::duration<float, std::micro> cost = std::chrono::high_resolution_clock::now() - chunk_start;
+		float evaluation_cost = cost.count() / evaluations;
+		m_evaluation_cost = m_evaluation_cost <= 0.0f ? evaluation_cost : 0.9f * m_evaluation_cost + 0.1f * evaluation_cost;
+	}
+
+	displacements.resize(m_from.size());
+	for (const Chunk &chunk : m_chunks)
+	{
+		blend(chunk, time, displacements.data());
+	}
+}
+
+void TimeSlicedWaves::simulate(Chunk &chunk, float time, float delta_time, const WaveLod &lod)
+{
+	//the next stretch starts where the water is shown now, so switching stretches does not jump,
+	//the nearest chunks and new ones start from the exact waves instead
+	if (chunk.simulated && chunk.interval > 1)
+	{
+		blend(chunk, time, m_from.data());
+	}
+	else
+	{
+		for (uint32_t y = chunk.y; y < chunk.y + chunk.height; y++)
+		{
+			size_t first = static_cast<size_t>(y) * m_resolution + chunk.x;
+			std::fill(m_from.begin() + first, m_from.begin() + first + chunk.width, Displacement{});
+		}
+		m_ocean->update_waves(time, lod, chunk.x, chunk.y, chunk.width, chunk.height, m_from.data());
+	}
+	chunk.from_time = time;
+	chunk.to_time = time;
+	chunk.simulated = true;
+	if (chunk.interval == 1)
+		return;
+
+	chunk.to_time = time + chunk.interval * delta_time;
+	for (uint32_t y = chunk.y; y < chunk.y + chunk.height; y++)
+	{
+		size_t first = static_cast<size_t>(y) * m_resolution + chunk.x;
+		std::fill(m_to.begin() + first, m_to.begin() + first + chunk.width, Displacement{});
+	}
+	m_ocean->update_waves(chunk.to_time, lod, chunk.x, chunk.y, chunk.width, chunk.height, m_to.data());
+}
+
+//past the last result it keeps going in a straight line for one more stretch at most, then waits
+void TimeSlicedWaves::blend(const Chunk &chunk, float time, Displacement *displacements)
+{
+	bool exact = chunk.to_time <= chunk.from_time;
+	float t = exact ? 0.0f : std::min(std::max((time - chunk.from_time) / (chunk.to_time - chunk.from_time), 0.0f), 2.0f);
+	for (uint32_t y = chunk.y; y < chunk.y + chunk.height; y++)
+	{
+		size_t first = static_cast<size_t>(y) * m_resolution + chunk.x;
+		for (size_t i = first; i < first + chunk.width; i++)
+		{
+			displacements[i].displacement = m_from[i].displacement + (m_to[i].displacement - m_from[i].displacement) * t;
+		}
+	}
+}
+
+uint32_t TimeSlicedWaves::get_updated_chunk_count() const
+{
+	return m_updated_chunk_count;
+}
+
+uint32_t TimeSlicedWaves::get_chunk_count() const
+{
+	return static_cast<uint32_t>(m_chunks.size());
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include "ocean.hpp"
+#include "profiler.hpp"
+
+//Spreads the cpu wave simulation over several frames.
+//The grid is split into chunks, the chunks closest to the camera are simulated every frame, one twice as far every
+//2nd frame, then every 4th and 8th, which keeps how far the water moves on screen between updates about the same.
+//A chunk is simulated ahead of time and in between the frames show a blend of its last two results, so the water
+//keeps moving smoothly instead of stepping. The chunks that are due go nearest first, as long as their measured cost
+//fits the frame budget, at least one goes every frame. If the chunks would not fit at these intervals, the intervals
+//start closer to the camera until they do, or until every chunk waits the longest interval, then the furthest ones are
+//left standing until there is time for them.
+//Only the first frame simulates every chunk regardless of the budget.
+//The budget covers the scheduling and the wave sums, not the rest of the frame: the blend and the upload of the
+//displacement buffer still touch every vertex each frame, the blend because every chunk between two updates moves.
+//Both are a lerp or a copy instead of the whole wave sum, so the frame time grows far slower than the simulated area,
+//but it grows.
+//A flat one would need the blend on the gpu and only the simulated chunks uploaded.
+class TimeSlicedWaves
+{
+public:
+	static const uint32_t CHUNK_SIZE = 32;
+	//the longest interval a chunk is given between updates
+	static const uint32_t MAX_INTERVAL = 8;
+
+	//budget in microseconds per frame for simulating chunks
+	TimeSlicedWaves(Ocean *ocean, uint32_t budget_microseconds);
+
+	//writes the displacement for the given time into displacements, every vertex is overwritten,
+	//delta_time is the length of the last frame and guesses the next ones
+	void update(float time, float delta_time, const WaveLod &lod, std::vector<Displacement> &displacements);
+
+	//chunks simulated in the last update, out of all of them
+	uint32_t get_updated_chunk_count() const;
+	uint32_t get_chunk_count() const;
+
+private:
+	struct Chunk
+	{
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+		uint32_t height;
+		//the displacement in m_from is at from_time, the one in m_to at to_time
+		float from_time = 0.0f;
+		float to_time = 0.0f;
+		bool simulated = false;
+		//frames between updates and how urgent the next one is, worked out every update
+		uint32_t interval = 1;
+		float priority = 0.0f;
+	};
+
+	Ocean *m_ocean;
+	uint32_t m_resolution;
+	std::chrono::microseconds m_budget;
+	//microseconds the wave sum of one chunk took, averaged over the last updates, 0 until the first one
+	float m_evaluation_cost = 0.0f;
+	std::vector<Chunk> m_chunks;
+	uint32_t m_updated_chunk_count = 0;
+
+	std::vector<Displacement> m_from;
+	std::vector<Displacement> m_to;
+
+	//simulates the chunk ahead to the time its next update is due
+	void simulate(Chunk &chunk, float time, float delta_time, const WaveLod &lod);
+	//writes the blend of the last two results of the chunk for the given time into displacements, which may be m_from
+	void blend(const Chunk &chunk, float time, Displacement *displacements);
+};
@@ -0,0 +1,223 @@
+#include "upload_batcher.hpp"
+
+//creates the command pool on the transfer queue family and the objects used to signal completion
+void UploadBatcher::initialize(VkDevice logical_device, MemoryAllocator *allocator, uint32_t transfer_family, VkQueue transfer_queue)
+{
+	info("Initializing upload batcher...");
+	m_logical_device = logical_device;
+	m_transfer_queue = transfer_queue;
+	m_staging_arena.initialize(logical_device, allocator);
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.queueFamilyIndex = transfer_family;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	if (vkCreateCommandPool(m_logical_device, &command_pool_create_info, nullptr, &m_command_pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create transfer command pool");
+	}
+
+	VkCommandBufferAllocateInfo command_buffer_allocate_info = {};
+	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocate_info.commandPool = m_command_pool;
+	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	command_buffer_allocate_info.commandBufferCount = 1;
+
+	if (vkAllocateCommandBuffers(m_logical_device, &command_buffer_allocate_info, &m_command_buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Transfer command buffer allocation failed");
+	}
+
+	VkFenceCreateInfo fence_create_info = {};
+	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	if (vkCreateFence(m_logical_device, &fence_create_info, nullptr, &m_fence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Transfer fence creation failed");
+	}
+	create_semaphore();
+	succ("Upload batcher initialized");
+}
+
+//waits for outstanding transfers and destroys everything the batcher owns
+void UploadBatcher::destroy()
+{
+	//never initialized
+	if (m_logical_device == VK_NULL_HANDLE)
+		return;
+
+	wait();
+	m_staging_arena.destroy();
+	vkDestroySemaphore(m_logical_device, m_semaphore, nullptr);
+	vkDestroyFence(m_logical_device, m_fence, nullptr);
+	vkDestroyCommandPool(m_logical_device, m_command_pool, nullptr);
+}
+
+//stages the data and records a buffer to buffer copy
+void UploadBatcher::upload_buffer(const void *data, VkDeviceSize size, VkBuffer dst_buffer, VkDeviceSize dst_offset)
+{
+	begin_recording();
+
+	StagingRegion staging_region = m_staging_arena.allocate(size);
+	memcpy(staging_region.mapped, data, static_cast<size_t>(size));
+
+	VkBufferCopy copy_region = {};
+	copy_region.srcOffset = staging_region.offset;
+	copy_region.dstOffset = dst_offset;
+	copy_region.size = size;
+	vkCmdCopyBuffer(m_command_buffer, staging_region.buffer, dst_buffer, 1, &copy_region);
+	m_copy_count++;
+}
+
+//stages the data and records the transitions and the copy into the image
+void UploadBatcher::upload_image(const void *data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height)
+{
+	begin_recording();
+
+	//image copies want the texel size as alignment, 16 covers every format we use
+	StagingRegion staging_region = m_staging_arena.allocate(size, 16);
+	memcpy(staging_region.mapped, data, static_cast<size_t>(size));
+
+	VkImageMemoryBarrier image_memory_barrier = {};
+	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_memory_barrier.image = image;
+	image_memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_memory_barrier.subresourceRange.baseMipLevel = 0;
+	image_memory_barrier.subresourceRange.levelCount = 1;
+	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
+	image_memory_barrier.subresourceRange.layerCount = 1;
+
+	//get the image ready to be copied to
+	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_memory_barrier.srcAccessMask = 0;
+	image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(m_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = staging_region.offset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { width, height, 1 };
+	vkCmdCopyBufferToImage(m_command_buffer, staging_region.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	//a transfer queue knows no shader stages, the semaphore makes the write visible to the graphics queue
+	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	image_memory_barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(m_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+	m_copy_count++;
+}
+
+//submits all recorded copies as one batch
+void UploadBatcher::submit()
+{
+	PROFILE_FUNCTION();
+	if (!m_recording)
+		return;
+
+	info("Submitting ", m_copy_count, " uploads...");
+	if (vkEndCommandBuffer(m_command_buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Transfer command buffer recording failed");
+	}
+
+	//a signaled semaphore nobody waited on can not be signaled again, so swap it for a fresh one
+	if (m_semaphore_pending)
+	{
+		vkDestroySemaphore(m_logical_device, m_semaphore, nullptr);
+		create_semaphore();
+	}
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &m_command_buffer;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores = &m_semaphore;
+
+	vkResetFences(m_logical_device, 1, &m_fence);
+	if (vkQueueSubmit(m_transfer_queue, 1, &submit_info, m_fence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Upload submission failed");
+	}
+
+	m_recording = false;
+	m_in_flight = true;
+	m_semaphore_pending = true;
+	m_copy_count = 0;
+	succ("Uploads submitted");
+}
+
+//looks at the fence without waiting
+bool UploadBatcher::poll()
+{
+	if (m_in_flight && vkGetFenceStatus(m_logical_device, m_fence) == VK_SUCCESS)
+	{
+		//nothing reads from the staging memory anymore
+		m_staging_arena.reset();
+		m_in_flight = false;
+	}
+	return !m_in_flight;
+}
+
+//blocks until the last batch is done
+void UploadBatcher::wait()
+{
+	if (!m_in_flight)
+		return;
+
+	vkWaitForFences(m_logical_device, 1, &m_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	poll();
+}
+
+//hands out the semaphore of the last batch exactly once
+VkSemaphore UploadBatcher::take_pending_semaphore()
+{
+	if (!m_semaphore_pending)
+		return VK_NULL_HANDLE;
+
+	m_semaphore_pending = false;
+	return m_semaphore;
+}
+
+//starts a new batch if none is being recorded
+void UploadBatcher::begin_recording()
+{
+	if (m_recording)
+		return;
+
+	//the command buffer and staging memory of the last batch have to be released first
+	wait();
+
+	vkResetCommandBuffer(m_command_buffer, 0);
+
+	VkCommandBufferBeginInfo command_buffer_begin_info = {};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(m_command_buffer, &command_buffer_begin_info);
+	m_recording = true;
+}
+
+//creates the semaphore the graphics queue waits on
+void UploadBatcher::create_semaphore()
+{
+	VkSemaphoreCreateInfo semaphore_create_info = {};
+	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	if (vkCreateSemaphore(m_logical_device, &semaphore_create_info, nullptr, &m_semaphore) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Transfer semaphore creation failed");
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdexcept>
+#include <limits>
+#include <cstring>
+
+#include <vulkan/vulkan.h>
+
+#include "logger.hpp"
+#include "memory_allocator.hpp"
+#include "profiler.hpp"
+
+//Collects uploads into a single command buffer and submits them in one go.
+//If the device has a dedicated transfer queue the copies run there, next to rendering.
+//Completion is signaled with a fence for the cpu and a semaphore for the graphics queue,
+//so the caller can keep initializing while the data is on its way.
+class UploadBatcher
+{
+public:
+	void initialize(VkDevice logical_device, MemoryAllocator *allocator, uint32_t transfer_family, VkQueue transfer_queue);
+	void destroy();
+
+	//copies data into staging memory and records a copy into the buffer
+	void upload_buffer(const void *data, VkDeviceSize size, VkBuffer dst_buffer, VkDeviceSize dst_offset = 0);
+	//copies data into staging memory and records the copy into mip level 0 of the image
+	//the image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void upload_image(const void *data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height);
+
+	//submits everything recorded since the last submit
+	void submit();
+	//checks the fence without blocking, releases the staging memory once the transfers are done
+	bool poll();
+	//blocks until the last submission is done
+	void wait();
+
+	//the semaphore of the last submission if nobody waited on it yet, VK_NULL_HANDLE otherwise
+	//whoever takes it has to wait on it in their next queue submission
+	VkSemaphore take_pending_semaphore();
+
+private:
+	VkDevice m_logical_device = VK_NULL_HANDLE;
+	VkQueue m_transfer_queue = VK_NULL_HANDLE;
+	VkCommandPool m_command_pool = VK_NULL_HANDLE;
+	VkCommandBuffer m_command_buffer = VK_NULL_HANDLE;
+	VkFence m_fence = VK_NULL_HANDLE;
+	VkSemaphore m_semaphore = VK_NULL_HANDLE;
+
+	StagingArena m_staging_arena;
+
+	//commands have been recorded but not submitted
+	bool m_recording = false;
+	//a submission has been made and its fence was not seen signaled yet
+	bool m_in_flight = false;
+	//the semaphore was signaled and has not been handed out
+	bool m_semaphore_pending = false;
+	uint32_t m_copy_count = 0;
+
+	void begin_recording();
+	void create_semaphore();
+};
@@ -0,0 +1,97 @@
+#include "wave_spectrum.hpp"
+
+//the constants come from the fits of Pierson & Moskowitz (1964) and Hasselmann et al. (1973)
+WaveSpectrum::WaveSpectrum(const SpectrumParameters &parameters) : m_parameters(parameters)
+{
+	float wind_speed = std::max(parameters.wind_speed, 0.1f);
+	if (parameters.type == SpectrumType::jonswap)
+	{
+		//a short fetch gives a younger, steeper sea with a sharper peak
+		float fetch = std::max(parameters.fetch, 1.0f);
+		m_alpha = 0.076f * powf(wind_speed * wind_speed / (fetch * g), 0.22f);
+		m_peak_frequency = 22.0f * powf(g * g / (wind_speed * fetch), 1.0f / 3.0f);
+		m_gamma = 3.3f;
+	}
+	else
+	{
+		//a fully developed sea
+		m_alpha = 0.0081f;
+		m_peak_frequency = 0.855f * g / wind_speed;
+		m_gamma = 1.0f;
+	}
+}
+
+float WaveSpectrum::get_density(float omega) const
+{
+	if (omega <= 0.0f)
+		return 0.0f;
+
+	float ratio = m_peak_frequency / omega;
+	float density = m_alpha * g * g / powf(omega, 5.0f) * expf(-1.25f * ratio * ratio * ratio * ratio);
+
+	//jonswap boosts the energy around the peak, more so above it
+	if (m_gamma != 1.0f)
+	{
+		float sigma = omega <= m_peak_frequency ? 0.07f : 0.09f;
+		float distance = (omega - m_peak_frequency) / (sigma * m_peak_frequency);
+		density *= powf(m_gamma, expf(-0.5f * distance * distance));
+	}
+	return density;
+}
+
+float WaveSpectrum::get_peak_frequency() const
+{
+	return m_peak_frequency;
+}
+
+//deep water waves have w^2 = g * K, with K = 2PI / wavelength
+std::vector<Gerstner> WaveSpectrum::sample(uint32_t wave_count, float shortest_wavelength, float longest_wavelength) const
+{
+	std::vector<Gerstner> waves;
+	if (wave_count == 0)
+		return waves;
+
+	//below half the peak and above a few times of it there is hardly any energy left
+	float lowest_frequency = std::max(0.5f * m_peak_frequency, sqrtf(2.0f * PI * g / longest_wavelength));
+	float highest_frequency = std::min(6.0f * m_peak_frequency, sqrtf(2.0f * PI * g / shortest_wavelength));
+	if (highest_frequency <= lowest_frequency)
+	{
+		warn("The grid can not show the waves of this spectrum well, the wind is too strong or too weak for it");
+		highest_frequency = 2.0f * lowest_frequency;
+	}
+
+	std::mt19937 generator(m_parameters.seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	float band_width = (highest_frequency - lowest_frequency) / wave_count;
+	waves.reserve(wave_count);
+	for (uint32_t i = 0; i < wave_count; i++)
+	{
+		//jittered inside the band, evenly spaced frequencies would repeat after a while
+		float omega = lowest_frequency + (i + unit(generator)) * band_width;
+		float amplitude = sqrtf(2.0f * get_density(omega) * band_width);
+		float wavelength = 2.0f * PI * g / (omega * omega);
+		float K = 2.0f * PI / wavelength;
+
+		float angle = m_parameters.wind_direction + sample_direction(generator);
+		glm::vec2 direction(cosf(angle), sinf(angle));
+
+		//split the choppiness, so the waves together do not loop
+		float steepness = amplitude > 0.0f ? m_parameters.choppiness / (K * amplitude * wave_count) : 0.0f;
+		waves.push_back(Gerstner(direction, amplitude, wavelength, steepness, 2.0f * PI * unit(generator)));
+	}
+	return waves;
+}
+
+//rejection sampling of cos^2s(theta / 2), which is 1 along the wind and 0 against it
+float WaveSpectrum::sample_direction(std::mt19937 &generator) const
+{
+	std::uniform_real_distribution<float> angle(-PI, PI);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	while (true)
+	{
+		float theta = angle(generator);
+		if (unit(generator) <= powf(cosf(0.5f * theta), 2.0f * m_parameters.spread))
+			return theta;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include "gerstner_waves.hpp"
+#include "logger.hpp"
+
+//Which spectrum the waves of the ocean are sampled from, none keeps the handpicked waves
+enum class SpectrumType
+{
+	none,
+	pierson_moskowitz,
+	jonswap
+};
+
+//The sea state the spectrum describes, lengths are in grid cells, which the ocean treats as meters
+struct SpectrumParameters
+{
+	SpectrumType type = SpectrumType::none;
+	//meters per second, measured 10 meters above the sea
+	float wind_speed = 10.0f;
+	//radians, 0 blows along x
+	float wind_direction = 0.0f;
+	//meters of open water the wind blew over, only jonswap looks at it, pierson moskowitz assumes it is unlimited
+	float fetch = 100000.0f;
+	//exponent of the cos^2s spreading function, higher keeps the waves closer to the wind direction
+	float spread = 4.0f;
+	//how sharp the crests get, the steepness of all waves adds up to this, above 1 they loop
+	float choppiness = 0.7f;
+	//the same seed gives the same waves, so runs stay comparable
+	uint32_t seed = 1;
+};
+
+//A directional ocean spectrum, energy over angular frequency times a spreading over the angle to the wind.
+//Sampling splits the frequency range into one band per wave, every wave gets the energy of its band.
+class WaveSpectrum
+{
+public:
+	WaveSpectrum(const SpectrumParameters &parameters);
+
+	//energy density S(w) in m^2 s at the angular frequency w
+	float get_density(float omega) const;
+	//angular frequency with the most energy
+	float get_peak_frequency() const;
+
+	//samples waves between the given wavelengths, the shortest should span a few grid cells or it aliases
+	std::vector<Gerstner> sample(uint32_t wave_count, float shortest_wavelength, float longest_wavelength) const;
+
+private:
+	SpectrumParameters m_parameters;
+	float m_alpha;
+	float m_peak_frequency;
+	//peak enhancement, 1 turns jonswap into pierson moskowitz
+	float m_gamma;
+
+	const float g = 9.81f;
+	const float PI = 3.14159265f;
+
+	//draws an angle relative to the wind from the spreading function
+	float sample_direction(std::mt19937 &generator) const;
+};